@@ -0,0 +1,163 @@
+#include "Benchmark.hpp"
+
+#include "io/Token.hpp"
+#include "io/TokenStreamReader.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+
+using namespace std;
+
+
+namespace blank {
+namespace bench {
+
+Registry &Registry::Get() {
+	static Registry registry;
+	return registry;
+}
+
+void Registry::Add(const string &name, Factory factory) {
+	if (!entries.emplace(name, move(factory)).second) {
+		throw runtime_error("duplicate benchmark " + name);
+	}
+}
+
+
+namespace {
+
+double MedianOfSorted(const vector<double> &v) noexcept {
+	if (v.empty()) {
+		return 0.0;
+	}
+	const size_t half = v.size() / 2;
+	return v.size() % 2 ? v[half] : (v[half - 1] + v[half]) * 0.5;
+}
+
+}
+
+void Result::Evaluate() {
+	sort(samples.begin(), samples.end());
+	median = MedianOfSorted(samples);
+	min = samples.empty() ? 0.0 : samples.front();
+	vector<double> deviations;
+	deviations.reserve(samples.size());
+	for (double s : samples) {
+		deviations.push_back(abs(s - median));
+	}
+	sort(deviations.begin(), deviations.end());
+	mad = MedianOfSorted(deviations);
+}
+
+
+Result Runner::Measure(const string &name, Benchmark &bench) const {
+	using clock = chrono::steady_clock;
+	const clock::duration target = chrono::milliseconds(sample_time);
+
+	auto sample = [&bench](size_t n) -> clock::duration {
+		bench.Reset();
+		const clock::time_point begin = clock::now();
+		bench.Run(n);
+		return clock::now() - begin;
+	};
+
+	Result result;
+	result.name = name;
+
+	// double the iterations until a sample takes long enough, this
+	// also serves as warmup for caches and branch predictors
+	size_t n = 1;
+	for (clock::duration d = sample(n); d < target; d = sample(n)) {
+		if (d < target / 8) {
+			n *= 8;
+		} else {
+			n *= 2;
+		}
+	}
+	result.iterations = n;
+	// one more, because the first ones after calibration tend to be off
+	sample(n);
+
+	result.samples.reserve(sample_count);
+	for (int i = 0; i < sample_count; ++i) {
+		const chrono::duration<double, nano> d = sample(n);
+		result.samples.push_back(d.count() / n);
+	}
+	result.Evaluate();
+	return result;
+}
+
+
+void WriteJSON(ostream &out, const vector<Result> &results) {
+	out << "{\n\t\"benchmarks\": {";
+	bool first = true;
+	for (const Result &r : results) {
+		out << (first ? "\n" : ",\n");
+		first = false;
+		out << "\t\t\"" << r.name << "\": {"
+			<< fixed << setprecision(3)
+			<< " \"median_ns\": " << r.median
+			<< ", \"mad_ns\": " << r.mad
+			<< ", \"min_ns\": " << r.min
+			<< ", \"iterations\": " << r.iterations
+			<< ", \"samples\": " << r.samples.size()
+			<< " }";
+	}
+	out << "\n\t}\n}\n";
+}
+
+vector<Result> ReadJSON(istream &in) {
+	// the token reader reads a superset of what WriteJSON() produces
+	const string text((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+	TokenStreamReader reader(text.data(), text.data() + text.size());
+
+	vector<Result> results;
+	string key;
+	reader.Skip(Token::ANGLE_BRACKET_OPEN);
+	reader.ReadString(key);
+	if (key != "benchmarks") {
+		throw runtime_error("expected \"benchmarks\", got \"" + key + '"');
+	}
+	reader.Skip(Token::COLON);
+	reader.Skip(Token::ANGLE_BRACKET_OPEN);
+	while (reader.Peek().type != Token::ANGLE_BRACKET_CLOSE) {
+		Result r;
+		reader.ReadString(r.name);
+		reader.Skip(Token::COLON);
+		reader.Skip(Token::ANGLE_BRACKET_OPEN);
+		while (reader.Peek().type != Token::ANGLE_BRACKET_CLOSE) {
+			reader.ReadString(key);
+			reader.Skip(Token::COLON);
+			if (key == "median_ns") {
+				r.median = reader.GetFloat();
+			} else if (key == "mad_ns") {
+				r.mad = reader.GetFloat();
+			} else if (key == "min_ns") {
+				r.min = reader.GetFloat();
+			} else if (key == "iterations") {
+				r.iterations = reader.GetULong();
+			} else {
+				// unknown field, skip its value
+				reader.Next();
+			}
+			if (reader.Peek().type == Token::COMMA) {
+				reader.Skip(Token::COMMA);
+			}
+		}
+		reader.Skip(Token::ANGLE_BRACKET_CLOSE);
+		results.push_back(move(r));
+		if (reader.Peek().type == Token::COMMA) {
+			reader.Skip(Token::COMMA);
+		}
+	}
+	reader.Skip(Token::ANGLE_BRACKET_CLOSE);
+	return results;
+}
+
+}
+}
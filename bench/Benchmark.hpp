@@ -0,0 +1,106 @@
+#ifndef BLANK_BENCH_BENCHMARK_HPP_
+#define BLANK_BENCH_BENCHMARK_HPP_
+
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace blank {
+namespace bench {
+
+/// A piece of code to time. Run() does the work n times in a row and
+/// the harness picks n so that one sample takes long enough to measure
+/// reliably. Setup that shouldn't be timed goes in the constructor, or
+/// in Reset() if it has to be redone before every sample.
+class Benchmark {
+
+public:
+	virtual ~Benchmark() { }
+
+	virtual void Reset() { }
+	virtual void Run(std::size_t n) = 0;
+
+};
+
+/// keep the compiler from optimizing away the computation of value
+template<class T>
+inline void Use(const T &value) noexcept {
+	asm volatile("" : : "r"(&value) : "memory");
+}
+
+
+/// all benchmarks linked into the binary, by name
+class Registry {
+
+public:
+	using Factory = std::function<std::unique_ptr<Benchmark>()>;
+
+	static Registry &Get();
+
+	void Add(const std::string &name, Factory);
+	const std::map<std::string, Factory> &Entries() const noexcept { return entries; }
+
+private:
+	std::map<std::string, Factory> entries;
+
+};
+
+/// put a static one of these next to the benchmark to register it
+/// names are "<module>.<what>", e.g. "rand.simplex"
+template<class T>
+struct Registration {
+	explicit Registration(const std::string &name) {
+		Registry::Get().Add(name, []() { return std::unique_ptr<Benchmark>(new T); });
+	}
+};
+
+
+/// timings of one benchmark, all in nanoseconds per iteration
+struct Result {
+
+	std::string name;
+	/// iterations per sample
+	std::size_t iterations = 0;
+	std::vector<double> samples;
+
+	double median = 0.0;
+	/// median absolute deviation from the median
+	double mad = 0.0;
+	double min = 0.0;
+
+	/// sort samples and calculate median, mad, and min from them
+	void Evaluate();
+
+	/// mad relative to the median
+	double Spread() const noexcept { return median > 0.0 ? mad / median : 0.0; }
+
+};
+
+/// runs benchmarks and takes samples
+class Runner {
+
+public:
+	/// minimum duration of a sample in milliseconds
+	int sample_time = 20;
+	/// number of samples taken after one discarded warmup sample
+	int sample_count = 15;
+
+	Result Measure(const std::string &name, Benchmark &) const;
+
+};
+
+/// write results in JSON, keyed by name
+void WriteJSON(std::ostream &, const std::vector<Result> &);
+/// read results written by WriteJSON(), samples are not included
+/// @throws std::runtime_error on malformed input
+std::vector<Result> ReadJSON(std::istream &);
+
+}
+}
+
+#endif
@@ -0,0 +1,125 @@
+#include "Benchmark.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace blank::bench;
+using namespace std;
+
+
+namespace {
+
+const char *Arg(int argc, char **argv, int &i) {
+	if (i + 1 >= argc || argv[i + 1][0] == '\0') {
+		throw runtime_error(string("missing argument to ") + argv[i]);
+	}
+	return argv[++i];
+}
+
+}
+
+int main(int argc, char **argv) {
+	Runner runner;
+	string filter;
+	string save_path;
+	string compare_path;
+	// regressions smaller than this are never reported, in percent
+	double threshold = 5.0;
+
+	try {
+		for (int i = 1; i < argc; ++i) {
+			if (strcmp(argv[i], "--filter") == 0) {
+				filter = Arg(argc, argv, i);
+			} else if (strcmp(argv[i], "--samples") == 0) {
+				runner.sample_count = max(1, atoi(Arg(argc, argv, i)));
+			} else if (strcmp(argv[i], "--time") == 0) {
+				runner.sample_time = max(1, atoi(Arg(argc, argv, i)));
+			} else if (strcmp(argv[i], "--save") == 0) {
+				save_path = Arg(argc, argv, i);
+			} else if (strcmp(argv[i], "--compare") == 0) {
+				compare_path = Arg(argc, argv, i);
+			} else if (strcmp(argv[i], "--threshold") == 0) {
+				threshold = atof(Arg(argc, argv, i));
+			} else {
+				throw runtime_error(string("unknown argument ") + argv[i]);
+			}
+		}
+	} catch (exception &e) {
+		cerr << e.what() << endl;
+		cerr << "usage: " << argv[0] << " [--filter <substring>] [--samples <n>] [--time <ms>]"
+			" [--save <file>] [--compare <file>] [--threshold <percent>]" << endl;
+		return 1;
+	}
+
+	map<string, Result> baseline;
+	if (!compare_path.empty()) {
+		ifstream in(compare_path);
+		if (!in) {
+			cerr << "unable to open baseline " << compare_path << endl;
+			return 1;
+		}
+		try {
+			for (Result &r : ReadJSON(in)) {
+				baseline[r.name] = r;
+			}
+		} catch (exception &e) {
+			cerr << "bad baseline " << compare_path << ": " << e.what() << endl;
+			return 1;
+		}
+	}
+
+	vector<Result> results;
+	int regressions = 0;
+	for (const auto &entry : Registry::Get().Entries()) {
+		if (entry.first.find(filter) == string::npos) {
+			continue;
+		}
+		Result r;
+		{
+			unique_ptr<Benchmark> bench(entry.second());
+			r = runner.Measure(entry.first, *bench);
+		}
+		cout << left << setw(24) << r.name << right << fixed
+			<< setw(12) << setprecision(1) << r.median << " ns/op"
+			<< "  ±" << setw(4) << setprecision(1) << (r.Spread() * 100.0) << '%'
+			<< "  (" << r.samples.size() << " x " << r.iterations << ')';
+		auto base = baseline.find(r.name);
+		if (base != baseline.end() && base->second.median > 0.0) {
+			const double change = (r.median - base->second.median) / base->second.median * 100.0;
+			// anything within the combined noise of both runs is no change
+			const double noise = 300.0 * (r.mad + base->second.mad) / base->second.median;
+			cout << "  " << showpos << setprecision(1) << change << '%' << noshowpos;
+			if (change > max(threshold, noise)) {
+				cout << "  REGRESSION";
+				++regressions;
+			} else if (-change > max(threshold, noise)) {
+				cout << "  faster";
+			}
+		} else if (!baseline.empty()) {
+			cout << "  new";
+		}
+		cout << endl;
+		results.push_back(move(r));
+	}
+
+	if (!save_path.empty()) {
+		ofstream out(save_path);
+		WriteJSON(out, results);
+		if (!out) {
+			cerr << "unable to write " << save_path << endl;
+			return 1;
+		}
+	}
+	if (regressions > 0) {
+		cout << regressions << " regression(s) against " << compare_path << endl;
+		return 2;
+	}
+	return 0;
+}
@@ -0,0 +1,115 @@
+#include "../Benchmark.hpp"
+
+#include "io/Tokenizer.hpp"
+
+#include <sstream>
+#include <string>
+
+
+namespace blank {
+namespace bench {
+
+namespace {
+
+/// about 18KiB of block type definitions in the style of the assets,
+/// with comments, strings, identifiers, and lots of numbers
+std::string Document() {
+	std::ostringstream out;
+	for (int i = 0; i < 64; ++i) {
+		out << "# type number " << i << "\n"
+			"type_" << i << " = {\n"
+			"\tlabel = \"Type " << i << "\";\n"
+			"\tvisible = true;\n"
+			"\tluminosity = " << (i % 16) << ";\n"
+			"\thsl_mod = [ " << (i * 0.015625f) << ", 0.25, -0.5 ];\n"
+			"\trgb_mod = [ 1.0, 0.875, " << (1.0f - i * 0.0078125f) << " ];\n"
+			"\ttextures = [ \"stone\", \"grass_top\", \"dirt\" ];\n"
+			"\tshape = \"block\";\n"
+			"\tgenerate = true;\n"
+			"\tsolidity = { min = 0.5; mid = 0.75; max = 1.0; };\n"
+			"};\n";
+	}
+	return out.str();
+}
+
+/// lex the document once per iteration
+class TokenizerBench
+: public Benchmark {
+
+public:
+	TokenizerBench()
+	: text(Document()) { }
+
+protected:
+	static void Lex(Tokenizer &in) {
+		std::size_t count = 0;
+		while (in.HasMore()) {
+			in.Next();
+			++count;
+		}
+		Use(count);
+	}
+
+protected:
+	std::string text;
+
+};
+
+class StreamBench
+: public TokenizerBench {
+
+public:
+	void Run(std::size_t n) override {
+		for (std::size_t i = 0; i < n; ++i) {
+			std::istringstream stream(text);
+			Tokenizer in(stream);
+			Lex(in);
+		}
+	}
+
+};
+
+class TextBench
+: public TokenizerBench {
+
+public:
+	void Run(std::size_t n) override {
+		for (std::size_t i = 0; i < n; ++i) {
+			Tokenizer in(text.data(), text.data() + text.size());
+			Lex(in);
+		}
+	}
+
+};
+
+class CompiledBench
+: public TokenizerBench {
+
+public:
+	CompiledBench() {
+		std::istringstream in(text);
+		std::ostringstream out;
+		Tokenizer::Compile(in, out);
+		compiled = out.str();
+	}
+
+	void Run(std::size_t n) override {
+		for (std::size_t i = 0; i < n; ++i) {
+			Tokenizer in(compiled.data(), compiled.size());
+			Lex(in);
+		}
+	}
+
+private:
+	std::string compiled;
+
+};
+
+Registration<StreamBench> lex_stream("io.tokenizer.stream");
+Registration<TextBench> lex_text("io.tokenizer.text");
+Registration<CompiledBench> lex_compiled("io.tokenizer.compiled");
+
+}
+
+}
+}
@@ -0,0 +1,78 @@
+#include "../Benchmark.hpp"
+
+#include "geometry/const.hpp"
+#include "graphics/glm.hpp"
+#include "net/Packet.hpp"
+#include "world/EntityState.hpp"
+
+#include <glm/gtx/quaternion.hpp>
+
+
+namespace blank {
+namespace bench {
+
+namespace {
+
+/// packs and unpacks into the payload of a packet that lives as long
+/// as the benchmark
+class PayloadBench
+: public Benchmark {
+
+public:
+	PayloadBench()
+	: packet()
+	, payload{ Packet::MAX_PAYLOAD_LEN, packet.payload } { }
+
+protected:
+	Packet packet;
+	Packet::Payload payload;
+
+};
+
+/// round trip of the compressed orientation sent with every entity
+class QuatBench
+: public PayloadBench {
+
+public:
+	void Run(std::size_t n) override {
+		glm::quat in;
+		glm::quat out;
+		for (std::size_t i = 0; i < n; ++i) {
+			in = glm::angleAxis(float(i % 256) * (PI_2p0 / 256.0f), glm::normalize(glm::vec3(1.0f, 2.0f, 3.0f)));
+			payload.Write(in, 0);
+			payload.Read(out, 0);
+			Use(out);
+		}
+	}
+
+};
+
+/// round trip of a full entity state relative to a reference chunk,
+/// the bulk of player and entity update packets
+class StateBench
+: public PayloadBench {
+
+public:
+	void Run(std::size_t n) override {
+		const glm::ivec3 reference(3, -1, 2);
+		EntityState in;
+		EntityState out;
+		in.pos = ExactLocation(glm::ivec3(4, -1, 2), glm::vec3(3.5f, 7.25f, 12.0f));
+		in.velocity = glm::vec3(0.5f, -2.0f, 1.25f);
+		for (std::size_t i = 0; i < n; ++i) {
+			in.orient = glm::angleAxis(float(i % 256) * (PI_2p0 / 256.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+			payload.Write(in, reference, 0);
+			payload.Read(out, reference, 0);
+			Use(out);
+		}
+	}
+
+};
+
+Registration<QuatBench> quat("net.quat");
+Registration<StateBench> state("net.state");
+
+}
+
+}
+}
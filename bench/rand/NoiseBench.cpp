@@ -0,0 +1,55 @@
+#include "../Benchmark.hpp"
+
+#include "graphics/glm.hpp"
+#include "rand/SimplexNoise.hpp"
+#include "rand/WorleyNoise.hpp"
+
+
+namespace blank {
+namespace bench {
+
+namespace {
+
+/// samples along a line through a couple of chunks, roughly what the
+/// generator does when filling one
+template<class Noise>
+class NoiseBench
+: public Benchmark {
+
+public:
+	explicit NoiseBench(const Noise &noise)
+	: noise(noise) { }
+
+	void Run(std::size_t n) override {
+		glm::vec3 pos(0.5f, 1.25f, 2.75f);
+		const glm::vec3 step(0.37f, 0.11f, 0.23f);
+		float sum = 0.0f;
+		for (std::size_t i = 0; i < n; ++i) {
+			sum += noise(pos);
+			pos += step;
+		}
+		Use(sum);
+	}
+
+private:
+	Noise noise;
+
+};
+
+struct SimplexBench
+: public NoiseBench<SimplexNoise> {
+	SimplexBench() : NoiseBench(SimplexNoise(0x3a55d2ccb8d8e9f1)) { }
+};
+
+struct WorleyBench
+: public NoiseBench<WorleyNoise> {
+	WorleyBench() : NoiseBench(WorleyNoise(0x3a55d2cc)) { }
+};
+
+Registration<SimplexBench> simplex("rand.simplex");
+Registration<WorleyBench> worley("rand.worley");
+
+}
+
+}
+}
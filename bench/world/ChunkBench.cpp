@@ -0,0 +1,80 @@
+#include "../Benchmark.hpp"
+#include "CubeTypes.hpp"
+
+#include "graphics/BlockMesh.hpp"
+#include "world/Chunk.hpp"
+
+
+namespace blank {
+namespace bench {
+
+namespace {
+
+/// place a light source in a chunk full of air and remove it again,
+/// so each iteration floods and then unfloods the light
+class LightBench
+: public Benchmark {
+
+public:
+	LightBench()
+	: types()
+	, chunk(types.registry) { }
+
+	void Run(std::size_t n) override {
+		const RoughLocation::Fine center(Chunk::side / 2);
+		for (std::size_t i = 0; i < n; ++i) {
+			chunk.SetBlock(center, Block(types.light));
+			chunk.SetBlock(center, Block());
+		}
+		Use(chunk);
+	}
+
+private:
+	CubeTypes types;
+	Chunk chunk;
+
+};
+
+/// generate the mesh of a chunk filled in a checkerboard pattern, which
+/// leaves every face of every block exposed
+/// this is the part of remeshing a chunk that doesn't need a GL context
+class MeshBench
+: public Benchmark {
+
+public:
+	MeshBench()
+	: types()
+	, chunk(types.registry)
+	, buf() {
+		for (int z = 0; z < Chunk::side; ++z) {
+			for (int y = 0; y < Chunk::side; ++y) {
+				for (int x = 0; x < Chunk::side; ++x) {
+					if ((x + y + z) % 2 == 0) {
+						chunk.SetBlock(RoughLocation::Fine(x, y, z), Block(types.solid));
+					}
+				}
+			}
+		}
+	}
+
+	void Run(std::size_t n) override {
+		for (std::size_t i = 0; i < n; ++i) {
+			chunk.BuildMesh(buf, true);
+			Use(buf);
+		}
+	}
+
+private:
+	CubeTypes types;
+	Chunk chunk;
+	BlockMesh::Buffer buf;
+
+};
+
+Registration<LightBench> light("world.light");
+Registration<MeshBench> mesh("world.mesh");
+
+}
+
+}
+}
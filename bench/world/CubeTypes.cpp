@@ -0,0 +1,93 @@
+#include "CubeTypes.hpp"
+
+#include "graphics/glm.hpp"
+#include "io/TokenStreamReader.hpp"
+
+#include <sstream>
+
+using namespace std;
+
+
+namespace blank {
+namespace bench {
+
+namespace {
+
+void WriteVec(ostream &out, const glm::vec3 &v) {
+	out << "[ " << v.x << ", " << v.y << ", " << v.z << " ]";
+}
+
+/// a cube in the same notation as the shapes in the assets
+string CubeDefinition() {
+	const glm::vec3 normals[6] = {
+		{  0.0f,  1.0f,  0.0f },
+		{  0.0f, -1.0f,  0.0f },
+		{  1.0f,  0.0f,  0.0f },
+		{ -1.0f,  0.0f,  0.0f },
+		{  0.0f,  0.0f,  1.0f },
+		{  0.0f,  0.0f, -1.0f },
+	};
+	const glm::vec3 tangents[6] = {
+		{ 1.0f, 0.0f, 0.0f },
+		{ 1.0f, 0.0f, 0.0f },
+		{ 0.0f, 0.0f, 1.0f },
+		{ 0.0f, 0.0f, 1.0f },
+		{ 1.0f, 0.0f, 0.0f },
+		{ 1.0f, 0.0f, 0.0f },
+	};
+	const glm::vec2 corners[4] = {
+		{ -0.5f, -0.5f },
+		{  0.5f, -0.5f },
+		{  0.5f,  0.5f },
+		{ -0.5f,  0.5f },
+	};
+
+	ostringstream out;
+	out << "{ bounds = Cuboid([ -0.5, -0.5, -0.5 ], [ 0.5, 0.5, 0.5 ]); vertices = {";
+	for (int face = 0; face < 6; ++face) {
+		const glm::vec3 &n = normals[face];
+		const glm::vec3 &u = tangents[face];
+		const glm::vec3 v(glm::cross(n, u));
+		for (const glm::vec2 &c : corners) {
+			out << " { ";
+			WriteVec(out, n * 0.5f + u * c.x + v * c.y);
+			out << ", ";
+			WriteVec(out, n);
+			out << ", [ " << (c.x + 0.5f) << ", " << (c.y + 0.5f) << " ], 0 },";
+		}
+	}
+	out << " }; indices = {";
+	for (int face = 0; face < 6; ++face) {
+		const int base = face * 4;
+		out << ' ' << base << ", " << (base + 1) << ", " << (base + 2)
+			<< ", " << base << ", " << (base + 2) << ", " << (base + 3) << ',';
+	}
+	out << " }; fill = [ true, true, true, true, true, true ]; }";
+	return out.str();
+}
+
+}
+
+CubeTypes::CubeTypes()
+: cube()
+, registry()
+, solid(0)
+, light(0) {
+	const string definition(CubeDefinition());
+	TokenStreamReader in(definition.data(), definition.data() + definition.size());
+	cube.Read(in);
+
+	BlockType solid_type;
+	solid_type.name = "solid";
+	solid_type.shape = &cube;
+	solid = registry.Add(std::move(solid_type));
+
+	BlockType light_type;
+	light_type.name = "light";
+	light_type.shape = &cube;
+	light_type.luminosity = 5;
+	light = registry.Add(std::move(light_type));
+}
+
+}
+}
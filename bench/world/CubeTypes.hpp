@@ -0,0 +1,31 @@
+#ifndef BLANK_BENCH_WORLD_CUBETYPES_HPP_
+#define BLANK_BENCH_WORLD_CUBETYPES_HPP_
+
+#include "model/Shape.hpp"
+#include "world/BlockTypeRegistry.hpp"
+
+
+namespace blank {
+namespace bench {
+
+/// block types for world benchmarks that don't need any assets
+/// both are unit cubes with a full mesh, one of them glows
+struct CubeTypes {
+
+	Shape cube;
+	BlockTypeRegistry registry;
+
+	Block::Type solid;
+	Block::Type light;
+
+	CubeTypes();
+
+	CubeTypes(const CubeTypes &) = delete;
+	CubeTypes &operator =(const CubeTypes &) = delete;
+
+};
+
+}
+}
+
+#endif
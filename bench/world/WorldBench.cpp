@@ -0,0 +1,111 @@
+#include "../Benchmark.hpp"
+#include "CubeTypes.hpp"
+
+#include "geometry/const.hpp"
+#include "geometry/primitive.hpp"
+#include "world/Chunk.hpp"
+#include "world/ChunkIndex.hpp"
+#include "world/ChunkStore.hpp"
+#include "world/World.hpp"
+#include "world/WorldCollision.hpp"
+
+#include <cmath>
+#include <vector>
+#include <glm/gtx/transform.hpp>
+
+
+namespace blank {
+namespace bench {
+
+namespace {
+
+/// a 5x5x5 chunk world with flat ground halfway up the center chunk
+class WorldFixture
+: public Benchmark {
+
+public:
+	WorldFixture()
+	: types()
+	, world(types.registry, World::Config())
+	, index(world.Chunks().MakeIndex(ExactLocation::Coarse(0), 2)) {
+		for (int cz = -2; cz <= 2; ++cz) {
+			for (int cy = -2; cy <= 2; ++cy) {
+				for (int cx = -2; cx <= 2; ++cx) {
+					Chunk *chunk = world.Chunks().Allocate(ExactLocation::Coarse(cx, cy, cz));
+					Fill(*chunk, cy);
+				}
+			}
+		}
+	}
+	~WorldFixture() {
+		world.Chunks().UnregisterIndex(index);
+	}
+
+private:
+	void Fill(Chunk &chunk, int cy) {
+		Block *blocks = static_cast<Block *>(chunk.BlockData());
+		for (int i = 0; i < Chunk::size; ++i) {
+			const int y = Chunk::ToPos(i).y;
+			const bool solid = cy < 0 || (cy == 0 && y < Chunk::side / 2);
+			blocks[i] = solid ? Block(types.solid) : Block();
+		}
+		chunk.ScanActive();
+	}
+
+protected:
+	CubeTypes types;
+	World world;
+	ChunkIndex &index;
+
+};
+
+/// aim at the ground from above like a player would, sweeping the
+/// direction so consecutive rays don't all hit the same blocks
+class RayBench
+: public WorldFixture {
+
+public:
+	void Run(std::size_t n) override {
+		const ExactLocation::Coarse reference(0);
+		WorldCollision coll;
+		bool any = false;
+		for (std::size_t i = 0; i < n; ++i) {
+			const float angle = float(i % 64) * (PI_2p0 / 64.0f);
+			Ray ray{ glm::vec3(8.0f, 10.0f, 8.0f), glm::normalize(glm::vec3(std::cos(angle), -0.5f, std::sin(angle))), { } };
+			ray.Update();
+			any |= world.Intersection(ray, reference, coll);
+		}
+		Use(any);
+		Use(coll);
+	}
+
+};
+
+/// a player sized box sinking into the ground, as during collision
+/// response
+class BoxBench
+: public WorldFixture {
+
+public:
+	void Run(std::size_t n) override {
+		const AABB box{ { -0.4f, -0.9f, -0.4f }, { 0.4f, 0.9f, 0.4f } };
+		const glm::ivec3 reference(0);
+		std::vector<WorldCollision> col;
+		for (std::size_t i = 0; i < n; ++i) {
+			const float offset = float(i % 16) * 0.0625f;
+			const glm::mat4 M(glm::translate(glm::vec3(8.0f + offset, 8.5f, 8.0f - offset)));
+			col.clear();
+			world.Intersection(box, M, reference, col);
+			Use(col);
+		}
+	}
+
+};
+
+Registration<RayBench> ray("world.ray");
+Registration<BoxBench> box("world.box");
+
+}
+
+}
+}
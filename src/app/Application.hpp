@@ -8,6 +8,7 @@
 namespace blank {
 
 class Environment;
+class FixedRate;
 class HeadlessEnvironment;
 class State;
 class Window;
@@ -36,6 +37,8 @@ public:
 	void RunT(size_t t);
 	/// run for n frames, assuming t milliseconds for each
 	void RunS(size_t n, size_t t);
+	/// run until out of states, one frame per step of given rate
+	void RunFixed(FixedRate &);
 
 	/// process all events in SDL's queue
 	void HandleEvents();
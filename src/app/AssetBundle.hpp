@@ -0,0 +1,83 @@
+#ifndef BLANK_APP_ASSETBUNDLE_HPP_
+#define BLANK_APP_ASSETBUNDLE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+
+namespace blank {
+
+/// Binary form of an asset set: its data files as compiled tokens and
+/// the textures it references as decoded pixels. The file is memory
+/// mapped and read in place. It also records size and mtime of every
+/// source it was built from, so it can tell when it's gone stale.
+/// Bundles are only meant to be read on the machine type that wrote
+/// them, byte order and version are checked, but nothing's converted.
+class AssetBundle {
+
+public:
+	/// bump whenever the layout changes
+	static constexpr std::uint32_t version = 1;
+
+	/// ARGB8888 pixels, same as the default Format
+	struct Texture {
+		int width;
+		int height;
+		const void *pixels;
+	};
+
+public:
+	/// map the bundle at given path
+	/// @throws std::runtime_error if it can't be read or is malformed
+	explicit AssetBundle(const std::string &path);
+	~AssetBundle();
+
+	AssetBundle(const AssetBundle &) = delete;
+	AssetBundle &operator =(const AssetBundle &) = delete;
+
+	/// true if none of the sources under given asset base changed
+	bool Fresh(const std::string &base) const;
+
+	/// get compiled tokens of a data file, e.g. "default.types"
+	/// @return false if the bundle doesn't contain it
+	bool Data(const std::string &name, const void *&data, std::size_t &size) const noexcept;
+	/// get decoded pixels of a texture by name
+	/// @return nullptr if the bundle doesn't contain it
+	const Texture *GetTexture(const std::string &name) const noexcept;
+
+	/// build a bundle of given set from sources under base and write it
+	/// to path, SDL_image must be initialized for decoding textures
+	static void Write(const std::string &base, const std::string &set_name, const std::string &path);
+
+private:
+	struct Source {
+		std::string path;
+		std::uint64_t size;
+		std::int64_t mtime;
+	};
+	struct Section {
+		std::size_t offset;
+		std::size_t size;
+	};
+
+	void Map(const std::string &path);
+	void Parse();
+
+private:
+	const unsigned char *mem;
+	std::size_t mem_size;
+	/// fallback storage where mapping isn't available
+	std::vector<unsigned char> copy;
+
+	std::vector<Source> sources;
+	std::map<std::string, Section> data;
+	std::map<std::string, Texture> textures;
+
+};
+
+}
+
+#endif
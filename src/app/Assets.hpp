@@ -3,12 +3,15 @@
 
 #include "../graphics/Font.hpp"
 
+#include <cstddef>
+#include <memory>
 #include <string>
 
 
 namespace blank {
 
 class ArrayTexture;
+class AssetBundle;
 class BlockTypeRegistry;
 class CubeMap;
 class ModelRegistry;
@@ -22,6 +25,12 @@ class AssetLoader {
 public:
 	explicit AssetLoader(const std::string &base);
 
+	/// use the precompiled bundle of given set for block types, models,
+	/// shapes, and textures from now on, if there is a fresh one
+	/// @return false if it's missing, stale, or broken, in which case
+	///         everything's loaded from the sources as usual
+	bool OpenBundle(const std::string &set_name);
+
 	void LoadBlockTypes(
 		const std::string &set_name,
 		BlockTypeRegistry &,
@@ -42,11 +51,18 @@ public:
 	void LoadTextures(const ResourceIndex &, ArrayTexture &) const;
 
 private:
+	/// try to find the named data file in the bundle
+	bool BundleData(const std::string &name, const void *&data, std::size_t &size) const noexcept;
+
+private:
+	std::string base;
 	std::string fonts;
 	std::string sounds;
 	std::string textures;
 	std::string data;
 
+	std::shared_ptr<const AssetBundle> bundle;
+
 };
 
 struct Assets {
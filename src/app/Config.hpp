@@ -31,6 +31,24 @@ struct Config {
 		std::string host = "localhost";
 		std::uint16_t port = 12354;
 		std::uint16_t cmd_port = 0;
+		/// milliseconds per tick spent on running command batches
+		int cmd_budget = 2;
+
+		/// how far in the past (in ms) remote entities are displayed
+		int interp_delay = 100;
+
+		/// if positive, the server ticks at this fixed interval (in ms)
+		/// instead of following the wall clock
+		int tick = 0;
+
+		/// simulated network conditions, see udp::Impairment::Parse()
+		/// only set from the command line, never saved
+		std::string impairment;
+
+		/// if set, the server writes all packets it receives to this
+		/// file for replaying them later (see server::ReplayWriter)
+		/// only set from the command line, never saved
+		std::string record;
 
 	} net;
 
@@ -49,6 +67,11 @@ struct Config {
 		bool hud = true;
 		bool world = true;
 		bool debug = false;
+		/// simplify and cull entities by distance
+		bool lod = true;
+		/// sample block light from a 3D texture rather than baking
+		/// it into chunk meshes
+		bool light_volume = false;
 
 	} video;
 
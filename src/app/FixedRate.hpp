@@ -0,0 +1,61 @@
+#ifndef BLANK_APP_FIXEDRATE_HPP_
+#define BLANK_APP_FIXEDRATE_HPP_
+
+#include <cstdint>
+
+
+namespace blank {
+
+/// Paces a loop to a fixed interval on the monotonic clock.
+/// When the loop falls behind, it gets to run up to max_steps steps
+/// back to back to catch up. If that's not enough, the schedule is
+/// reset and the remaining steps are dropped.
+class FixedRate {
+
+public:
+	explicit FixedRate(int interval_ms, int max_steps = 4) noexcept;
+	/// start the schedule at given time in nanoseconds on the monotonic
+	/// clock instead of now
+	FixedRate(int interval_ms, int max_steps, std::int64_t start) noexcept;
+
+	int Interval() const noexcept { return interval_ms; }
+
+	/// sleep until the next step is due
+	/// @return number of steps to run, at least 1 and at most max_steps
+	int Wait() noexcept;
+	/// schedule the next step as if Wait() was entered at time now,
+	/// but without sleeping
+	/// @return number of steps to run, at least 1 and at most max_steps
+	int Advance(std::int64_t now) noexcept;
+
+	/// steps handed out so far
+	std::uint64_t Steps() const noexcept { return steps; }
+	/// times Wait() was entered after the step was due
+	std::uint64_t Overruns() const noexcept { return overruns; }
+	/// steps skipped because catching up would take too many
+	std::uint64_t Dropped() const noexcept { return dropped; }
+	/// worst time in nanoseconds a step was started after it was due
+	std::int64_t MaxLateness() const noexcept { return max_lateness; }
+
+private:
+	/// nanoseconds on the monotonic clock
+	static std::int64_t Now() noexcept;
+	static void SleepUntil(std::int64_t) noexcept;
+
+private:
+	int interval_ms;
+	std::int64_t interval;
+	int max_steps;
+	/// when the next step is due
+	std::int64_t next;
+
+	std::uint64_t steps;
+	std::uint64_t overruns;
+	std::uint64_t dropped;
+	std::int64_t max_lateness;
+
+};
+
+}
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef BLANK_APP_PROFILER_HPP_
+#define BLANK_APP_PROFILER_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+
+namespace blank {
+
+/// Records nested, named zones with nanosecond timestamps and writes
+/// them out in Chrome's trace event format, which chrome://tracing and
+/// Perfetto can open.
+/// Each thread writes into a ring buffer of its own, so recording a zone
+/// takes no locks. Rings only hold the most recent zones of each thread,
+/// older ones get overwritten. Nothing is recorded unless started.
+class Profiler {
+
+public:
+	/// RAII marker, records the time between its construction and
+	/// destruction under given name
+	/// the name has to be a string literal (or otherwise outlive the
+	/// profiler) without characters that need escaping in JSON
+	class Zone {
+
+	public:
+		explicit Zone(const char *name) noexcept
+		: name(Recording() ? name : nullptr)
+		, begin(this->name ? Now() : 0) { }
+		~Zone() noexcept {
+			if (name) {
+				Record(name, begin, Now());
+			}
+		}
+
+		Zone(const Zone &) = delete;
+		Zone &operator =(const Zone &) = delete;
+
+	private:
+		const char *name;
+		std::int64_t begin;
+
+	};
+
+	struct Event {
+		const char *name;
+		/// nanoseconds since the profiler's epoch
+		std::int64_t begin;
+		std::int64_t end;
+		/// sequential number of the recording thread
+		int thread;
+	};
+
+public:
+	/// start recording, zones from earlier recordings are discarded
+	static void Start() noexcept;
+	/// stop recording, zones recorded so far are kept for writing
+	static void Stop() noexcept;
+	static bool Recording() noexcept { return recording.load(std::memory_order_relaxed); }
+
+	/// write zones of the current or last recording as trace JSON
+	/// zones that are being overwritten while writing may come out garbled
+	static void Write(std::ostream &);
+	/// like above, but into a file at given path
+	/// @return false if the file couldn't be written
+	static bool Write(const std::string &path);
+
+	/// nanoseconds since the profiler's epoch
+	static std::int64_t Now() noexcept;
+
+private:
+	static void Record(const char *name, std::int64_t begin, std::int64_t end) noexcept;
+
+private:
+	static std::atomic<bool> recording;
+
+};
+
+}
+
+#endif
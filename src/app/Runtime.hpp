@@ -37,6 +37,8 @@ public:
 		STANDALONE,
 		SERVER,
 		CLIENT,
+		/// run a server from a recording, as fast as possible
+		REPLAY,
 	};
 
 	struct Config {
@@ -59,6 +61,7 @@ private:
 	void RunStandalone();
 	void RunServer();
 	void RunClient();
+	void RunReplay();
 
 	void Run(HeadlessApplication &);
 
@@ -69,6 +72,8 @@ private:
 	std::size_t n;
 	std::size_t t;
 	Config config;
+	/// recording to run in REPLAY target
+	std::string replay_path;
 
 };
 
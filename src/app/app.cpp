@@ -1,7 +1,10 @@
 #include "Application.hpp"
+#include "AssetBundle.hpp"
 #include "Assets.hpp"
 #include "Environment.hpp"
+#include "FixedRate.hpp"
 #include "FrameCounter.hpp"
+#include "Profiler.hpp"
 #include "State.hpp"
 #include "StateControl.hpp"
 
@@ -11,6 +14,7 @@
 #include "../graphics/CubeMap.hpp"
 #include "../graphics/Font.hpp"
 #include "../graphics/Texture.hpp"
+#include "../io/filesystem.hpp"
 #include "../io/TokenStreamReader.hpp"
 #include "../model/bounds.hpp"
 #include "../model/Model.hpp"
@@ -22,10 +26,23 @@
 #include "../world/BlockTypeRegistry.hpp"
 #include "../world/Entity.hpp"
 
+#ifdef __linux__
+#  include <cerrno>
+#  include <time.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <memory>
 #include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <vector>
 #include <SDL_image.h>
 
 using namespace std;
@@ -99,6 +116,14 @@ void HeadlessApplication::Run() {
 	}
 }
 
+void HeadlessApplication::RunFixed(FixedRate &rate) {
+	while (HasState()) {
+		for (int steps = rate.Wait(); HasState() && steps > 0; --steps) {
+			Loop(rate.Interval());
+		}
+	}
+}
+
 void HeadlessApplication::Loop(int dt) {
 	env.counter.EnterFrame();
 	HandleEvents();
@@ -122,6 +147,7 @@ void Application::Loop(int dt) {
 
 
 void HeadlessApplication::HandleEvents() {
+	Profiler::Zone zone("handle");
 	env.counter.EnterHandle();
 	SDL_Event event;
 	while (HasState() && SDL_PollEvent(&event)) {
@@ -137,6 +163,7 @@ void HeadlessApplication::Handle(const SDL_Event &event) {
 
 
 void Application::HandleEvents() {
+	Profiler::Zone zone("handle");
 	env.counter.EnterHandle();
 	SDL_Event event;
 	while (HasState() && SDL_PollEvent(&event)) {
@@ -175,6 +202,7 @@ void Application::Handle(const SDL_WindowEvent &event) {
 }
 
 void HeadlessApplication::Update(int dt) {
+	Profiler::Zone zone("update");
 	env.counter.EnterUpdate();
 	if (HasState()) {
 		GetState().Update(dt);
@@ -183,6 +211,7 @@ void HeadlessApplication::Update(int dt) {
 }
 
 void Application::Update(int dt) {
+	Profiler::Zone zone("update");
 	env.counter.EnterUpdate();
 	env.audio.Update(dt);
 	if (HasState()) {
@@ -198,6 +227,7 @@ void Application::Render() {
 	env.counter.EnterRender();
 
 	if (HasState()) {
+		Profiler::Zone zone("render");
 		GetState().Render(env.viewport);
 	}
 
@@ -293,33 +323,81 @@ void StateControl::Commit(HeadlessApplication &app) {
 }
 
 
-AssetLoader::AssetLoader(const string &base)
-: fonts(base + "fonts/")
-, sounds(base + "sounds/")
-, textures(base + "textures/")
-, data(base + "data/") {
+namespace {
 
-}
+struct SurfaceDeleter {
+	void operator ()(SDL_Surface *srf) const noexcept {
+		SDL_FreeSurface(srf);
+	}
+};
+using SurfacePtr = unique_ptr<SDL_Surface, SurfaceDeleter>;
 
-Assets::Assets(const AssetLoader &loader)
-: large_ui_font(loader.LoadFont("DejaVuSans", 24))
-, small_ui_font(loader.LoadFont("DejaVuSans", 16)) {
+/// load a PNG and convert it to given format unless it's compatible
+SurfacePtr DecodeImage(const string &path, const Format &format) {
+	SurfacePtr srf(IMG_Load(path.c_str()));
+	if (!srf) {
+		throw SDLError("IMG_Load");
+	}
+	if (format.Compatible(Format(*srf->format))) {
+		return srf;
+	}
+	SurfacePtr converted(SDL_ConvertSurface(srf.get(), &format.sdl_format, 0));
+	if (!converted) {
+		throw SDLError("SDL_ConvertSurface");
+	}
+	return converted;
+}
+
+/// decode all given images on as many threads as there are cores
+/// IMG_Init must have loaded the PNG library up front, SDL errors are
+/// per thread, so each decode reports its own
+/// @throws whatever the first failed image (in order of paths) threw
+vector<SurfacePtr> DecodeImages(const vector<string> &paths, const Format &format) {
+	vector<SurfacePtr> surfaces(paths.size());
+	vector<exception_ptr> errors(paths.size());
+	atomic<size_t> next(0);
+	auto work = [&]() {
+		for (size_t i = next++; i < paths.size(); i = next++) {
+			try {
+				surfaces[i] = DecodeImage(paths[i], format);
+			} catch (...) {
+				errors[i] = current_exception();
+			}
+		}
+	};
+
+	const size_t num_threads = min(size_t(max(1u, thread::hardware_concurrency())), paths.size());
+	vector<thread> workers;
+	workers.reserve(num_threads);
+	for (size_t i = 1; i < num_threads; ++i) {
+		try {
+			workers.emplace_back(work);
+		} catch (system_error &) {
+			// fewer threads it is then
+			break;
+		}
+	}
+	// this thread takes a share as well
+	work();
+	for (thread &worker : workers) {
+		worker.join();
+	}
 
+	for (const exception_ptr &error : errors) {
+		if (error) {
+			rethrow_exception(error);
+		}
+	}
+	return surfaces;
 }
 
-void AssetLoader::LoadBlockTypes(
-	const string &set_name,
+void ReadBlockTypes(
+	TokenStreamReader &in,
 	BlockTypeRegistry &reg,
 	ResourceIndex &snd_index,
 	ResourceIndex &tex_index,
 	const ShapeRegistry &shapes
-) const {
-	string full = data + set_name + ".types";
-	ifstream file(full);
-	if (!file) {
-		throw runtime_error("failed to open block type file " + full);
-	}
-	TokenStreamReader in(file);
+) {
 	string proto;
 	while (in.HasMore()) {
 		BlockType type;
@@ -336,72 +414,137 @@ void AssetLoader::LoadBlockTypes(
 	}
 }
 
-CubeMap AssetLoader::LoadCubeMap(const string &name) const {
-	string full = textures + name;
-	string right = full + "-right.png";
-	string left = full + "-left.png";
-	string top = full + "-top.png";
-	string bottom = full + "-bottom.png";
-	string back = full + "-back.png";
-	string front = full + "-front.png";
-
-	CubeMap cm;
-	cm.Bind();
-	SDL_Surface *srf;
-
-	if (!(srf = IMG_Load(right.c_str()))) throw SDLError("IMG_Load");
-	try {
-		cm.Data(CubeMap::RIGHT, *srf);
-	} catch (...) {
-		SDL_FreeSurface(srf);
-		throw;
+void ReadModels(
+	TokenStreamReader &in,
+	ModelRegistry &models,
+	ResourceIndex &tex_index,
+	const ShapeRegistry &shapes
+) {
+	string model_name;
+	string prop_name;
+	while (in.HasMore()) {
+		in.ReadIdentifier(model_name);
+		in.Skip(Token::EQUALS);
+		in.Skip(Token::ANGLE_BRACKET_OPEN);
+		Model &model = models.Add(model_name);
+		while (in.HasMore() && in.Peek().type != Token::ANGLE_BRACKET_CLOSE) {
+			in.ReadIdentifier(prop_name);
+			in.Skip(Token::EQUALS);
+			if (prop_name == "root") {
+				model.RootPart().Read(in, tex_index, shapes);
+			} else if (prop_name == "body") {
+				model.SetBody(in.GetULong());
+			} else if (prop_name == "eyes") {
+				model.SetEyes(in.GetULong());
+			} else {
+				while (in.HasMore() && in.Peek().type != Token::SEMICOLON) {
+					in.Next();
+				}
+			}
+			in.Skip(Token::SEMICOLON);
+		}
+		model.Enumerate();
+		in.Skip(Token::ANGLE_BRACKET_CLOSE);
+		in.Skip(Token::SEMICOLON);
 	}
-	SDL_FreeSurface(srf);
+}
 
-	if (!(srf = IMG_Load(left.c_str()))) throw SDLError("IMG_Load");
-	try {
-		cm.Data(CubeMap::LEFT, *srf);
-	} catch (...) {
-		SDL_FreeSurface(srf);
-		throw;
+void ReadShapes(TokenStreamReader &in, ShapeRegistry &shapes) {
+	string shape_name;
+	while (in.HasMore()) {
+		in.ReadIdentifier(shape_name);
+		in.Skip(Token::EQUALS);
+		Shape &shape = shapes.Add(shape_name);
+		shape.Read(in);
+		in.Skip(Token::SEMICOLON);
 	}
-	SDL_FreeSurface(srf);
+}
 
-	if (!(srf = IMG_Load(top.c_str()))) throw SDLError("IMG_Load");
-	try {
-		cm.Data(CubeMap::TOP, *srf);
-	} catch (...) {
-		SDL_FreeSurface(srf);
-		throw;
-	}
-	SDL_FreeSurface(srf);
+}
+
+AssetLoader::AssetLoader(const string &base)
+: base(base)
+, fonts(base + "fonts/")
+, sounds(base + "sounds/")
+, textures(base + "textures/")
+, data(base + "data/")
+, bundle() {
+
+}
 
-	if (!(srf = IMG_Load(bottom.c_str()))) throw SDLError("IMG_Load");
+bool AssetLoader::OpenBundle(const string &set_name) {
+	string full = data + set_name + ".bundle";
+	if (!is_file(full)) {
+		// not having one is perfectly normal
+		return false;
+	}
 	try {
-		cm.Data(CubeMap::BOTTOM, *srf);
-	} catch (...) {
-		SDL_FreeSurface(srf);
-		throw;
+		shared_ptr<AssetBundle> candidate = make_shared<AssetBundle>(full);
+		if (!candidate->Fresh(base)) {
+			cerr << "asset bundle " << full << " is stale, loading sources instead" << endl;
+			return false;
+		}
+		bundle = candidate;
+		return true;
+	} catch (exception &e) {
+		cerr << "ignoring asset bundle " << full << ": " << e.what() << endl;
+		return false;
 	}
-	SDL_FreeSurface(srf);
+}
 
-	if (!(srf = IMG_Load(back.c_str()))) throw SDLError("IMG_Load");
-	try {
-		cm.Data(CubeMap::BACK, *srf);
-	} catch (...) {
-		SDL_FreeSurface(srf);
-		throw;
+bool AssetLoader::BundleData(const string &name, const void *&compiled, size_t &size) const noexcept {
+	return bundle && bundle->Data(name, compiled, size);
+}
+
+Assets::Assets(const AssetLoader &loader)
+: large_ui_font(loader.LoadFont("DejaVuSans", 24))
+, small_ui_font(loader.LoadFont("DejaVuSans", 16)) {
+
+}
+
+void AssetLoader::LoadBlockTypes(
+	const string &set_name,
+	BlockTypeRegistry &reg,
+	ResourceIndex &snd_index,
+	ResourceIndex &tex_index,
+	const ShapeRegistry &shapes
+) const {
+	const void *compiled;
+	size_t compiled_size;
+	if (BundleData(set_name + ".types", compiled, compiled_size)) {
+		TokenStreamReader in(compiled, compiled_size);
+		ReadBlockTypes(in, reg, snd_index, tex_index, shapes);
+		return;
 	}
-	SDL_FreeSurface(srf);
+	string full = data + set_name + ".types";
+	ifstream file(full);
+	if (!file) {
+		throw runtime_error("failed to open block type file " + full);
+	}
+	const string text((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+	TokenStreamReader in(text.data(), text.data() + text.size());
+	ReadBlockTypes(in, reg, snd_index, tex_index, shapes);
+}
 
-	if (!(srf = IMG_Load(front.c_str()))) throw SDLError("IMG_Load");
-	try {
-		cm.Data(CubeMap::FRONT, *srf);
-	} catch (...) {
-		SDL_FreeSurface(srf);
-		throw;
+CubeMap AssetLoader::LoadCubeMap(const string &name) const {
+	string full = textures + name;
+	const CubeMap::Face faces[] = {
+		CubeMap::RIGHT, CubeMap::LEFT,
+		CubeMap::TOP, CubeMap::BOTTOM,
+		CubeMap::BACK, CubeMap::FRONT,
+	};
+	const vector<string> paths = {
+		full + "-right.png", full + "-left.png",
+		full + "-top.png", full + "-bottom.png",
+		full + "-back.png", full + "-front.png",
+	};
+
+	CubeMap cm;
+	const vector<SurfacePtr> surfaces(DecodeImages(paths, Format()));
+	cm.Bind();
+	for (size_t i = 0; i < surfaces.size(); ++i) {
+		cm.Data(faces[i], *surfaces[i]);
 	}
-	SDL_FreeSurface(srf);
 
 	cm.FilterNearest();
 	cm.WrapEdge();
@@ -420,56 +563,39 @@ void AssetLoader::LoadModels(
 	ResourceIndex &tex_index,
 	const ShapeRegistry &shapes
 ) const {
+	const void *compiled;
+	size_t compiled_size;
+	if (BundleData(set_name + ".models", compiled, compiled_size)) {
+		TokenStreamReader in(compiled, compiled_size);
+		ReadModels(in, models, tex_index, shapes);
+		return;
+	}
 	string full = data + set_name + ".models";
 	ifstream file(full);
 	if (!file) {
 		throw runtime_error("failed to open model file " + full);
 	}
-	TokenStreamReader in(file);
-	string model_name;
-	string prop_name;
-	while (in.HasMore()) {
-		in.ReadIdentifier(model_name);
-		in.Skip(Token::EQUALS);
-		in.Skip(Token::ANGLE_BRACKET_OPEN);
-		Model &model = models.Add(model_name);
-		while (in.HasMore() && in.Peek().type != Token::ANGLE_BRACKET_CLOSE) {
-			in.ReadIdentifier(prop_name);
-			in.Skip(Token::EQUALS);
-			if (prop_name == "root") {
-				model.RootPart().Read(in, tex_index, shapes);
-			} else if (prop_name == "body") {
-				model.SetBody(in.GetULong());
-			} else if (prop_name == "eyes") {
-				model.SetEyes(in.GetULong());
-			} else {
-				while (in.HasMore() && in.Peek().type != Token::SEMICOLON) {
-					in.Next();
-				}
-			}
-			in.Skip(Token::SEMICOLON);
-		}
-		model.Enumerate();
-		in.Skip(Token::ANGLE_BRACKET_CLOSE);
-		in.Skip(Token::SEMICOLON);
-	}
+	const string text((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+	TokenStreamReader in(text.data(), text.data() + text.size());
+	ReadModels(in, models, tex_index, shapes);
 }
 
 void AssetLoader::LoadShapes(const string &set_name, ShapeRegistry &shapes) const {
+	const void *compiled;
+	size_t compiled_size;
+	if (BundleData(set_name + ".shapes", compiled, compiled_size)) {
+		TokenStreamReader in(compiled, compiled_size);
+		ReadShapes(in, shapes);
+		return;
+	}
 	string full = data + set_name + ".shapes";
 	ifstream file(full);
 	if (!file) {
 		throw runtime_error("failed to open shape file " + full);
 	}
-	TokenStreamReader in(file);
-	string shape_name;
-	while (in.HasMore()) {
-		in.ReadIdentifier(shape_name);
-		in.Skip(Token::EQUALS);
-		Shape &shape = shapes.Add(shape_name);
-		shape.Read(in);
-		in.Skip(Token::SEMICOLON);
-	}
+	const string text((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+	TokenStreamReader in(text.data(), text.data() + text.size());
+	ReadShapes(in, shapes);
 }
 
 Sound AssetLoader::LoadSound(const string &name) const {
@@ -508,9 +634,24 @@ void AssetLoader::LoadTexture(const string &name, ArrayTexture &tex, int layer)
 
 void AssetLoader::LoadTextures(const ResourceIndex &index, ArrayTexture &tex) const {
 	// TODO: where the hell should that size come from?
-	tex.Reserve(16, 16, index.Size(), Format());
+	Format format;
+	tex.Reserve(16, 16, index.Size(), format);
+	tex.Bind();
+	vector<string> paths;
+	vector<size_t> layers;
 	for (const auto &entry : index.Entries()) {
-		LoadTexture(entry.first, tex, entry.second);
+		const AssetBundle::Texture *decoded = bundle ? bundle->GetTexture(entry.first) : nullptr;
+		if (decoded && decoded->width == 16 && decoded->height == 16) {
+			tex.Data(entry.second, format, const_cast<void *>(decoded->pixels));
+		} else {
+			paths.push_back(textures + entry.first + ".png");
+			layers.push_back(entry.second);
+		}
+	}
+	// decoding is what takes time, uploading has to stay on this thread
+	const vector<SurfacePtr> surfaces(DecodeImages(paths, format));
+	for (size_t i = 0; i < surfaces.size(); ++i) {
+		tex.Data(layers[i], *surfaces[i]);
 	}
 }
 
@@ -619,4 +760,84 @@ void FrameCounter::Print(ostream &out) const {
 		<< "ms" << endl;
 }
 
+
+FixedRate::FixedRate(int interval_ms, int max_steps) noexcept
+: FixedRate(interval_ms, max_steps, Now()) {
+
+}
+
+FixedRate::FixedRate(int interval_ms, int max_steps, std::int64_t start) noexcept
+: interval_ms(interval_ms)
+, interval(std::int64_t(interval_ms) * 1000000)
+, max_steps(std::max(1, max_steps))
+, next(start)
+, steps(0)
+, overruns(0)
+, dropped(0)
+, max_lateness(0) {
+
+}
+
+int FixedRate::Wait() noexcept {
+	const std::int64_t now = Now();
+	const int due = Advance(now);
+	if (next > now) {
+		SleepUntil(next);
+	}
+	return due;
+}
+
+int FixedRate::Advance(std::int64_t now) noexcept {
+	next += interval;
+	if (now <= next) {
+		++steps;
+		return 1;
+	}
+
+	const std::int64_t lateness = now - next;
+	++overruns;
+	max_lateness = std::max(max_lateness, lateness);
+	// this step plus all that became due while we were late
+	std::int64_t due = 1 + lateness / interval;
+	if (due > max_steps) {
+		dropped += due - max_steps;
+		due = max_steps;
+		// give up on the old schedule, the next step is due one
+		// interval after the last catch up step was started
+		next = now;
+	} else {
+		next += (due - 1) * interval;
+	}
+	steps += due;
+	return due;
+}
+
+std::int64_t FixedRate::Now() noexcept {
+#ifdef __linux__
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return std::int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#else
+	return chrono::duration_cast<chrono::nanoseconds>(
+		chrono::steady_clock::now().time_since_epoch()
+	).count();
+#endif
+}
+
+void FixedRate::SleepUntil(std::int64_t t) noexcept {
+#ifdef __linux__
+	timespec ts;
+	ts.tv_sec = t / 1000000000;
+	ts.tv_nsec = t % 1000000000;
+	// absolute deadline, so restarting after a signal doesn't drift
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+		// interrupted by a signal, the deadline's still the same
+	}
+#else
+	this_thread::sleep_until(chrono::steady_clock::time_point(
+		chrono::duration_cast<chrono::steady_clock::duration>(chrono::nanoseconds(t))
+	));
+#endif
+}
+
 }
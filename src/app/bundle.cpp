@@ -0,0 +1,298 @@
+#include "AssetBundle.hpp"
+
+#include "Assets.hpp"
+#include "error.hpp"
+#include "../graphics/Format.hpp"
+#include "../io/filesystem.hpp"
+#include "../io/Tokenizer.hpp"
+#include "../shared/WorldResources.hpp"
+
+#ifdef __linux__
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <SDL_image.h>
+
+using namespace std;
+
+
+namespace blank {
+
+namespace {
+
+const char magic[8] = { 'B', 'L', 'N', 'K', 'B', 'N', 'D', 'L' };
+constexpr uint32_t byte_order = 0x01020304;
+/// pixel data starts at multiples of this
+constexpr size_t pixel_alignment = 4;
+
+/// bounds checked reading from the mapped file
+struct Cursor {
+
+	const unsigned char *begin;
+	const unsigned char *pos;
+	const unsigned char *end;
+
+	const unsigned char *Skip(size_t n) {
+		if (size_t(end - pos) < n) {
+			throw runtime_error("asset bundle truncated");
+		}
+		const unsigned char *at = pos;
+		pos += n;
+		return at;
+	}
+
+	template<class T>
+	T Read() {
+		T value;
+		memcpy(&value, Skip(sizeof(T)), sizeof(T));
+		return value;
+	}
+
+	string ReadString() {
+		const uint32_t len = Read<uint32_t>();
+		return string(reinterpret_cast<const char *>(Skip(len)), len);
+	}
+
+	void Align(size_t n) {
+		const size_t offset = pos - begin;
+		if (offset % n) {
+			Skip(n - offset % n);
+		}
+	}
+
+};
+
+template<class T>
+void Put(ostream &out, T value) {
+	out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+void PutString(ostream &out, const string &str) {
+	Put<uint32_t>(out, str.size());
+	out.write(str.data(), str.size());
+}
+
+void PutAlign(ostream &out, size_t n) {
+	const size_t offset = out.tellp();
+	for (size_t i = offset % n; i > 0 && i < n; ++i) {
+		out.put('\0');
+	}
+}
+
+}
+
+constexpr uint32_t AssetBundle::version;
+
+AssetBundle::AssetBundle(const string &path)
+: mem(nullptr)
+, mem_size(0)
+, copy()
+, sources()
+, data()
+, textures() {
+	Map(path);
+	try {
+		Parse();
+	} catch (...) {
+#ifdef __linux__
+		if (copy.empty() && mem) {
+			munmap(const_cast<unsigned char *>(mem), mem_size);
+		}
+#endif
+		throw;
+	}
+}
+
+AssetBundle::~AssetBundle() {
+#ifdef __linux__
+	if (copy.empty() && mem) {
+		munmap(const_cast<unsigned char *>(mem), mem_size);
+	}
+#endif
+}
+
+void AssetBundle::Map(const string &path) {
+#ifdef __linux__
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw runtime_error("unable to open asset bundle " + path);
+	}
+	mem_size = file_size(path);
+	void *addr = mem_size ? mmap(nullptr, mem_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+	close(fd);
+	if (addr == MAP_FAILED) {
+		throw runtime_error("unable to map asset bundle " + path);
+	}
+	mem = static_cast<const unsigned char *>(addr);
+#else
+	ifstream in(path, ios::binary);
+	if (!in) {
+		throw runtime_error("unable to open asset bundle " + path);
+	}
+	copy.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+	if (copy.empty()) {
+		throw runtime_error("empty asset bundle " + path);
+	}
+	mem = copy.data();
+	mem_size = copy.size();
+#endif
+}
+
+void AssetBundle::Parse() {
+	Cursor in{ mem, mem, mem + mem_size };
+	if (memcmp(in.Skip(sizeof(magic)), magic, sizeof(magic)) != 0) {
+		throw runtime_error("not an asset bundle");
+	}
+	if (in.Read<uint32_t>() != byte_order) {
+		throw runtime_error("asset bundle has wrong byte order");
+	}
+	if (in.Read<uint32_t>() != version) {
+		throw runtime_error("asset bundle has wrong version");
+	}
+
+	for (uint32_t i = 0, n = in.Read<uint32_t>(); i < n; ++i) {
+		Source src;
+		src.path = in.ReadString();
+		src.size = in.Read<uint64_t>();
+		src.mtime = in.Read<int64_t>();
+		sources.push_back(move(src));
+	}
+
+	for (uint32_t i = 0, n = in.Read<uint32_t>(); i < n; ++i) {
+		string name = in.ReadString();
+		Section &section = data[name];
+		section.size = in.Read<uint64_t>();
+		section.offset = in.Skip(section.size) - mem;
+	}
+
+	for (uint32_t i = 0, n = in.Read<uint32_t>(); i < n; ++i) {
+		string name = in.ReadString();
+		Texture &tex = textures[name];
+		tex.width = in.Read<uint32_t>();
+		tex.height = in.Read<uint32_t>();
+		in.Align(pixel_alignment);
+		tex.pixels = in.Skip(size_t(tex.width) * size_t(tex.height) * 4);
+	}
+}
+
+bool AssetBundle::Fresh(const string &base) const {
+	for (const Source &src : sources) {
+		const string full = base + src.path;
+		if (file_size(full) != src.size || int64_t(file_mtime(full)) != src.mtime) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool AssetBundle::Data(const string &name, const void *&out, size_t &size) const noexcept {
+	auto entry = data.find(name);
+	if (entry == data.end()) {
+		return false;
+	}
+	out = mem + entry->second.offset;
+	size = entry->second.size;
+	return true;
+}
+
+const AssetBundle::Texture *AssetBundle::GetTexture(const string &name) const noexcept {
+	auto entry = textures.find(name);
+	if (entry == textures.end()) {
+		return nullptr;
+	}
+	return &entry->second;
+}
+
+
+void AssetBundle::Write(const string &base, const string &set_name, const string &path) {
+	// a loader that was never told about bundles reads the sources
+	AssetLoader loader(base);
+	WorldResources res;
+	res.Load(loader, set_name);
+
+	vector<Source> sources;
+	vector<pair<string, string>> compiled;
+	for (const char *ext : { ".shapes", ".types", ".models" }) {
+		const string name = set_name + ext;
+		const string rel = "data/" + name;
+		ifstream file(base + rel);
+		if (!file) {
+			throw runtime_error("failed to open data file " + base + rel);
+		}
+		ostringstream out;
+		Tokenizer::Compile(file, out);
+		compiled.emplace_back(name, out.str());
+		sources.push_back({ rel, file_size(base + rel), int64_t(file_mtime(base + rel)) });
+	}
+
+	const string tmp_path = path + ".tmp";
+	ofstream out(tmp_path, ios::binary | ios::trunc);
+	if (!out) {
+		throw runtime_error("unable to write asset bundle " + tmp_path);
+	}
+	out.write(magic, sizeof(magic));
+	Put<uint32_t>(out, byte_order);
+	Put<uint32_t>(out, version);
+
+	const ResourceIndex::MapType &tex_names = res.tex_index.Entries();
+	for (const auto &entry : tex_names) {
+		const string rel = "textures/" + entry.first + ".png";
+		sources.push_back({ rel, file_size(base + rel), int64_t(file_mtime(base + rel)) });
+	}
+	Put<uint32_t>(out, sources.size());
+	for (const Source &src : sources) {
+		PutString(out, src.path);
+		Put<uint64_t>(out, src.size);
+		Put<int64_t>(out, src.mtime);
+	}
+
+	Put<uint32_t>(out, compiled.size());
+	for (const auto &entry : compiled) {
+		PutString(out, entry.first);
+		Put<uint64_t>(out, entry.second.size());
+		out.write(entry.second.data(), entry.second.size());
+	}
+
+	Format format;
+	Put<uint32_t>(out, tex_names.size());
+	for (const auto &entry : tex_names) {
+		const string full = base + "textures/" + entry.first + ".png";
+		SDL_Surface *srf = IMG_Load(full.c_str());
+		if (!srf) {
+			throw SDLError("IMG_Load");
+		}
+		SDL_Surface *converted = SDL_ConvertSurface(srf, &format.sdl_format, 0);
+		SDL_FreeSurface(srf);
+		if (!converted) {
+			throw SDLError("SDL_ConvertSurface");
+		}
+		PutString(out, entry.first);
+		Put<uint32_t>(out, converted->w);
+		Put<uint32_t>(out, converted->h);
+		PutAlign(out, pixel_alignment);
+		SDL_LockSurface(converted);
+		for (int y = 0; y < converted->h; ++y) {
+			out.write(static_cast<const char *>(converted->pixels) + y * converted->pitch, converted->w * 4);
+		}
+		SDL_UnlockSurface(converted);
+		SDL_FreeSurface(converted);
+	}
+
+	out.close();
+	if (!out) {
+		throw runtime_error("unable to write asset bundle " + tmp_path);
+	}
+	// replace in one go, so running instances never see half a bundle
+	if (rename(tmp_path.c_str(), path.c_str()) != 0) {
+		throw runtime_error("unable to move asset bundle to " + path);
+	}
+}
+
+}
@@ -110,12 +110,12 @@ InitGL::InitGL(bool double_buffer, int sample_size) {
 }
 
 
-Window::Window()
+Window::Window(bool visible)
 : handle(SDL_CreateWindow(
 	"blank",
 	SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
 	960, 600,
-	SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE
+	SDL_WINDOW_OPENGL | (visible ? SDL_WINDOW_RESIZABLE : SDL_WINDOW_HIDDEN)
 )) {
 	if (!handle) {
 		throw SDLError("SDL_CreateWindow");
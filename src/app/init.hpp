@@ -95,7 +95,8 @@ public:
 class Window {
 
 public:
-	Window();
+	/// a hidden window still gets a context, e.g. for benchmarks
+	explicit Window(bool visible = true);
 	~Window();
 
 	Window(const Window &) = delete;
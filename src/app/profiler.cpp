@@ -0,0 +1,135 @@
+#include "Profiler.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+using namespace std;
+
+
+namespace blank {
+
+namespace {
+
+/// single producer ring, only the owning thread writes to it
+struct ZoneRing {
+
+	static constexpr size_t capacity = 1 << 14;
+
+	explicit ZoneRing(int thread)
+	: thread(thread)
+	, head(0)
+	, events(capacity) {
+	}
+
+	int thread;
+	/// total number of events written so far
+	atomic<size_t> head;
+	vector<Profiler::Event> events;
+
+};
+
+constexpr size_t ZoneRing::capacity;
+
+const chrono::steady_clock::time_point epoch = chrono::steady_clock::now();
+/// zones that began before this are from an earlier recording
+atomic<int64_t> since(0);
+
+// rings are only added, never removed, so a thread's pointer into
+// this stays valid even after the thread terminates
+mutex rings_mutex;
+vector<unique_ptr<ZoneRing>> rings;
+thread_local ZoneRing *local_ring = nullptr;
+
+ZoneRing &LocalRing() {
+	if (!local_ring) {
+		lock_guard<mutex> lock(rings_mutex);
+		rings.emplace_back(new ZoneRing(rings.size()));
+		local_ring = rings.back().get();
+	}
+	return *local_ring;
+}
+
+}
+
+atomic<bool> Profiler::recording(false);
+
+void Profiler::Start() noexcept {
+	since.store(Now(), memory_order_relaxed);
+	recording.store(true, memory_order_relaxed);
+}
+
+void Profiler::Stop() noexcept {
+	recording.store(false, memory_order_relaxed);
+}
+
+int64_t Profiler::Now() noexcept {
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - epoch).count();
+}
+
+void Profiler::Record(const char *name, int64_t begin, int64_t end) noexcept {
+	ZoneRing *ring;
+	try {
+		ring = &LocalRing();
+	} catch (...) {
+		// out of memory for a new ring, this zone is lost
+		return;
+	}
+	size_t head = ring->head.load(memory_order_relaxed);
+	Event &event = ring->events[head % ZoneRing::capacity];
+	event.name = name;
+	event.begin = begin;
+	event.end = end;
+	event.thread = ring->thread;
+	ring->head.store(head + 1, memory_order_release);
+}
+
+void Profiler::Write(ostream &out) {
+	const int64_t begin = since.load(memory_order_relaxed);
+	vector<Event> events;
+	{
+		lock_guard<mutex> lock(rings_mutex);
+		for (const unique_ptr<ZoneRing> &ring : rings) {
+			const size_t head = ring->head.load(memory_order_acquire);
+			const size_t count = min(head, ZoneRing::capacity);
+			for (size_t i = head - count; i < head; ++i) {
+				const Event &event = ring->events[i % ZoneRing::capacity];
+				if (event.begin >= begin) {
+					events.push_back(event);
+				}
+			}
+		}
+	}
+
+	// trace timestamps are in microseconds, fractions keep the nanoseconds
+	out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+	out << fixed << setprecision(3);
+	bool first = true;
+	for (const Event &event : events) {
+		if (!first) {
+			out << ',';
+		}
+		first = false;
+		out << "\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1"
+			<< ",\"tid\":" << event.thread
+			<< ",\"ts\":" << ((event.begin - begin) * 0.001)
+			<< ",\"dur\":" << ((event.end - event.begin) * 0.001)
+			<< '}';
+	}
+	out << "\n]}" << endl;
+}
+
+bool Profiler::Write(const string &path) {
+	ofstream out(path);
+	if (!out) {
+		return false;
+	}
+	Write(out);
+	return bool(out);
+}
+
+}
@@ -1,5 +1,6 @@
 #include "Application.hpp"
 #include "Environment.hpp"
+#include "FixedRate.hpp"
 #include "Runtime.hpp"
 
 #include "init.hpp"
@@ -7,6 +8,8 @@
 #include "../io/filesystem.hpp"
 #include "../io/TokenStreamReader.hpp"
 #include "../io/WorldSave.hpp"
+#include "../net/udp.hpp"
+#include "../server/Replay.hpp"
 #include "../server/ServerState.hpp"
 #include "../standalone/MasterState.hpp"
 
@@ -15,6 +18,8 @@
 #include <ctime>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <stdexcept>
 #include <SDL.h>
 
 using namespace std;
@@ -50,7 +55,9 @@ string default_save_path() {
 namespace blank {
 
 void Config::Load(std::istream &is) {
-	TokenStreamReader in(is);
+	// lexing from memory is a lot quicker than off the stream
+	const std::string text((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+	TokenStreamReader in(text.data(), text.data() + text.size());
 	std::string name;
 	while (in.HasMore()) {
 		if (in.Peek().type == Token::STRING) {
@@ -79,6 +86,12 @@ void Config::Load(std::istream &is) {
 			int port;
 			in.ReadNumber(port);
 			net.cmd_port = port;
+		} else if (name == "net.cmd_budget") {
+			in.ReadNumber(net.cmd_budget);
+		} else if (name == "net.interp_delay") {
+			in.ReadNumber(net.interp_delay);
+		} else if (name == "net.tick") {
+			in.ReadNumber(net.tick);
 		} else if (name == "player.name") {
 			in.ReadString(player.name);
 		} else if (name == "video.dblbuf") {
@@ -93,6 +106,10 @@ void Config::Load(std::istream &is) {
 			in.ReadBoolean(video.world);
 		} else if (name == "video.debug") {
 			in.ReadBoolean(video.debug);
+		} else if (name == "video.lod") {
+			in.ReadBoolean(video.lod);
+		} else if (name == "video.light_volume") {
+			in.ReadBoolean(video.light_volume);
 		}
 		if (in.HasMore() && in.Peek().type == Token::SEMICOLON) {
 			in.Skip(Token::SEMICOLON);
@@ -109,6 +126,9 @@ void Config::Save(std::ostream &out) {
 	out << "net.host = \"" << net.host << "\";" << std::endl;
 	out << "net.port = " << net.port << ';' << std::endl;
 	out << "net.cmd_port = " << net.cmd_port << ';' << std::endl;
+	out << "net.cmd_budget = " << net.cmd_budget << ';' << std::endl;
+	out << "net.interp_delay = " << net.interp_delay << ';' << std::endl;
+	out << "net.tick = " << net.tick << ';' << std::endl;
 	out << "player.name = \"" << player.name << "\";" << std::endl;
 	out << "video.dblbuf = " << (video.dblbuf ? "on" : "off") << ';' << std::endl;
 	out << "video.vsync = " << (video.vsync ? "on" : "off") << ';' << std::endl;
@@ -116,6 +136,8 @@ void Config::Save(std::ostream &out) {
 	out << "video.hud = " << (video.hud ? "on" : "off") << ';' << std::endl;
 	out << "video.world = " << (video.world ? "on" : "off") << ';' << std::endl;
 	out << "video.debug = " << (video.debug ? "on" : "off") << ';' << std::endl;
+	out << "video.lod = " << (video.lod ? "on" : "off") << ';' << std::endl;
+	out << "video.light_volume = " << (video.light_volume ? "on" : "off") << ';' << std::endl;
 }
 
 
@@ -124,7 +146,8 @@ HeadlessEnvironment::HeadlessEnvironment(const Config &config)
 , loader(config.asset_path)
 , counter()
 , state() {
-
+	// all states load the default set for now
+	loader.OpenBundle("default");
 }
 
 string HeadlessEnvironment::Config::GetWorldPath(const string &world_name) const {
@@ -170,7 +193,8 @@ Runtime::Runtime() noexcept
 , target(STANDALONE)
 , n(0)
 , t(0)
-, config() {
+, config()
+, replay_path() {
 
 }
 
@@ -213,6 +237,8 @@ void Runtime::ReadArgs(int argc, const char *const *argv) {
 						config.game.input.mouse = false;
 					} else if (strcmp(param, "no-hud") == 0) {
 						config.game.video.hud = false;
+					} else if (strcmp(param, "no-lod") == 0) {
+						config.game.video.lod = false;
 					} else if (strcmp(param, "no-audio") == 0) {
 						config.game.audio.enabled = false;
 					} else if (strcmp(param, "standalone") == 0) {
@@ -221,6 +247,23 @@ void Runtime::ReadArgs(int argc, const char *const *argv) {
 						target = SERVER;
 					} else if (strcmp(param, "client") == 0) {
 						target = CLIENT;
+					} else if (strcmp(param, "replay") == 0) {
+						++i;
+						if (i >= argc || argv[i] == nullptr || argv[i][0] == '\0') {
+							cerr << "missing argument to --replay" << endl;
+							error = true;
+						} else {
+							target = REPLAY;
+							replay_path = argv[i];
+						}
+					} else if (strcmp(param, "record") == 0) {
+						++i;
+						if (i >= argc || argv[i] == nullptr || argv[i][0] == '\0') {
+							cerr << "missing argument to --record" << endl;
+							error = true;
+						} else {
+							config.game.net.record = argv[i];
+						}
 					} else if (strcmp(param, "asset-path") == 0) {
 						++i;
 						if (i >= argc || argv[i] == nullptr || argv[i][0] == '\0') {
@@ -253,6 +296,44 @@ void Runtime::ReadArgs(int argc, const char *const *argv) {
 						} else {
 							config.game.net.cmd_port = strtoul(argv[i], nullptr, 10);
 						}
+					} else if (strcmp(param, "cmd-budget") == 0) {
+						++i;
+						if (i >= argc || argv[i] == nullptr || argv[i][0] == '\0') {
+							cerr << "missing argument to --cmd-budget" << endl;
+							error = true;
+						} else {
+							config.game.net.cmd_budget = strtoul(argv[i], nullptr, 10);
+						}
+					} else if (strcmp(param, "interp-delay") == 0) {
+						++i;
+						if (i >= argc || argv[i] == nullptr || argv[i][0] == '\0') {
+							cerr << "missing argument to --interp-delay" << endl;
+							error = true;
+						} else {
+							config.game.net.interp_delay = strtoul(argv[i], nullptr, 10);
+						}
+					} else if (strcmp(param, "tick") == 0) {
+						++i;
+						if (i >= argc || argv[i] == nullptr || argv[i][0] == '\0') {
+							cerr << "missing argument to --tick" << endl;
+							error = true;
+						} else {
+							config.game.net.tick = strtoul(argv[i], nullptr, 10);
+						}
+					} else if (strcmp(param, "impair") == 0) {
+						++i;
+						if (i >= argc || argv[i] == nullptr || argv[i][0] == '\0') {
+							cerr << "missing argument to --impair" << endl;
+							error = true;
+						} else {
+							try {
+								udp::Impairment::Parse(argv[i]);
+								config.game.net.impairment = argv[i];
+							} catch (exception &e) {
+								cerr << e.what() << endl;
+								error = true;
+							}
+						}
 					} else if (strcmp(param, "player-name") == 0) {
 						++i;
 						if (i >= argc || argv[i] == nullptr || argv[i][0] == '\0') {
@@ -405,6 +486,9 @@ int Runtime::Execute() {
 		case CLIENT:
 			RunClient();
 			break;
+		case REPLAY:
+			RunReplay();
+			break;
 	}
 
 	return 0;
@@ -446,7 +530,13 @@ void Runtime::RunServer() {
 	HeadlessApplication app(env);
 	server::ServerState server_state(env, config.gen, config.world, save, config.game);
 	app.PushState(&server_state);
-	Run(app);
+	if (mode == NORMAL && config.game.net.tick > 0) {
+		FixedRate rate(config.game.net.tick);
+		server_state.SetFixedRate(rate);
+		app.RunFixed(rate);
+	} else {
+		Run(app);
+	}
 }
 
 void Runtime::RunClient() {
@@ -461,6 +551,35 @@ void Runtime::RunClient() {
 	Run(app);
 }
 
+void Runtime::RunReplay() {
+	HeadlessEnvironment env(config.env);
+
+	server::ReplayReader replay(replay_path);
+	if (!replay.Header().fresh_world) {
+		// the saved chunks it started from aren't part of the recording,
+		// so the terrain would differ from the first tick on
+		throw runtime_error("recording was made against a world with saved chunks and can't be replayed faithfully");
+	}
+	config.gen.seed = replay.Header().seed;
+	config.world.spawn = replay.Header().spawn;
+	config.game.net.tick = replay.Header().interval;
+	// nobody to talk to, any free port will do
+	config.game.net.port = 0;
+	config.game.net.cmd_port = 0;
+	config.game.net.impairment.clear();
+	config.game.net.record.clear();
+
+	// start from a fresh world like the recording did, and leave the
+	// real saves alone
+	TempDir dir;
+	WorldSave save(dir.Path());
+	save.Write(config.world);
+	save.Write(config.gen);
+
+	server::ServerState server_state(env, config.gen, config.world, save, config.game);
+	server_state.Replay(replay);
+}
+
 void Runtime::Run(HeadlessApplication &app) {
 	switch (mode) {
 		default:
@@ -0,0 +1,34 @@
+#include "app/AssetBundle.hpp"
+#include "app/init.hpp"
+
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace blank;
+using namespace std;
+
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		cerr << "usage: " << argv[0] << " <set> [asset path]" << endl;
+		return 1;
+	}
+	const string set_name(argv[1]);
+	string base = argc > 2 ? argv[2] : "assets/";
+	if (base.back() != '/') {
+		base += '/';
+	}
+	const string path = base + "data/" + set_name + ".bundle";
+
+	try {
+		InitSDL init_sdl;
+		InitIMG init_img;
+		AssetBundle::Write(base, set_name, path);
+	} catch (exception &e) {
+		cerr << "failed to bundle " << set_name << ": " << e.what() << endl;
+		return 1;
+	}
+	cout << "wrote " << path << endl;
+	return 0;
+}
@@ -3,6 +3,7 @@
 
 #include "../app/Config.hpp"
 #include "../net/Connection.hpp"
+#include "../net/udp.hpp"
 
 #include <string>
 #include <SDL_net.h>
@@ -45,11 +46,12 @@ public:
 		const std::string &msg);
 
 private:
-	void HandlePacket(const UDPpacket &);
+	void HandlePacket(const UDPpacket &, Uint32 stamp, bool filtered);
+	std::uint16_t Send();
 
 private:
 	Connection conn;
-	UDPsocket client_sock;
+	udp::Socket client_sock;
 	UDPpacket client_pack;
 
 };
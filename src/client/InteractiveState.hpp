@@ -5,6 +5,7 @@
 #include "../ui/ClientController.hpp"
 
 #include "ChunkReceiver.hpp"
+#include "InterpolationBuffer.hpp"
 #include "NetworkedInput.hpp"
 #include "../app/IntervalTimer.hpp"
 #include "../audio/SoundBank.hpp"
@@ -75,6 +76,10 @@ private:
 	bool UpdateEntity(std::uint32_t id, std::uint16_t seq);
 	/// drop update information or given entity
 	void ClearEntity(std::uint32_t id);
+	/// get snapshot buffer for given entity, creating it if necessary
+	InterpolationBuffer &GetBuffer(std::uint32_t id);
+	/// set remote entities to their buffered state
+	void InterpolateEntities();
 
 private:
 	MasterState &master;
@@ -99,6 +104,9 @@ private:
 		int last_update;
 	};
 	std::map<std::uint32_t, UpdateStatus> update_status;
+	std::map<std::uint32_t, InterpolationBuffer> entity_buffers;
+	/// time passed since construction, used to stamp incoming updates
+	int update_time;
 
 	ChatState chat;
 
@@ -0,0 +1,60 @@
+#ifndef BLANK_CLIENT_INTERPOLATIONBUFFER_HPP_
+#define BLANK_CLIENT_INTERPOLATIONBUFFER_HPP_
+
+#include "../world/EntityState.hpp"
+
+#include <cstdint>
+#include <deque>
+
+
+namespace blank {
+namespace client {
+
+/// Snapshot buffer for a remote entity's state.
+/// States are tagged with the sequence number of the packet they
+/// arrived in and the (local) time of arrival. Sampling happens
+/// delay ms in the past, so there usually are two snapshots to
+/// interpolate between. If the buffer runs dry, the newest state
+/// gets extrapolated by its velocity for a limited time.
+class InterpolationBuffer {
+
+public:
+	explicit InterpolationBuffer(int delay = 100, int max_extrapolation = 250) noexcept;
+
+	/// add a snapshot received at time with packet seq
+	/// returns false if the snapshot is outdated and was dropped
+	bool Push(std::uint16_t seq, int time, const EntityState &);
+
+	/// get the state to display at given time
+	/// only valid if the buffer is not empty
+	EntityState Get(int time) const noexcept;
+
+	void Clear() noexcept { snapshots.clear(); }
+	bool Empty() const noexcept { return snapshots.empty(); }
+	std::size_t Size() const noexcept { return snapshots.size(); }
+
+	int Delay() const noexcept { return delay; }
+	void Delay(int d) noexcept { delay = d; }
+
+	static EntityState Interpolate(const EntityState &, const EntityState &, float t) noexcept;
+	static EntityState Extrapolate(const EntityState &, int dt) noexcept;
+
+private:
+	struct Snapshot {
+		EntityState state;
+		std::uint16_t seq;
+		int time;
+		Snapshot(const EntityState &s, std::uint16_t q, int t)
+		: state(s), seq(q), time(t) { }
+	};
+	std::deque<Snapshot> snapshots;
+
+	int delay;
+	int max_extrapolation;
+
+};
+
+}
+}
+
+#endif
@@ -1,15 +1,18 @@
 #include "InitialState.hpp"
 #include "InteractiveState.hpp"
+#include "InterpolationBuffer.hpp"
 #include "MasterState.hpp"
 
 #include "../app/Environment.hpp"
 #include "../app/init.hpp"
+#include "../geometry/const.hpp"
 #include "../geometry/distance.hpp"
 #include "../model/Model.hpp"
 #include "../io/WorldSave.hpp"
 #include "../world/ChunkIndex.hpp"
 #include "../world/ChunkStore.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <glm/gtx/io.hpp>
 
@@ -63,6 +66,8 @@ InteractiveState::InteractiveState(MasterState &master, uint32_t player_id)
 , stat_timer(1000)
 , sky(master.GetEnv().loader.LoadCubeMap("skybox"))
 , update_status()
+, entity_buffers()
+, update_time(0)
 , chat(master.GetEnv(), *this, *this)
 , time_skipped(0)
 , packets_skipped(0) {
@@ -78,6 +83,7 @@ InteractiveState::InteractiveState(MasterState &master, uint32_t player_id)
 	interface.SetInventorySlots(res.block_types.size() - 1);
 	chunk_renderer.LoadTextures(master.GetEnv().loader, res.tex_index);
 	chunk_renderer.FogDensity(master.GetWorldConf().fog_density);
+	chunk_renderer.UseLightVolume(master.GetConfig().video.light_volume);
 	loop_timer.Start();
 	stat_timer.Start();
 }
@@ -142,6 +148,7 @@ void InteractiveState::Handle(const SDL_Event &event) {
 }
 
 void InteractiveState::Update(int dt) {
+	update_time += dt;
 	loop_timer.Update(dt);
 	stat_timer.Update(dt);
 	master.Update(dt);
@@ -149,6 +156,7 @@ void InteractiveState::Update(int dt) {
 
 	int world_dt = 0;
 	while (loop_timer.HitOnce()) {
+		InterpolateEntities();
 		world.Update(loop_timer.Interval());
 		world_dt += loop_timer.Interval();
 		loop_timer.PopIteration();
@@ -190,7 +198,7 @@ void InteractiveState::Render(Viewport &viewport) {
 	viewport.WorldPosition(player.GetEntity().ViewTransform(player.GetEntity().ChunkCoords()));
 	if (master.GetConfig().video.world) {
 		chunk_renderer.Render(viewport);
-		world.Render(viewport);
+		world.Render(viewport, master.GetConfig().video.lod);
 		if (master.GetConfig().video.debug) {
 			world.RenderDebug(viewport);
 		}
@@ -205,6 +213,9 @@ void InteractiveState::Handle(const Packet::SpawnEntity &pack) {
 	Entity &entity = world.ForceAddEntity(entity_id);
 	UpdateEntity(entity_id, pack.Seq());
 	pack.ReadEntity(entity);
+	InterpolationBuffer &buffer = GetBuffer(entity_id);
+	buffer.Clear();
+	buffer.Push(pack.Seq(), update_time, entity.GetState());
 	uint32_t model_id;
 	pack.ReadModelID(model_id);
 	if (model_id > 0 && model_id <= res.models.size()) {
@@ -248,7 +259,7 @@ void InteractiveState::Handle(const Packet::EntityUpdate &pack) {
 		if (world_iter->ID() == entity_id) {
 			if (UpdateEntity(entity_id, pack.Seq())) {
 				pack.ReadEntityState(state, base, i);
-				world_iter->SetState(state);
+				GetBuffer(entity_id).Push(pack.Seq(), update_time, state);
 			}
 		}
 	}
@@ -257,13 +268,13 @@ void InteractiveState::Handle(const Packet::EntityUpdate &pack) {
 bool InteractiveState::UpdateEntity(uint32_t entity_id, uint16_t seq) {
 	auto entry = update_status.find(entity_id);
 	if (entry == update_status.end()) {
-		update_status.emplace(entity_id, UpdateStatus{ seq, loop_timer.Elapsed() });
+		update_status.emplace(entity_id, UpdateStatus{ seq, update_time });
 		return true;
 	}
 
 	int16_t pack_diff = int16_t(seq) - int16_t(entry->second.last_packet);
-	int time_diff = loop_timer.Elapsed() - entry->second.last_update;
-	entry->second.last_update = loop_timer.Elapsed();
+	int time_diff = update_time - entry->second.last_update;
+	entry->second.last_update = update_time;
 
 	if (pack_diff > 0 || time_diff > 1500) {
 		entry->second.last_packet = seq;
@@ -275,6 +286,32 @@ bool InteractiveState::UpdateEntity(uint32_t entity_id, uint16_t seq) {
 
 void InteractiveState::ClearEntity(uint32_t entity_id) {
 	update_status.erase(entity_id);
+	entity_buffers.erase(entity_id);
+}
+
+InterpolationBuffer &InteractiveState::GetBuffer(uint32_t entity_id) {
+	auto entry = entity_buffers.find(entity_id);
+	if (entry == entity_buffers.end()) {
+		entry = entity_buffers.emplace(entity_id, InterpolationBuffer(master.GetConfig().net.interp_delay)).first;
+	}
+	return entry->second;
+}
+
+void InteractiveState::InterpolateEntities() {
+	auto buf_iter = entity_buffers.begin();
+	auto buf_end = entity_buffers.end();
+
+	for (Entity &entity : world.Entities()) {
+		while (buf_iter != buf_end && buf_iter->first < entity.ID()) {
+			++buf_iter;
+		}
+		if (buf_iter == buf_end) {
+			return;
+		}
+		if (buf_iter->first == entity.ID() && !buf_iter->second.Empty()) {
+			entity.SetState(buf_iter->second.Get(update_time - buf_iter->second.Delay()));
+		}
+	}
 }
 
 void InteractiveState::Handle(const Packet::PlayerCorrection &pack) {
@@ -368,6 +405,81 @@ void InteractiveState::OnLineSubmit(const string &line) {
 }
 
 
+InterpolationBuffer::InterpolationBuffer(int delay, int max_extrapolation) noexcept
+: snapshots()
+, delay(delay)
+, max_extrapolation(max_extrapolation) {
+
+}
+
+bool InterpolationBuffer::Push(uint16_t seq, int time, const EntityState &state) {
+	if (!snapshots.empty()) {
+		int16_t pack_diff = int16_t(seq) - int16_t(snapshots.back().seq);
+		int time_diff = time - snapshots.back().time;
+		if (time_diff > 1500) {
+			// been quiet for too long to make any sense of sequence numbers
+			snapshots.clear();
+		} else if (pack_diff <= 0) {
+			// arrived out of order or duplicate
+			return false;
+		} else if (time_diff <= 0) {
+			// arrived in the same frame as the previous one, replace it
+			snapshots.pop_back();
+		}
+	}
+	snapshots.emplace_back(state, seq, time);
+	// drop everything that can't be sampled from anymore, keeping one
+	// snapshot before the sample time for interpolation
+	while (snapshots.size() > 2 && snapshots[1].time <= time - delay) {
+		snapshots.pop_front();
+	}
+	while (snapshots.size() > 32) {
+		snapshots.pop_front();
+	}
+	return true;
+}
+
+EntityState InterpolationBuffer::Get(int time) const noexcept {
+	if (time <= snapshots.front().time) {
+		return snapshots.front().state;
+	}
+	for (auto prev = snapshots.begin(), next = prev + 1, end = snapshots.end(); next != end; ++prev, ++next) {
+		if (time < next->time) {
+			float t = float(time - prev->time) / float(next->time - prev->time);
+			return Interpolate(prev->state, next->state, t);
+		}
+	}
+	// ran out of snapshots, extrapolate from the newest one
+	return Extrapolate(snapshots.back().state, std::min(time - snapshots.back().time, max_extrapolation));
+}
+
+EntityState InterpolationBuffer::Interpolate(const EntityState &a, const EntityState &b, float t) noexcept {
+	EntityState result(a);
+	result.pos.block += b.Diff(a) * t;
+	result.AdjustPosition();
+	result.velocity = glm::mix(a.velocity, b.velocity, t);
+	result.orient = glm::slerp(a.orient, b.orient, t);
+	result.pitch = glm::mix(a.pitch, b.pitch, t);
+	// take the short way around
+	float yaw_diff = b.yaw - a.yaw;
+	if (yaw_diff > PI) {
+		yaw_diff -= PI_2p0;
+	} else if (yaw_diff < -PI) {
+		yaw_diff += PI_2p0;
+	}
+	result.yaw = a.yaw + yaw_diff * t;
+	result.AdjustHeading();
+	return result;
+}
+
+EntityState InterpolationBuffer::Extrapolate(const EntityState &state, int dt) noexcept {
+	EntityState result(state);
+	result.pos.block += state.velocity * (dt * 0.001f);
+	result.AdjustPosition();
+	return result;
+}
+
+
 MasterState::MasterState(
 	Environment &env,
 	Config &config,
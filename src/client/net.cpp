@@ -226,14 +226,6 @@ bool ChunkTransmission::Compressed() const noexcept {
 
 namespace {
 
-UDPsocket client_bind(Uint16 port) {
-	UDPsocket sock = SDLNet_UDP_Open(port);
-	if (!sock) {
-		throw NetError("SDLNet_UDP_Open");
-	}
-	return sock;
-}
-
 IPaddress client_resolve(const char *host, Uint16 port) {
 	IPaddress addr;
 	if (SDLNet_ResolveHost(&addr, host, port) != 0) {
@@ -250,34 +242,33 @@ IPaddress client_resolve(const char *host, Uint16 port) {
 #pragma GCC diagnostic ignored "-Wmissing-field-initializers"
 Client::Client(const Config::Network &conf)
 : conn(client_resolve(conf.host.c_str(), conf.port))
-, client_sock(client_bind(0))
+, client_sock(0)
 , client_pack{ -1, nullptr, 0 } {
 #pragma GCC diagnostic pop
 	client_pack.data = new Uint8[sizeof(Packet)];
 	client_pack.maxlen = sizeof(Packet);
+	client_sock.Impair(udp::Impairment::Parse(conf.impairment));
+	client_sock.StartThread();
+	client_sock.Attach(conn);
 	// establish connection
 	SendPing();
 }
 
 Client::~Client() {
+	client_sock.Detach(conn);
 	delete[] client_pack.data;
-	SDLNet_UDP_Close(client_sock);
 }
 
 
 void Client::Handle() {
-	int result = SDLNet_UDP_Recv(client_sock, &client_pack);
-	while (result > 0) {
-		HandlePacket(client_pack);
-		result = SDLNet_UDP_Recv(client_sock, &client_pack);
-	}
-	if (result == -1) {
-		// a boo boo happened
-		throw NetError("SDLNet_UDP_Recv");
+	for (size_t count = client_sock.Receive(); count > 0; count = client_sock.Receive()) {
+		for (size_t i = 0; i < count; ++i) {
+			HandlePacket(client_sock.Received(i), client_sock.ReceivedAt(i), client_sock.Filtered(i));
+		}
 	}
 }
 
-void Client::HandlePacket(const UDPpacket &udp_pack) {
+void Client::HandlePacket(const UDPpacket &udp_pack, Uint32 stamp, bool filtered) {
 	if (!conn.Matches(udp_pack.address)) {
 		// packet came from somewhere else, drop
 		return;
@@ -288,7 +279,11 @@ void Client::HandlePacket(const UDPpacket &udp_pack) {
 		return;
 	}
 
-	conn.Received(udp_pack);
+	if (filtered) {
+		conn.Deliver(udp_pack);
+	} else {
+		conn.Received(udp_pack, stamp);
+	}
 }
 
 void Client::Update(int dt) {
@@ -298,14 +293,23 @@ void Client::Update(int dt) {
 	}
 }
 
+uint16_t Client::Send() {
+	uint16_t seq = conn.Send(client_pack, client_sock);
+	// there's only a handful of packets per frame on the client side,
+	// not worth holding them back
+	client_sock.Flush();
+	return seq;
+}
+
 uint16_t Client::SendPing() {
-	return conn.SendPing(client_pack, client_sock);
+	Packet::Make<Packet::Ping>(client_pack);
+	return Send();
 }
 
 uint16_t Client::SendLogin(const string &name) {
 	auto pack = Packet::Make<Packet::Login>(client_pack);
 	pack.WritePlayerName(name);
-	return conn.Send(client_pack, client_sock);
+	return Send();
 }
 
 uint16_t Client::SendPlayerUpdate(
@@ -321,12 +325,12 @@ uint16_t Client::SendPlayerUpdate(
 	pack.WriteMovement(movement);
 	pack.WriteActions(actions);
 	pack.WriteSlot(slot);
-	return conn.Send(client_pack, client_sock);
+	return Send();
 }
 
 uint16_t Client::SendPart() {
 	Packet::Make<Packet::Part>(client_pack);
-	return conn.Send(client_pack, client_sock);
+	return Send();
 }
 
 uint16_t Client::SendChunkRequest(
@@ -334,7 +338,7 @@ uint16_t Client::SendChunkRequest(
 ) {
 	auto pack = Packet::Make<Packet::ChunkBegin>(client_pack);
 	pack.WriteChunkCoords(coords);
-	return conn.Send(client_pack, client_sock);
+	return Send();
 }
 
 uint16_t Client::SendMessage(
@@ -347,7 +351,7 @@ uint16_t Client::SendMessage(
 	pack.WriteReferral(ref);
 	pack.WriteMessage(msg);
 	client_pack.len = sizeof(Packet::Header) + Packet::Message::GetSize(msg);
-	return conn.Send(client_pack, client_sock);
+	return Send();
 }
 
 NetworkedInput::NetworkedInput(World &world, Player &player, Client &client)
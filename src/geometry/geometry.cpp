@@ -5,6 +5,9 @@
 
 #include <limits>
 #include <ostream>
+#ifdef __SSE__
+#  include <xmmintrin.h>
+#endif
 #include <glm/gtx/io.hpp>
 #include <glm/gtx/matrix_cross_product.hpp>
 #include <glm/gtx/optimum_pow.hpp>
@@ -277,4 +280,77 @@ bool CullTest(const AABB &box, const Frustum &frustum) noexcept {
 	return false;
 }
 
+bool ContainTest(const AABB &box, const Frustum &frustum) noexcept {
+	for (const Plane &plane : frustum.plane) {
+		const glm::vec3 fp(
+			((plane.normal.x > 0.0f) ? box.min.x : box.max.x),
+			((plane.normal.y > 0.0f) ? box.min.y : box.max.y),
+			((plane.normal.z > 0.0f) ? box.min.z : box.max.z)
+		);
+		// farthest point on the "outside" means the box crosses the plane
+		if (glm::dot(plane.normal, fp) < -plane.dist) return false;
+	}
+	return true;
+}
+
+std::size_t CullBatch(
+	const glm::vec3 &size,
+	const float *x,
+	const float *y,
+	const float *z,
+	std::size_t count,
+	const Frustum &frustum,
+	std::size_t *visible
+) noexcept {
+	// with all boxes the same size, the corner nearest to a plane sits
+	// at the same offset from the min corner for every box, so that
+	// part of the dot product can be folded into the plane's distance
+	float nx[6], ny[6], nz[6], d[6];
+	for (int p = 0; p < 6; ++p) {
+		const Plane &plane = frustum.plane[p];
+		nx[p] = plane.normal.x;
+		ny[p] = plane.normal.y;
+		nz[p] = plane.normal.z;
+		d[p] = plane.dist
+			+ ((nx[p] > 0.0f) ? nx[p] * size.x : 0.0f)
+			+ ((ny[p] > 0.0f) ? ny[p] * size.y : 0.0f)
+			+ ((nz[p] > 0.0f) ? nz[p] * size.z : 0.0f);
+	}
+
+	std::size_t num_visible = 0;
+	std::size_t i = 0;
+#ifdef __SSE__
+	const __m128 zero = _mm_setzero_ps();
+	for (; i + 4 <= count; i += 4) {
+		const __m128 bx = _mm_loadu_ps(x + i);
+		const __m128 by = _mm_loadu_ps(y + i);
+		const __m128 bz = _mm_loadu_ps(z + i);
+		__m128 outside = zero;
+		for (int p = 0; p < 6; ++p) {
+			__m128 dp = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(bx, _mm_set1_ps(nx[p])), _mm_mul_ps(by, _mm_set1_ps(ny[p]))),
+				_mm_add_ps(_mm_mul_ps(bz, _mm_set1_ps(nz[p])), _mm_set1_ps(d[p]))
+			);
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(dp, zero));
+		}
+		const int mask = _mm_movemask_ps(outside);
+		for (int j = 0; j < 4; ++j) {
+			if (!(mask & (1 << j))) {
+				visible[num_visible++] = i + j;
+			}
+		}
+	}
+#endif
+	for (; i < count; ++i) {
+		bool outside = false;
+		for (int p = 0; p < 6 && !outside; ++p) {
+			outside = nx[p] * x[i] + ny[p] * y[i] + nz[p] * z[i] + d[p] < 0.0f;
+		}
+		if (!outside) {
+			visible[num_visible++] = i;
+		}
+	}
+	return num_visible;
+}
+
 }
@@ -4,6 +4,7 @@
 #include "../graphics/glm.hpp"
 
 #include <algorithm>
+#include <cstddef>
 #include <iosfwd>
 #include <glm/gtx/norm.hpp>
 
@@ -152,6 +153,22 @@ std::ostream &operator <<(std::ostream &, const Frustum &);
 
 bool CullTest(const AABB &box, const glm::mat4 &) noexcept;
 bool CullTest(const AABB &box, const Frustum &) noexcept;
+/// true if the box lies completely inside the frustum
+bool ContainTest(const AABB &box, const Frustum &) noexcept;
+
+/// test count boxes of equal size, given by their min corners in
+/// separate coordinate arrays, against the frustum four at a time
+/// indices of the boxes that survive are written to visible, which
+/// must have room for count entries
+/// @return the number of visible boxes
+std::size_t CullBatch(
+	const glm::vec3 &size,
+	const float *x,
+	const float *y,
+	const float *z,
+	std::size_t count,
+	const Frustum &,
+	std::size_t *visible) noexcept;
 
 }
 
@@ -0,0 +1,55 @@
+#ifndef BLANK_GRAPHICS_ARENAALLOCATOR_HPP_
+#define BLANK_GRAPHICS_ARENAALLOCATOR_HPP_
+
+#include <cstddef>
+#include <vector>
+
+
+namespace blank {
+
+/// Hands out ranges of a linear buffer in power of two size classes.
+/// Freed ranges are kept in a free list per class and reused by the
+/// next allocation of the same class, so the buffer only grows until
+/// the working set is reached. Sizes and offsets are in elements.
+class ArenaAllocator {
+
+public:
+	struct Range {
+		std::size_t offset;
+		/// capacity of the range, 0 if nothing is allocated
+		std::size_t size;
+		Range() noexcept : offset(0), size(0) { }
+		Range(std::size_t o, std::size_t s) noexcept : offset(o), size(s) { }
+		bool Empty() const noexcept { return size == 0; }
+	};
+
+public:
+	explicit ArenaAllocator(std::size_t min_size = 64) noexcept;
+
+	/// get a range of at least n elements, n == 0 yields an empty range
+	Range Allocate(std::size_t n);
+	/// return given range to the free list and clear it
+	void Free(Range &);
+
+	/// end of the highest range handed out so far, the backing buffer
+	/// must be at least this big
+	std::size_t Top() const noexcept { return top; }
+	/// number of elements waiting in free lists
+	std::size_t Idle() const noexcept;
+
+	/// size of the class a request for n elements ends up in
+	std::size_t ClassSize(std::size_t n) const noexcept { return min_size << ClassOf(n); }
+
+private:
+	std::size_t ClassOf(std::size_t n) const noexcept;
+
+private:
+	std::size_t min_size;
+	std::size_t top;
+	std::vector<std::vector<std::size_t>> free;
+
+};
+
+}
+
+#endif
@@ -10,6 +10,7 @@
 namespace blank {
 
 class ArrayTexture;
+class VolumeTexture;
 
 class BlockLighting {
 
@@ -19,6 +20,10 @@ public:
 	void Activate() noexcept;
 
 	void SetTexture(ArrayTexture &) noexcept;
+	/// take light levels from given cubic volume instead of the vertices,
+	/// origin is where the scene origin falls in the volume in texels
+	void SetLightVolume(VolumeTexture &, const glm::vec3 &origin) noexcept;
+	void DisableLightVolume() noexcept;
 	void SetFogDensity(float) noexcept;
 
 	void SetM(const glm::mat4 &m) noexcept;
@@ -41,6 +46,10 @@ private:
 	GLuint mv_handle;
 	GLuint mvp_handle;
 	GLuint sampler_handle;
+	GLuint light_sampler_handle;
+	GLuint light_volume_handle;
+	GLuint light_origin_handle;
+	GLuint light_scale_handle;
 	GLuint light_direction_handle;
 	GLuint light_color_handle;
 	GLuint fog_density_handle;
@@ -1,8 +1,8 @@
 #ifndef BLANK_GRAPHICS_BLOCKMESH_HPP_
 #define BLANK_GRAPHICS_BLOCKMESH_HPP_
 
+#include "ArenaAllocator.hpp"
 #include "glm.hpp"
-#include "VertexArray.hpp"
 
 #include <vector>
 #include <GL/glew.h>
@@ -10,6 +10,9 @@
 
 namespace blank {
 
+class BlockMeshArena;
+
+/// Handle to a mesh stored in a BlockMeshArena.
 class BlockMesh {
 
 public:
@@ -31,7 +34,8 @@ public:
 		ATTRIB_HSL,
 		ATTRIB_RGB,
 		ATTRIB_LIGHT,
-		ATTRIB_INDEX,
+		/// per mesh translation, not part of Vertex
+		ATTRIB_OFFSET,
 		ATTRIB_COUNT,
 	};
 
@@ -64,21 +68,57 @@ public:
 
 	};
 
-	using VAO = VertexArray<ATTRIB_COUNT>;
+	using PackedPosition = TVEC3<unsigned short, glm::precision(0)>;
+	using PackedTexCoord = TVEC3<unsigned short, glm::precision(0)>;
+	using PackedLight = unsigned char;
+
+	/// packed layout of a vertex in the arena's buffer, 20 bytes
+	/// BlockLighting's vertex shader takes its scales from here
+	struct Vertex {
+		/// fixed point with 11 fractional bits, offset by position_bias
+		/// so blocks sticking out of the chunk a little are covered
+		PackedPosition position;
+		/// UV in fixed point with 12 fractional bits, layer as is
+		PackedTexCoord tex_coord;
+		ColorMod hsl_mod;
+		ColorMod rgb_mod;
+		/// fixed point with 4 fractional bits
+		PackedLight light;
+	};
+
+	static constexpr float position_scale = 2048.0f;
+	static constexpr float position_bias = 8.0f;
+	static constexpr float tex_coord_scale = 4096.0f;
+	static constexpr float light_scale = 16.0f;
+
+	static Vertex Pack(const Position &, const TexCoord &, const ColorMod &hsl, const ColorMod &rgb, Light) noexcept;
+
+public:
+	explicit BlockMesh(BlockMeshArena &) noexcept;
+	~BlockMesh() noexcept;
+
+	BlockMesh(const BlockMesh &) = delete;
+	BlockMesh &operator =(const BlockMesh &) = delete;
+
+	BlockMesh(BlockMesh &&) noexcept;
+	BlockMesh &operator =(BlockMesh &&) noexcept;
 
 public:
 	void Update(const Buffer &) noexcept;
 
 	bool Empty() const noexcept {
-		return vao.Empty();
+		return idx_count == 0;
 	}
 
-	void Draw() const noexcept {
-		vao.DrawTriangleElements();
-	}
+	/// add this mesh to the arena's batch, translated by offset
+	void Queue(const glm::vec3 &offset) const;
 
 private:
-	VAO vao;
+	BlockMeshArena *arena;
+	ArenaAllocator::Range vertices;
+	ArenaAllocator::Range indices;
+	std::size_t idx_count;
+	GLenum idx_type;
 
 };
 
@@ -0,0 +1,112 @@
+#ifndef BLANK_GRAPHICS_BLOCKMESHARENA_HPP_
+#define BLANK_GRAPHICS_BLOCKMESHARENA_HPP_
+
+#include "ArenaAllocator.hpp"
+#include "BlockMesh.hpp"
+#include "glm.hpp"
+
+#include <vector>
+#include <GL/glew.h>
+
+
+namespace blank {
+
+/// Shared GPU storage for block meshes: one interleaved vertex buffer
+/// and one index buffer behind a single VAO. Meshes get sub ranges of
+/// those and update them in place with glBufferSubData. Running out of
+/// space doubles the affected buffer and copies the old contents over
+/// on the GPU, so ranges stay valid.
+/// The index buffer is managed in 16 bit units. Meshes with few enough
+/// vertices get 16 bit indices, others take up two units per index.
+/// Meshes are drawn in batches. Where available, a batch is submitted
+/// with glMultiDrawElementsIndirect and each mesh's offset is fed in
+/// as an instanced attribute. Otherwise the offset is set as a constant
+/// attribute and meshes are drawn one by one, which still avoids any
+/// uniform updates.
+class BlockMeshArena {
+
+public:
+	using IndexUnit = unsigned short;
+
+public:
+	explicit BlockMeshArena(std::size_t vertices = 1 << 16, std::size_t index_units = 1 << 18);
+	~BlockMeshArena() noexcept;
+
+	BlockMeshArena(const BlockMeshArena &) = delete;
+	BlockMeshArena &operator =(const BlockMeshArena &) = delete;
+
+public:
+	/// must be called before drawing any meshes from this arena
+	void Bind() const noexcept;
+
+	/// true if batches are drawn with a single indirect call per index type
+	bool Indirect() const noexcept { return indirect; }
+	/// add given mesh to the batch, translated by offset
+	void Queue(
+		const ArenaAllocator::Range &vtx,
+		const ArenaAllocator::Range &idx,
+		std::size_t count,
+		GLenum type,
+		const glm::vec3 &offset
+	);
+	/// draw and clear the batch, the arena must be bound
+	void DrawQueued() noexcept;
+	/// number of draw calls issued by the last DrawQueued()
+	std::size_t DrawCalls() const noexcept { return draw_calls; }
+	/// bytes sent to the GPU so far, mesh data and batch parameters
+	std::size_t UploadedBytes() const noexcept { return uploaded; }
+
+	/// pack given buffer and store it in vtx and idx, which are
+	/// reallocated if they don't fit (or are way too big)
+	/// @return the type of the indices as stored
+	GLenum Upload(ArenaAllocator::Range &vtx, ArenaAllocator::Range &idx, const BlockMesh::Buffer &) noexcept;
+	/// give both ranges back
+	void Release(ArenaAllocator::Range &vtx, ArenaAllocator::Range &idx) noexcept;
+
+private:
+	static bool Fits(const ArenaAllocator &, const ArenaAllocator::Range &, std::size_t n) noexcept;
+	/// make sure buffer can hold at least needed elements
+	/// @return true if the buffer had to be replaced
+	static bool Reserve(GLuint &buffer, std::size_t &capacity, std::size_t needed, std::size_t element_size) noexcept;
+	void Setup() noexcept;
+
+private:
+	/// layout mandated by glMultiDrawElementsIndirect
+	struct Command {
+		GLuint count;
+		GLuint instance_count;
+		GLuint first_index;
+		GLint base_vertex;
+		/// index into offsets
+		GLuint base_instance;
+	};
+
+private:
+	bool indirect;
+
+	GLuint array_id;
+	GLuint vertex_id;
+	GLuint index_id;
+	std::size_t vertex_capacity;
+	std::size_t index_capacity;
+
+	ArenaAllocator vertex_alloc;
+	ArenaAllocator index_alloc;
+
+	std::vector<BlockMesh::Vertex> staging;
+	std::vector<IndexUnit> staging_indices;
+
+	GLuint offset_id;
+	GLuint command_id;
+	std::vector<glm::vec3> offsets;
+	std::vector<Command> short_commands;
+	std::vector<Command> int_commands;
+
+	std::size_t draw_calls;
+	std::size_t uploaded;
+
+};
+
+}
+
+#endif
@@ -20,6 +20,8 @@ public:
 	const glm::mat4 &Projection() const noexcept { return projection; }
 	const glm::mat4 &View() const noexcept { return view; }
 	void View(const glm::mat4 &v) noexcept;
+	/// position of the eye in the view's reference frame
+	const glm::vec3 &Position() const noexcept { return position; }
 
 private:
 	void UpdateProjection() noexcept;
@@ -32,6 +34,7 @@ private:
 
 	glm::mat4 projection;
 	glm::mat4 view;
+	glm::vec3 position;
 
 };
 
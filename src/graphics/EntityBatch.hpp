@@ -0,0 +1,62 @@
+#ifndef BLANK_GRAPHICS_ENTITYBATCH_HPP_
+#define BLANK_GRAPHICS_ENTITYBATCH_HPP_
+
+#include "InstancedLighting.hpp"
+#include "glm.hpp"
+
+#include <cstddef>
+#include <vector>
+#include <GL/glew.h>
+
+
+namespace blank {
+
+class EntityMesh;
+
+/// Collects entity meshes to draw during a frame and draws each
+/// distinct mesh once with all of its instances.
+/// The instance buffer is only created on first draw, so it's safe to
+/// keep one around where there's no GL context.
+class EntityBatch {
+
+public:
+	EntityBatch();
+	~EntityBatch() noexcept;
+
+	EntityBatch(const EntityBatch &) = delete;
+	EntityBatch &operator =(const EntityBatch &) = delete;
+
+public:
+	/// light for all meshes added after this call
+	void SetLight(const glm::vec3 &direction, const glm::vec3 &color, const glm::vec3 &ambient) noexcept;
+	/// queue mesh for drawing with given transform and the current light
+	void Add(const EntityMesh &, const glm::mat4 &M);
+
+	bool Empty() const noexcept { return entries.empty(); }
+
+	/// draw and clear everything queued, InstancedLighting must be active
+	void Draw();
+
+	/// number of draw calls issued by the last Draw()
+	std::size_t DrawCalls() const noexcept { return draw_calls; }
+	/// bytes of instance data uploaded by the last Draw()
+	std::size_t UploadedBytes() const noexcept { return uploaded; }
+
+private:
+	struct Entry {
+		const EntityMesh *mesh;
+		InstancedLighting::Instance instance;
+	};
+	std::vector<Entry> entries;
+	std::vector<InstancedLighting::Instance> upload;
+	InstancedLighting::Instance current;
+
+	GLuint buffer;
+	std::size_t draw_calls;
+	std::size_t uploaded;
+
+};
+
+}
+
+#endif
@@ -73,10 +73,19 @@ public:
 		return vao.Empty();
 	}
 
+	/// bind the VAO, e.g. for setting up instance attributes
+	void Bind() const noexcept {
+		vao.Bind();
+	}
+
 	void Draw() const noexcept {
 		vao.DrawTriangleElements();
 	}
 
+	void DrawInstanced(std::size_t instances) const noexcept {
+		vao.DrawTriangleElementsInstanced(instances);
+	}
+
 private:
 	VAO vao;
 
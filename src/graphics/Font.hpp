@@ -1,8 +1,12 @@
 #ifndef BLANK_GRAPHICS_FONT_HPP_
 #define BLANK_GRAPHICS_FONT_HPP_
 
+#include "align.hpp"
 #include "glm.hpp"
+#include "SpriteMesh.hpp"
 
+#include <memory>
+#include <unordered_map>
 #include <SDL_ttf.h>
 
 
@@ -63,9 +67,49 @@ public:
 	Texture Render(const char *) const;
 	void Render(const char *, Texture &) const;
 
+	/// a glyph's cell in the atlas, as wide as its advance and as high
+	/// as the font
+	struct Glyph {
+		glm::vec2 tex_begin;
+		glm::vec2 tex_end;
+		glm::vec2 size;
+	};
+	/// get given code point's glyph, rasterizing it into the atlas if
+	/// it isn't there yet
+	const Glyph &GetGlyph(Uint32) const;
+	/// texture holding all glyphs rasterized so far
+	Texture &Atlas() const;
+	/// changes whenever the atlas had to be cleared, glyphs obtained
+	/// earlier are invalid then
+	unsigned int AtlasGeneration() const noexcept { return atlas_generation; }
+
+	/// append a quad per glyph of given text to buf, offset by -pivot
+	/// the buffer's contents are only valid for the atlas generation
+	/// returned in generation
+	/// @return the size of the text
+	glm::vec2 Layout(
+		const char *,
+		SpriteMesh::Buffer &buf,
+		Gravity pivot,
+		unsigned int &generation
+	) const;
+	/// width of given text as Layout() puts it, one glyph cell after
+	/// the other without kerning, unlike TextSize()
+	float LayoutWidth(const char *) const;
+
+private:
+	void ClearAtlas() const;
+
 private:
 	TTF_Font *handle;
 
+	// created on first use
+	mutable std::unique_ptr<Texture> atlas;
+	mutable std::unordered_map<Uint32, Glyph> glyphs;
+	// where the next glyph goes
+	mutable glm::ivec2 atlas_pen;
+	mutable unsigned int atlas_generation;
+
 };
 
 }
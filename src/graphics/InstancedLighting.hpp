@@ -0,0 +1,70 @@
+#ifndef BLANK_GRAPHICS_INSTANCEDLIGHTING_HPP_
+#define BLANK_GRAPHICS_INSTANCEDLIGHTING_HPP_
+
+#include "glm.hpp"
+#include "Program.hpp"
+
+#include <cstddef>
+#include <GL/glew.h>
+
+
+namespace blank {
+
+/// Same lighting as DirectionalLighting, but the model transform and
+/// light parameters come in as per instance vertex attributes, so
+/// many copies of a mesh can be drawn with one call.
+class InstancedLighting {
+
+public:
+	/// layout of the per instance attributes
+	struct Instance {
+		glm::mat4 M;
+		glm::vec3 light_direction;
+		glm::vec3 light_color;
+		glm::vec3 ambient_color;
+	};
+
+	enum Attribute {
+		// mat4 takes up 4 locations
+		ATTRIB_M = 5,
+		ATTRIB_LIGHT_DIRECTION = 9,
+		ATTRIB_LIGHT_COLOR,
+		ATTRIB_AMBIENT_COLOR,
+	};
+
+public:
+	InstancedLighting();
+
+	void Activate() noexcept;
+
+	void SetFogDensity(float) noexcept;
+
+	void SetProjection(const glm::mat4 &p) noexcept;
+	void SetView(const glm::mat4 &v) noexcept;
+	void SetVP(const glm::mat4 &v, const glm::mat4 &p) noexcept;
+
+	const glm::mat4 &Projection() const noexcept { return projection; }
+	const glm::mat4 &View() const noexcept { return view; }
+	const glm::mat4 &GetVP() const noexcept { return vp; }
+
+	/// point the bound VAO's instance attributes at the buffer bound to
+	/// GL_ARRAY_BUFFER, starting offset bytes in
+	static void InstanceAttributes(std::size_t offset) noexcept;
+
+private:
+	Program program;
+
+	glm::mat4 projection;
+	glm::mat4 view;
+	glm::mat4 vp;
+
+	GLuint v_handle;
+	GLuint vp_handle;
+	GLuint sampler_handle;
+	GLuint fog_density_handle;
+
+};
+
+}
+
+#endif
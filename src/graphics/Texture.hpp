@@ -31,6 +31,9 @@ public:
 
 	void Data(const SDL_Surface &, bool pad2 = true) noexcept;
 	void Data(GLsizei w, GLsizei h, const Format &, GLvoid *data) noexcept;
+	/// replace part of the texture with given surface, which must have
+	/// the texture's format and fit at x,y
+	void Data(GLint x, GLint y, const SDL_Surface &) noexcept;
 
 	static void UnpackAlignment(GLint) noexcept;
 	static int UnpackAlignmentFromPitch(int) noexcept;
@@ -36,6 +36,7 @@ public:
 
 	void DrawLineElements() const noexcept;
 	void DrawTriangleElements() const noexcept;
+	void DrawTriangleElementsInstanced(std::size_t instances) const noexcept;
 
 private:
 	void BindAttribute(std::size_t which) const noexcept;
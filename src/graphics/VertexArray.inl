@@ -130,4 +130,16 @@ void VertexArray<N>::DrawTriangleElements() const noexcept {
 	);
 }
 
+template<std::size_t N>
+void VertexArray<N>::DrawTriangleElementsInstanced(std::size_t instances) const noexcept {
+	Bind();
+	glDrawElementsInstanced(
+		GL_TRIANGLES, // how
+		idx_count,    // count
+		idx_type,     // type
+		nullptr,      // offset
+		instances     // instance count
+	);
+}
+
 }
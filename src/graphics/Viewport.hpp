@@ -8,6 +8,7 @@
 #include "Canvas.hpp"
 #include "DirectionalLighting.hpp"
 #include "glm.hpp"
+#include "InstancedLighting.hpp"
 #include "PlainColor.hpp"
 #include "SkyBoxShader.hpp"
 
@@ -52,9 +53,11 @@ public:
 
 	void OffsetCamera(const glm::vec3 &o) noexcept { cam_offset = o; }
 	const glm::vec3 &CameraOffset() const noexcept { return cam_offset; }
+	/// eye position relative to the current world position's chunk
+	const glm::vec3 &CameraPosition() const noexcept { return cam.Position(); }
 
 	BlockLighting &ChunkProgram() noexcept;
-	DirectionalLighting &EntityProgram() noexcept;
+	InstancedLighting &EntityProgram() noexcept;
 	DirectionalLighting &HUDProgram() noexcept;
 	PlainColor &WorldColorProgram() noexcept;
 	PlainColor &HUDColorProgram() noexcept;
@@ -76,6 +79,7 @@ private:
 
 	BlockLighting chunk_prog;
 	DirectionalLighting entity_prog;
+	InstancedLighting instanced_prog;
 	PlainColor color_prog;
 	SkyBoxShader sky_prog;
 	BlendedSprite sprite_prog;
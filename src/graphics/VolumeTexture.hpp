@@ -0,0 +1,43 @@
+#ifndef BLANK_GRAPHICS_VOLUMETEXTURE_HPP_
+#define BLANK_GRAPHICS_VOLUMETEXTURE_HPP_
+
+#include "TextureBase.hpp"
+
+#include <GL/glew.h>
+
+
+namespace blank {
+
+/// 3D texture with a single unsigned byte per texel, which
+/// shaders read as a normalized red channel
+class VolumeTexture
+: public TextureBase<GL_TEXTURE_3D> {
+
+public:
+	VolumeTexture();
+	~VolumeTexture();
+
+	VolumeTexture(VolumeTexture &&) noexcept;
+	VolumeTexture &operator =(VolumeTexture &&) noexcept;
+
+	VolumeTexture(const VolumeTexture &) = delete;
+	VolumeTexture &operator =(const VolumeTexture &) = delete;
+
+public:
+	GLsizei Width() const noexcept { return width; }
+	GLsizei Height() const noexcept { return height; }
+	GLsizei Depth() const noexcept { return depth; }
+
+	/// contents are undefined until written
+	void Reserve(GLsizei w, GLsizei h, GLsizei d) noexcept;
+	/// replace the w*h*d box at x,y,z, rows must be a multiple of 4 bytes
+	void Data(GLint x, GLint y, GLint z, GLsizei w, GLsizei h, GLsizei d, const GLubyte *data) noexcept;
+
+private:
+	GLsizei width, height, depth;
+
+};
+
+}
+
+#endif
@@ -0,0 +1,345 @@
+#include "ArenaAllocator.hpp"
+#include "BlockMeshArena.hpp"
+
+#include "gl_traits.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+
+
+namespace blank {
+
+ArenaAllocator::ArenaAllocator(std::size_t min_size) noexcept
+: min_size(std::max(min_size, std::size_t(1)))
+, top(0)
+, free() {
+
+}
+
+std::size_t ArenaAllocator::ClassOf(std::size_t n) const noexcept {
+	std::size_t cls = 0;
+	for (std::size_t size = min_size; size < n; size <<= 1) {
+		++cls;
+	}
+	return cls;
+}
+
+ArenaAllocator::Range ArenaAllocator::Allocate(std::size_t n) {
+	if (n == 0) {
+		return Range();
+	}
+	const std::size_t cls = ClassOf(n);
+	const std::size_t size = min_size << cls;
+	if (cls < free.size() && !free[cls].empty()) {
+		const std::size_t offset = free[cls].back();
+		free[cls].pop_back();
+		return Range(offset, size);
+	}
+	const std::size_t offset = top;
+	top += size;
+	return Range(offset, size);
+}
+
+void ArenaAllocator::Free(Range &range) {
+	if (range.Empty()) {
+		return;
+	}
+	const std::size_t cls = ClassOf(range.size);
+	if (cls >= free.size()) {
+		free.resize(cls + 1);
+	}
+	free[cls].push_back(range.offset);
+	range = Range();
+}
+
+std::size_t ArenaAllocator::Idle() const noexcept {
+	std::size_t idle = 0;
+	for (std::size_t cls = 0; cls < free.size(); ++cls) {
+		idle += free[cls].size() * (min_size << cls);
+	}
+	return idle;
+}
+
+
+namespace {
+
+template<class T>
+void AttributePointer(
+	GLuint which,
+	std::size_t offset,
+	bool normalized = false,
+	GLsizei stride = sizeof(BlockMesh::Vertex)
+) noexcept {
+	glEnableVertexAttribArray(which);
+	glVertexAttribPointer(
+		which,                                    // program location
+		gl_traits<T>::size,                       // element size
+		gl_traits<T>::type,                       // element type
+		normalized,                               // normalize to [-1,1] or [0,1] for unsigned types
+		stride,                                   // stride
+		reinterpret_cast<const GLvoid *>(offset)  // offset
+	);
+}
+
+}
+
+BlockMeshArena::BlockMeshArena(std::size_t vertices, std::size_t index_units)
+// base instance has to be honored for the offsets to line up
+: indirect(GLEW_VERSION_4_3 || (GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance))
+, array_id(0)
+, vertex_id(0)
+, index_id(0)
+, vertex_capacity(0)
+, index_capacity(0)
+, vertex_alloc(64)
+, index_alloc(96)
+, staging()
+, staging_indices()
+, offset_id(0)
+, command_id(0)
+, offsets()
+, short_commands()
+, int_commands()
+, draw_calls(0)
+, uploaded(0) {
+	glGenVertexArrays(1, &array_id);
+	if (indirect) {
+		glGenBuffers(1, &offset_id);
+		glGenBuffers(1, &command_id);
+	}
+	Reserve(vertex_id, vertex_capacity, vertices, sizeof(BlockMesh::Vertex));
+	Reserve(index_id, index_capacity, index_units, sizeof(IndexUnit));
+	Setup();
+}
+
+BlockMeshArena::~BlockMeshArena() noexcept {
+	if (indirect) {
+		glDeleteBuffers(1, &command_id);
+		glDeleteBuffers(1, &offset_id);
+	}
+	glDeleteBuffers(1, &index_id);
+	glDeleteBuffers(1, &vertex_id);
+	glDeleteVertexArrays(1, &array_id);
+}
+
+void BlockMeshArena::Bind() const noexcept {
+	glBindVertexArray(array_id);
+}
+
+bool BlockMeshArena::Fits(const ArenaAllocator &alloc, const ArenaAllocator::Range &range, std::size_t n) noexcept {
+	// allow for one class of slack so meshes hovering around a class
+	// boundary don't move back and forth
+	return range.size >= n && range.size <= 2 * alloc.ClassSize(n);
+}
+
+bool BlockMeshArena::Reserve(GLuint &buffer, std::size_t &capacity, std::size_t needed, std::size_t element_size) noexcept {
+	if (needed <= capacity) {
+		return false;
+	}
+	const std::size_t new_capacity = std::max(capacity * 2, needed);
+	GLuint new_buffer = 0;
+	glGenBuffers(1, &new_buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, new_buffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, new_capacity * element_size, nullptr, GL_DYNAMIC_DRAW);
+	if (capacity > 0) {
+		glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, capacity * element_size);
+	}
+	glDeleteBuffers(1, &buffer);
+	buffer = new_buffer;
+	capacity = new_capacity;
+	return true;
+}
+
+void BlockMeshArena::Setup() noexcept {
+	using Vertex = BlockMesh::Vertex;
+	glBindVertexArray(array_id);
+	glBindBuffer(GL_ARRAY_BUFFER, vertex_id);
+	// fixed point values arrive in the shader as is and get scaled there
+	AttributePointer<BlockMesh::PackedPosition>(BlockMesh::ATTRIB_VERTEX, offsetof(Vertex, position));
+	AttributePointer<BlockMesh::PackedTexCoord>(BlockMesh::ATTRIB_TEXCOORD, offsetof(Vertex, tex_coord));
+	AttributePointer<BlockMesh::ColorMod>(BlockMesh::ATTRIB_HSL, offsetof(Vertex, hsl_mod), true);
+	AttributePointer<BlockMesh::ColorMod>(BlockMesh::ATTRIB_RGB, offsetof(Vertex, rgb_mod), true);
+	AttributePointer<BlockMesh::PackedLight>(BlockMesh::ATTRIB_LIGHT, offsetof(Vertex, light));
+	if (indirect) {
+		glBindBuffer(GL_ARRAY_BUFFER, offset_id);
+		AttributePointer<glm::vec3>(BlockMesh::ATTRIB_OFFSET, 0, false, sizeof(glm::vec3));
+		glVertexAttribDivisor(BlockMesh::ATTRIB_OFFSET, 1);
+	}
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_id);
+}
+
+void BlockMeshArena::Queue(
+	const ArenaAllocator::Range &vtx,
+	const ArenaAllocator::Range &idx,
+	std::size_t count,
+	GLenum type,
+	const glm::vec3 &offset
+) {
+	Command cmd;
+	cmd.count = count;
+	cmd.instance_count = 1;
+	cmd.base_vertex = vtx.offset;
+	cmd.base_instance = offsets.size();
+	if (type == GL_UNSIGNED_SHORT) {
+		cmd.first_index = idx.offset;
+		short_commands.push_back(cmd);
+	} else {
+		cmd.first_index = idx.offset / (sizeof(BlockMesh::Index) / sizeof(IndexUnit));
+		int_commands.push_back(cmd);
+	}
+	offsets.push_back(offset);
+}
+
+void BlockMeshArena::DrawQueued() noexcept {
+	draw_calls = 0;
+	if (indirect) {
+		glBindBuffer(GL_ARRAY_BUFFER, offset_id);
+		glBufferData(GL_ARRAY_BUFFER, offsets.size() * sizeof(glm::vec3), offsets.data(), GL_STREAM_DRAW);
+		const std::size_t short_size = short_commands.size() * sizeof(Command);
+		const std::size_t int_size = int_commands.size() * sizeof(Command);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_id);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, short_size + int_size, nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, short_size, short_commands.data());
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, short_size, int_size, int_commands.data());
+		uploaded += offsets.size() * sizeof(glm::vec3) + short_size + int_size;
+		if (!short_commands.empty()) {
+			glMultiDrawElementsIndirect(
+				GL_TRIANGLES,          // how
+				GL_UNSIGNED_SHORT,     // type
+				nullptr,               // offset into command buffer
+				short_commands.size(), // command count
+				0                      // stride (tightly packed)
+			);
+			++draw_calls;
+		}
+		if (!int_commands.empty()) {
+			glMultiDrawElementsIndirect(
+				GL_TRIANGLES,
+				gl_traits<BlockMesh::Index>::type,
+				reinterpret_cast<const GLvoid *>(short_size),
+				int_commands.size(),
+				0
+			);
+			++draw_calls;
+		}
+	} else {
+		for (const Command &cmd : short_commands) {
+			glVertexAttrib3fv(BlockMesh::ATTRIB_OFFSET, &offsets[cmd.base_instance][0]);
+			glDrawElementsBaseVertex(
+				GL_TRIANGLES,
+				cmd.count,
+				GL_UNSIGNED_SHORT,
+				reinterpret_cast<const GLvoid *>(cmd.first_index * sizeof(IndexUnit)),
+				cmd.base_vertex
+			);
+		}
+		draw_calls += short_commands.size();
+		for (const Command &cmd : int_commands) {
+			glVertexAttrib3fv(BlockMesh::ATTRIB_OFFSET, &offsets[cmd.base_instance][0]);
+			glDrawElementsBaseVertex(
+				GL_TRIANGLES,
+				cmd.count,
+				gl_traits<BlockMesh::Index>::type,
+				reinterpret_cast<const GLvoid *>(cmd.first_index * sizeof(BlockMesh::Index)),
+				cmd.base_vertex
+			);
+		}
+		draw_calls += int_commands.size();
+	}
+	offsets.clear();
+	short_commands.clear();
+	int_commands.clear();
+}
+
+GLenum BlockMeshArena::Upload(
+	ArenaAllocator::Range &vtx,
+	ArenaAllocator::Range &idx,
+	const BlockMesh::Buffer &buf
+) noexcept {
+	const std::size_t num_vtx = buf.vertices.size();
+	const std::size_t num_idx = buf.indices.size();
+	const bool short_indices = num_vtx <= std::size_t(std::numeric_limits<IndexUnit>::max()) + 1;
+	const GLenum index_type = short_indices ? GL_UNSIGNED_SHORT : gl_traits<BlockMesh::Index>::type;
+	if (num_vtx == 0 || num_idx == 0) {
+		Release(vtx, idx);
+		return index_type;
+	}
+	const std::size_t num_units = short_indices ? num_idx : num_idx * (sizeof(BlockMesh::Index) / sizeof(IndexUnit));
+
+	if (!Fits(vertex_alloc, vtx, num_vtx)) {
+		vertex_alloc.Free(vtx);
+		vtx = vertex_alloc.Allocate(num_vtx);
+	}
+	if (!Fits(index_alloc, idx, num_units)) {
+		index_alloc.Free(idx);
+		// all size classes are multiples of the (even) minimum, so
+		// offsets are always suitably aligned for 32 bit indices
+		idx = index_alloc.Allocate(num_units);
+	}
+	const bool vertices_moved = Reserve(vertex_id, vertex_capacity, vertex_alloc.Top(), sizeof(BlockMesh::Vertex));
+	const bool indices_moved = Reserve(index_id, index_capacity, index_alloc.Top(), sizeof(IndexUnit));
+	if (vertices_moved || indices_moved) {
+		Setup();
+	}
+
+	// missing attributes are left at their defaults rather than read
+	// past the end of a short vector
+	const std::size_t complete = std::min({
+		num_vtx,
+		buf.tex_coords.size(),
+		buf.hsl_mods.size(),
+		buf.rgb_mods.size(),
+		buf.lights.size(),
+	});
+	staging.resize(num_vtx);
+	for (std::size_t i = 0; i < complete; ++i) {
+		staging[i] = BlockMesh::Pack(
+			buf.vertices[i],
+			buf.tex_coords[i],
+			buf.hsl_mods[i],
+			buf.rgb_mods[i],
+			buf.lights[i]
+		);
+	}
+	for (std::size_t i = complete; i < num_vtx; ++i) {
+		staging[i] = BlockMesh::Pack(
+			buf.vertices[i],
+			BlockMesh::TexCoord(0.0f),
+			BlockMesh::ColorMod(0, 255, 255),
+			BlockMesh::ColorMod(255, 255, 255),
+			0.0f
+		);
+	}
+	const GLvoid *index_data = buf.indices.data();
+	if (short_indices) {
+		staging_indices.assign(buf.indices.begin(), buf.indices.end());
+		index_data = staging_indices.data();
+	}
+
+	// going through the copy target keeps the VAO's bindings untouched
+	glBindBuffer(GL_COPY_WRITE_BUFFER, vertex_id);
+	glBufferSubData(
+		GL_COPY_WRITE_BUFFER,
+		vtx.offset * sizeof(BlockMesh::Vertex),
+		num_vtx * sizeof(BlockMesh::Vertex),
+		staging.data()
+	);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, index_id);
+	glBufferSubData(
+		GL_COPY_WRITE_BUFFER,
+		idx.offset * sizeof(IndexUnit),
+		num_units * sizeof(IndexUnit),
+		index_data
+	);
+	uploaded += num_vtx * sizeof(BlockMesh::Vertex) + num_units * sizeof(IndexUnit);
+	return index_type;
+}
+
+void BlockMeshArena::Release(ArenaAllocator::Range &vtx, ArenaAllocator::Range &idx) noexcept {
+	vertex_alloc.Free(vtx);
+	index_alloc.Free(idx);
+}
+
+}
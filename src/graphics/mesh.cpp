@@ -1,4 +1,6 @@
 #include "BlockMesh.hpp"
+#include "BlockMeshArena.hpp"
+#include "EntityBatch.hpp"
 #include "EntityMesh.hpp"
 #include "PrimitiveMesh.hpp"
 #include "SkyBoxMesh.hpp"
@@ -7,7 +9,9 @@
 #include "../geometry/primitive.hpp"
 
 #include <algorithm>
+#include <functional>
 #include <iostream>
+#include <limits>
 
 
 namespace blank {
@@ -38,6 +42,150 @@ void EntityMesh::Update(const Buffer &buf) noexcept {
 }
 
 
+EntityBatch::EntityBatch()
+: entries()
+, upload()
+, current()
+, buffer(0)
+, draw_calls(0)
+, uploaded(0) {
+	// same defaults as DirectionalLighting
+	SetLight(glm::vec3(-1.0f, -3.0f, -2.0f), glm::vec3(1.0f), glm::vec3(0.1f));
+}
+
+EntityBatch::~EntityBatch() noexcept {
+	if (buffer != 0) {
+		glDeleteBuffers(1, &buffer);
+	}
+}
+
+void EntityBatch::SetLight(const glm::vec3 &direction, const glm::vec3 &color, const glm::vec3 &ambient) noexcept {
+	// like DirectionalLighting, the shader wants the direction towards the light
+	current.light_direction = -direction;
+	current.light_color = color;
+	current.ambient_color = ambient;
+}
+
+void EntityBatch::Add(const EntityMesh &mesh, const glm::mat4 &M) {
+	if (mesh.Empty()) {
+		return;
+	}
+	entries.push_back({ &mesh, current });
+	entries.back().instance.M = M;
+}
+
+void EntityBatch::Draw() {
+	draw_calls = 0;
+	uploaded = 0;
+	if (entries.empty()) {
+		return;
+	}
+
+	std::stable_sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+		return std::less<const EntityMesh *>()(a.mesh, b.mesh);
+	});
+	upload.clear();
+	upload.reserve(entries.size());
+	for (const Entry &entry : entries) {
+		upload.push_back(entry.instance);
+	}
+
+	if (buffer == 0) {
+		glGenBuffers(1, &buffer);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	uploaded = upload.size() * sizeof(InstancedLighting::Instance);
+	glBufferData(GL_ARRAY_BUFFER, uploaded, upload.data(), GL_STREAM_DRAW);
+
+	for (std::size_t begin = 0, end = 0; begin < entries.size(); begin = end) {
+		const EntityMesh &mesh = *entries[begin].mesh;
+		end = begin + 1;
+		while (end < entries.size() && entries[end].mesh == &mesh) {
+			++end;
+		}
+		mesh.Bind();
+		InstancedLighting::InstanceAttributes(begin * sizeof(InstancedLighting::Instance));
+		mesh.DrawInstanced(end - begin);
+		++draw_calls;
+	}
+	entries.clear();
+}
+
+
+constexpr float BlockMesh::position_scale;
+constexpr float BlockMesh::position_bias;
+constexpr float BlockMesh::tex_coord_scale;
+constexpr float BlockMesh::light_scale;
+
+namespace {
+
+template<class T>
+T Quantize(float value, float scale) noexcept {
+	return T(glm::clamp(
+		value * scale + 0.5f,
+		0.0f,
+		float(std::numeric_limits<T>::max())
+	));
+}
+
+}
+
+BlockMesh::Vertex BlockMesh::Pack(
+	const Position &pos,
+	const TexCoord &tex,
+	const ColorMod &hsl,
+	const ColorMod &rgb,
+	Light light
+) noexcept {
+	Vertex vtx;
+	vtx.position.x = Quantize<unsigned short>(pos.x + position_bias, position_scale);
+	vtx.position.y = Quantize<unsigned short>(pos.y + position_bias, position_scale);
+	vtx.position.z = Quantize<unsigned short>(pos.z + position_bias, position_scale);
+	vtx.tex_coord.x = Quantize<unsigned short>(tex.x, tex_coord_scale);
+	vtx.tex_coord.y = Quantize<unsigned short>(tex.y, tex_coord_scale);
+	vtx.tex_coord.z = Quantize<unsigned short>(tex.z, 1.0f);
+	vtx.hsl_mod = hsl;
+	vtx.rgb_mod = rgb;
+	vtx.light = Quantize<PackedLight>(light, light_scale);
+	return vtx;
+}
+
+BlockMesh::BlockMesh(BlockMeshArena &arena) noexcept
+: arena(&arena)
+, vertices()
+, indices()
+, idx_count(0)
+, idx_type(GL_UNSIGNED_SHORT) {
+
+}
+
+BlockMesh::~BlockMesh() noexcept {
+	if (arena) {
+		arena->Release(vertices, indices);
+	}
+}
+
+BlockMesh::BlockMesh(BlockMesh &&other) noexcept
+: arena(other.arena)
+, vertices(other.vertices)
+, indices(other.indices)
+, idx_count(other.idx_count)
+, idx_type(other.idx_type) {
+	other.arena = nullptr;
+	other.vertices = ArenaAllocator::Range();
+	other.indices = ArenaAllocator::Range();
+	other.idx_count = 0;
+}
+
+BlockMesh &BlockMesh::operator =(BlockMesh &&other) noexcept {
+	std::swap(arena, other.arena);
+	std::swap(vertices, other.vertices);
+	std::swap(indices, other.indices);
+	std::swap(idx_count, other.idx_count);
+	std::swap(idx_type, other.idx_type);
+	return *this;
+}
+
 void BlockMesh::Update(const Buffer &buf) noexcept {
 #ifndef NDEBUG
 	if (buf.tex_coords.size() < buf.vertices.size()) {
@@ -54,13 +202,12 @@ void BlockMesh::Update(const Buffer &buf) noexcept {
 	}
 #endif
 
-	vao.Bind();
-	vao.PushAttribute(ATTRIB_VERTEX, buf.vertices);
-	vao.PushAttribute(ATTRIB_TEXCOORD, buf.tex_coords);
-	vao.PushAttribute(ATTRIB_HSL, buf.hsl_mods, true);
-	vao.PushAttribute(ATTRIB_RGB, buf.rgb_mods, true);
-	vao.PushAttribute(ATTRIB_LIGHT, buf.lights);
-	vao.PushIndices(ATTRIB_INDEX, buf.indices);
+	idx_type = arena->Upload(vertices, indices, buf);
+	idx_count = buf.indices.size();
+}
+
+void BlockMesh::Queue(const glm::vec3 &offset) const {
+	arena->Queue(vertices, indices, idx_count, idx_type, offset);
 }
 
 
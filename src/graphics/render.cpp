@@ -5,6 +5,7 @@
 #include "Texture.hpp"
 #include "TextureBase.hpp"
 #include "Viewport.hpp"
+#include "VolumeTexture.hpp"
 
 #include "../app/error.hpp"
 
@@ -13,12 +14,17 @@
 #include <iostream>
 #include <memory>
 #include <stdexcept>
+#include <vector>
 
 
 namespace blank {
 
 Font::Font(const char *src, int size, long index)
-: handle(TTF_OpenFontIndex(src, size, index)) {
+: handle(TTF_OpenFontIndex(src, size, index))
+, atlas()
+, glyphs()
+, atlas_pen(0)
+, atlas_generation(0) {
 	if (!handle) {
 		throw TTFError("TTF_OpenFontIndex");
 	}
@@ -31,12 +37,20 @@ Font::~Font() {
 }
 
 Font::Font(Font &&other) noexcept
-: handle(other.handle) {
+: handle(other.handle)
+, atlas(std::move(other.atlas))
+, glyphs(std::move(other.glyphs))
+, atlas_pen(other.atlas_pen)
+, atlas_generation(other.atlas_generation) {
 	other.handle = nullptr;
 }
 
 Font &Font::operator =(Font &&other) noexcept {
 	std::swap(handle, other.handle);
+	std::swap(atlas, other.atlas);
+	std::swap(glyphs, other.glyphs);
+	std::swap(atlas_pen, other.atlas_pen);
+	std::swap(atlas_generation, other.atlas_generation);
 	return *this;
 }
 
@@ -47,6 +61,7 @@ int Font::Style() const noexcept {
 
 void Font::Style(int s) const noexcept {
 	TTF_SetFontStyle(handle, s);
+	ClearAtlas();
 }
 
 int Font::Outline() const noexcept {
@@ -55,6 +70,7 @@ int Font::Outline() const noexcept {
 
 void Font::Outline(int px) noexcept {
 	TTF_SetFontOutline(handle, px);
+	ClearAtlas();
 }
 
 
@@ -64,6 +80,7 @@ int Font::Hinting() const noexcept {
 
 void Font::Hinting(int h) const noexcept {
 	TTF_SetFontHinting(handle, h);
+	ClearAtlas();
 }
 
 bool Font::Kerning() const noexcept {
@@ -72,6 +89,7 @@ bool Font::Kerning() const noexcept {
 
 void Font::Kerning(bool b) noexcept {
 	TTF_SetFontKerning(handle, b);
+	ClearAtlas();
 }
 
 
@@ -131,6 +149,184 @@ void Font::Render(const char *text, Texture &tex) const {
 	SDL_FreeSurface(srf);
 }
 
+namespace {
+
+constexpr GLsizei atlas_size = 512;
+// keeps neighboring glyphs from bleeding into each other
+constexpr int atlas_padding = 1;
+
+/// decode the UTF-8 sequence at text and advance past it
+/// invalid sequences yield their first byte
+Uint32 next_code_point(const char *&text) noexcept {
+	const unsigned char lead = *text++;
+	int follow = 0;
+	Uint32 cp = lead;
+	if ((lead & 0xE0) == 0xC0) {
+		follow = 1;
+		cp = lead & 0x1F;
+	} else if ((lead & 0xF0) == 0xE0) {
+		follow = 2;
+		cp = lead & 0x0F;
+	} else if ((lead & 0xF8) == 0xF0) {
+		follow = 3;
+		cp = lead & 0x07;
+	}
+	for (int i = 0; i < follow; ++i) {
+		if ((text[i] & 0xC0) != 0x80) {
+			return lead;
+		}
+	}
+	for (int i = 0; i < follow; ++i) {
+		cp = (cp << 6) | (*text++ & 0x3F);
+	}
+	return cp;
+}
+
+void encode_code_point(Uint32 cp, char *out) noexcept {
+	if (cp < 0x80) {
+		*out++ = cp;
+	} else if (cp < 0x800) {
+		*out++ = 0xC0 | (cp >> 6);
+		*out++ = 0x80 | (cp & 0x3F);
+	} else if (cp < 0x10000) {
+		*out++ = 0xE0 | (cp >> 12);
+		*out++ = 0x80 | ((cp >> 6) & 0x3F);
+		*out++ = 0x80 | (cp & 0x3F);
+	} else {
+		*out++ = 0xF0 | (cp >> 18);
+		*out++ = 0x80 | ((cp >> 12) & 0x3F);
+		*out++ = 0x80 | ((cp >> 6) & 0x3F);
+		*out++ = 0x80 | (cp & 0x3F);
+	}
+	*out = '\0';
+}
+
+}
+
+Texture &Font::Atlas() const {
+	if (!atlas) {
+		atlas.reset(new Texture());
+		atlas->Bind();
+		// start out transparent so padding stays clear
+		std::vector<unsigned char> clear(atlas_size * atlas_size * 4, 0);
+		atlas->Data(atlas_size, atlas_size, Format(), clear.data());
+		// glyphs are drawn at their native size
+		atlas->FilterNearest();
+		atlas->WrapEdge();
+	}
+	return *atlas;
+}
+
+void Font::ClearAtlas() const {
+	glyphs.clear();
+	atlas_pen = glm::ivec2(0);
+	++atlas_generation;
+}
+
+const Font::Glyph &Font::GetGlyph(Uint32 cp) const {
+	auto entry = glyphs.find(cp);
+	if (entry != glyphs.end()) {
+		return entry->second;
+	}
+	Glyph &glyph = glyphs[cp];
+	glyph.tex_begin = glyph.tex_end = glyph.size = glm::vec2(0.0f);
+
+	char seq[5];
+	encode_code_point(cp, seq);
+	// rendering one glyph as a string gets us a cell of its advance
+	// times the font's height, so cells can simply be lined up
+	SDL_Surface *srf = TTF_RenderUTF8_Blended(handle, seq, { 0xFF, 0xFF, 0xFF, 0xFF });
+	if (!srf) {
+		// e.g. zero width, nothing to draw then
+		return glyph;
+	}
+	if (srf->w + atlas_padding > atlas_size || srf->h + atlas_padding > atlas_size) {
+		SDL_FreeSurface(srf);
+		return glyph;
+	}
+	if (atlas_pen.x + srf->w + atlas_padding > atlas_size) {
+		atlas_pen.x = 0;
+		atlas_pen.y += Height() + atlas_padding;
+	}
+	if (atlas_pen.y + srf->h + atlas_padding > atlas_size) {
+		SDL_FreeSurface(srf);
+		ClearAtlas();
+		return GetGlyph(cp);
+	}
+	Texture &tex = Atlas();
+	tex.Bind();
+	tex.Data(atlas_pen.x, atlas_pen.y, *srf);
+	glyph.tex_begin = glm::vec2(atlas_pen) / float(atlas_size);
+	glyph.tex_end = glm::vec2(atlas_pen + glm::ivec2(srf->w, srf->h)) / float(atlas_size);
+	glyph.size = glm::vec2(srf->w, srf->h);
+	atlas_pen.x += srf->w + atlas_padding;
+	SDL_FreeSurface(srf);
+	return glyph;
+}
+
+glm::vec2 Font::Layout(
+	const char *text,
+	SpriteMesh::Buffer &buf,
+	Gravity pivot,
+	unsigned int &generation
+) const {
+	const std::size_t vtx_begin = buf.vertices.size();
+	const std::size_t idx_begin = buf.indices.size();
+	glm::vec2 size(0.0f, Height());
+	generation = atlas_generation;
+	bool restarted = false;
+	for (const char *iter = text; *iter;) {
+		const Glyph &glyph = GetGlyph(next_code_point(iter));
+		if (atlas_generation != generation) {
+			// atlas ran full and was cleared, which invalidates
+			// the quads so far
+			buf.vertices.resize(vtx_begin);
+			buf.coords.resize(vtx_begin);
+			buf.indices.resize(idx_begin);
+			size.x = 0.0f;
+			generation = atlas_generation;
+			if (restarted) {
+				// doesn't even fit an empty atlas
+				break;
+			}
+			restarted = true;
+			iter = text;
+			continue;
+		}
+		if (glyph.size.x <= 0.0f) {
+			continue;
+		}
+		const SpriteMesh::Index base = buf.vertices.size();
+		buf.vertices.emplace_back(size.x,                0.0f,         0.0f);
+		buf.vertices.emplace_back(size.x + glyph.size.x, 0.0f,         0.0f);
+		buf.vertices.emplace_back(size.x,                glyph.size.y, 0.0f);
+		buf.vertices.emplace_back(size.x + glyph.size.x, glyph.size.y, 0.0f);
+		buf.coords.emplace_back(glyph.tex_begin.x, glyph.tex_begin.y);
+		buf.coords.emplace_back(glyph.tex_end.x,   glyph.tex_begin.y);
+		buf.coords.emplace_back(glyph.tex_begin.x, glyph.tex_end.y);
+		buf.coords.emplace_back(glyph.tex_end.x,   glyph.tex_end.y);
+		for (SpriteMesh::Index i : { 0, 2, 1, 1, 2, 3 }) {
+			buf.indices.push_back(base + i);
+		}
+		size.x += glyph.size.x;
+		size.y = std::max(size.y, glyph.size.y);
+	}
+	const glm::vec3 offset(align(pivot, size), 0.0f);
+	for (std::size_t i = vtx_begin; i < buf.vertices.size(); ++i) {
+		buf.vertices[i] -= offset;
+	}
+	return size;
+}
+
+float Font::LayoutWidth(const char *text) const {
+	float width = 0.0f;
+	for (const char *iter = text; *iter;) {
+		// cell sizes survive the atlas getting cleared along the way
+		width += GetGlyph(next_code_point(iter)).size.x;
+	}
+	return width;
+}
+
 Format::Format() noexcept
 : format(GL_BGRA)
 , type(GL_UNSIGNED_INT_8_8_8_8_REV)
@@ -310,6 +506,22 @@ void Texture::Data(GLsizei w, GLsizei h, const Format &format, GLvoid *data) noe
 	height = h;
 }
 
+void Texture::Data(GLint x, GLint y, const SDL_Surface &srf) noexcept {
+	Format format(*srf.format);
+	UnpackAlignmentFromPitch(srf.pitch);
+	UnpackRowLength(srf.pitch / srf.format->BytesPerPixel);
+	glTexSubImage2D(
+		GL_TEXTURE_2D,
+		0,
+		x, y,
+		srf.w, srf.h,
+		format.format, format.type,
+		srf.pixels
+	);
+	UnpackRowLength(0);
+	UnpackAlignment(4);
+}
+
 
 void Texture::UnpackAlignment(GLint i) noexcept {
 	glPixelStorei(GL_UNPACK_ALIGNMENT, i);
@@ -464,4 +676,57 @@ void CubeMap::Data(Face face, GLsizei w, GLsizei h, const Format &f, GLvoid *dat
 	);
 }
 
+
+
+VolumeTexture::VolumeTexture()
+: TextureBase()
+, width(0)
+, height(0)
+, depth(0) {
+
+}
+
+VolumeTexture::~VolumeTexture() {
+
+}
+
+VolumeTexture::VolumeTexture(VolumeTexture &&other) noexcept
+: TextureBase(std::move(other)) {
+	width = other.width;
+	height = other.height;
+	depth = other.depth;
+}
+
+VolumeTexture &VolumeTexture::operator =(VolumeTexture &&other) noexcept {
+	TextureBase::operator =(std::move(other));
+	width = other.width;
+	height = other.height;
+	depth = other.depth;
+	return *this;
+}
+
+
+void VolumeTexture::Reserve(GLsizei w, GLsizei h, GLsizei d) noexcept {
+	glTexStorage3D(
+		GL_TEXTURE_3D, // which
+		1,             // mipmap count
+		GL_R8,         // format
+		w, h, d        // dimensions
+	);
+	width = w;
+	height = h;
+	depth = d;
+}
+
+void VolumeTexture::Data(GLint x, GLint y, GLint z, GLsizei w, GLsizei h, GLsizei d, const GLubyte *data) noexcept {
+	glTexSubImage3D(
+		GL_TEXTURE_3D, // which
+		0,             // mipmap level
+		x, y, z,       // dest offset
+		w, h, d,       // dimensions
+		GL_RED, GL_UNSIGNED_BYTE,
+		data
+	);
+}
+
 }
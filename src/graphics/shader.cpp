@@ -1,17 +1,21 @@
 #include "BlendedSprite.hpp"
 #include "BlockLighting.hpp"
 #include "DirectionalLighting.hpp"
+#include "InstancedLighting.hpp"
 #include "PlainColor.hpp"
 #include "Program.hpp"
 #include "Shader.hpp"
 #include "SkyBoxShader.hpp"
 
 #include "ArrayTexture.hpp"
+#include "BlockMesh.hpp"
 #include "CubeMap.hpp"
 #include "Texture.hpp"
+#include "VolumeTexture.hpp"
 #include "../app/error.hpp"
 
 #include <algorithm>
+#include <cstddef>
 #include <iostream>
 #include <memory>
 #include <ostream>
@@ -313,11 +317,12 @@ void DirectionalLighting::SetMVP(const glm::mat4 &m, const glm::mat4 &v, const g
 }
 
 
-BlockLighting::BlockLighting()
+InstancedLighting::InstancedLighting()
 : program()
 , vp(1.0f)
-, mv_handle(0)
-, mvp_handle(0)
+, v_handle(0)
+, vp_handle(0)
+, sampler_handle(0)
 , fog_density_handle(0) {
 	program.LoadShader(
 		GL_VERTEX_SHADER,
@@ -326,23 +331,205 @@ BlockLighting::BlockLighting()
 		"layout(location = 1) in vec3 vtx_tex_uv;\n"
 		"layout(location = 2) in vec3 vtx_hsl_mod;\n"
 		"layout(location = 3) in vec3 vtx_rgb_mod;\n"
-		"layout(location = 4) in float vtx_light;\n"
+		"layout(location = 4) in vec3 vtx_normal;\n"
+		"layout(location = 5) in mat4 M;\n"
+		"layout(location = 9) in vec3 inst_light_direction;\n"
+		"layout(location = 10) in vec3 inst_light_color;\n"
+		"layout(location = 11) in vec3 inst_ambient_color;\n"
+		"uniform mat4 V;\n"
+		"uniform mat4 VP;\n"
+		"out vec3 frag_tex_uv;\n"
+		"out vec3 frag_hsl_mod;\n"
+		"out vec3 frag_rgb_mod;\n"
+		"out vec3 vtx_viewspace;\n"
+		"out vec3 normal;\n"
+		"flat out vec3 light_direction;\n"
+		"flat out vec3 light_color;\n"
+		"flat out vec3 ambient_color;\n"
+		"void main() {\n"
+			"vec4 world_position = M * vec4(vtx_position, 1);\n"
+			"gl_Position = VP * world_position;\n"
+			"vtx_viewspace = (V * world_position).xyz;\n"
+			"normal = (M * vec4(vtx_normal, 0)).xyz;\n"
+			"frag_tex_uv = vtx_tex_uv;\n"
+			"frag_hsl_mod = vtx_hsl_mod;\n"
+			"frag_rgb_mod = vtx_rgb_mod;\n"
+			"light_direction = inst_light_direction;\n"
+			"light_color = inst_light_color;\n"
+			"ambient_color = inst_ambient_color;\n"
+		"}\n"
+	);
+	program.LoadShader(
+		GL_FRAGMENT_SHADER,
+		"#version 330 core\n"
+		"in vec3 frag_tex_uv;\n"
+		"in vec3 frag_hsl_mod;\n"
+		"in vec3 frag_rgb_mod;\n"
+		"in vec3 vtx_viewspace;\n"
+		"in vec3 normal;\n"
+		"flat in vec3 light_direction;\n"
+		"flat in vec3 light_color;\n"
+		"flat in vec3 ambient_color;\n"
+		"uniform sampler2DArray tex_sampler;\n"
+		"uniform float fog_density;\n"
+		"out vec3 color;\n"
+		"vec3 rgb2hsl(vec3 c) {\n"
+			"vec4 K = vec4(0.0, -1.0/3.0, 2.0/3.0, -1.0);\n"
+			"vec4 p = mix(vec4(c.bg, K.wz), vec4(c.gb, K.xy), step(c.b, c.g));\n"
+			"vec4 q = mix(vec4(p.xyw, c.r), vec4(c.r, p.yzx), step(p.x, c.r));\n"
+			"float d = q.x - min(q.w, q.y);\n"
+			"float e = 1.0e-10;\n"
+			"return vec3(abs(q.z + (q.w - q.y) / (6.0 * d + e)), d / (q.x + e), q.x);\n"
+		"}\n"
+		"vec3 hsl2rgb(vec3 c) {\n"
+			"vec4 K = vec4(1.0, 2.0/3.0, 1.0/3.0, 3.0);\n"
+			"vec3 p = abs(fract(c.xxx + K.xyz) * 6.0 - K.www);\n"
+			"return c.z * mix(K.xxx, clamp(p - K.xxx, 0.0, 1.0), c.y);\n"
+		"}\n"
+		"void main() {\n"
+			"vec3 tex_color = texture(tex_sampler, frag_tex_uv).rgb;\n"
+			"vec3 hsl_color = rgb2hsl(tex_color);\n"
+			"hsl_color.x += frag_hsl_mod.x;\n"
+			"hsl_color.y *= frag_hsl_mod.y;\n"
+			"hsl_color.z *= frag_hsl_mod.z;\n"
+			"vec3 base_color = hsl2rgb(hsl_color) * frag_rgb_mod;\n"
+			"vec3 ambient = ambient_color * base_color;\n"
+			// this should be the same as the clear color, otherwise looks really weird
+			"vec3 fog_color = vec3(0, 0, 0);\n"
+			"float e = 2.718281828;\n"
+			"vec3 n = normalize(normal);\n"
+			"vec3 l = normalize(light_direction);\n"
+			"float cos_theta = clamp(dot(n, l), 0, 1);\n"
+			"vec3 reflect_color = ambient + base_color * light_color * cos_theta;\n"
+			"float value = pow(e, -pow(fog_density * length(vtx_viewspace), 5));"
+			"color = mix(fog_color, reflect_color, value);\n"
+		"}\n"
+	);
+	program.Link();
+	if (!program.Linked()) {
+		program.Log(std::cerr);
+		throw std::runtime_error("link program");
+	}
+
+	v_handle = program.UniformLocation("V");
+	vp_handle = program.UniformLocation("VP");
+	sampler_handle = program.UniformLocation("tex_sampler");
+	fog_density_handle = program.UniformLocation("fog_density");
+
+	Activate();
+	program.Uniform(sampler_handle, GLint(0));
+	program.Uniform(fog_density_handle, 0.0f);
+}
+
+
+void InstancedLighting::Activate() noexcept {
+	program.Use();
+}
+
+void InstancedLighting::SetFogDensity(float f) noexcept {
+	program.Uniform(fog_density_handle, f);
+}
+
+void InstancedLighting::SetProjection(const glm::mat4 &p) noexcept {
+	projection = p;
+	vp = p * view;
+	program.Uniform(vp_handle, vp);
+}
+
+void InstancedLighting::SetView(const glm::mat4 &v) noexcept {
+	view = v;
+	vp = projection * v;
+	program.Uniform(v_handle, view);
+	program.Uniform(vp_handle, vp);
+}
+
+void InstancedLighting::SetVP(const glm::mat4 &v, const glm::mat4 &p) noexcept {
+	projection = p;
+	view = v;
+	vp = p * v;
+	program.Uniform(v_handle, view);
+	program.Uniform(vp_handle, vp);
+}
+
+namespace {
+
+void InstanceAttribute(GLuint which, GLint size, std::size_t offset) noexcept {
+	glEnableVertexAttribArray(which);
+	glVertexAttribPointer(
+		which,                                   // program location
+		size,                                    // element size
+		GL_FLOAT,                                // element type
+		GL_FALSE,                                // normalize
+		sizeof(InstancedLighting::Instance),     // stride
+		reinterpret_cast<const GLvoid *>(offset) // offset
+	);
+	glVertexAttribDivisor(which, 1);
+}
+
+}
+
+void InstancedLighting::InstanceAttributes(std::size_t offset) noexcept {
+	// a mat4 attribute is fed one column at a time
+	for (GLuint col = 0; col < 4; ++col) {
+		InstanceAttribute(ATTRIB_M + col, 4, offset + offsetof(Instance, M) + col * sizeof(glm::vec4));
+	}
+	InstanceAttribute(ATTRIB_LIGHT_DIRECTION, 3, offset + offsetof(Instance, light_direction));
+	InstanceAttribute(ATTRIB_LIGHT_COLOR, 3, offset + offsetof(Instance, light_color));
+	InstanceAttribute(ATTRIB_AMBIENT_COLOR, 3, offset + offsetof(Instance, ambient_color));
+}
+
+
+namespace {
+
+/// declaration of a GLSL float constant
+std::string GLSLConst(const char *name, float value) {
+	return std::string("const float ") + name + " = " + std::to_string(value) + ";\n";
+}
+
+}
+
+BlockLighting::BlockLighting()
+: program()
+, vp(1.0f)
+, mv_handle(0)
+, mvp_handle(0)
+, fog_density_handle(0) {
+	// fixed point scales are taken from BlockMesh, so they can't get out
+	// of sync with the packing
+	const std::string vertex_src(
+		"#version 330 core\n"
+		+ GLSLConst("position_scale", BlockMesh::position_scale)
+		+ GLSLConst("position_bias", BlockMesh::position_bias)
+		+ GLSLConst("tex_coord_scale", BlockMesh::tex_coord_scale)
+		+ GLSLConst("packed_light_scale", BlockMesh::light_scale)
+		// packed as described in BlockMesh::Vertex
+		+ "layout(location = 0) in vec3 vtx_packed_position;\n"
+		"layout(location = 1) in vec3 vtx_packed_tex_uv;\n"
+		"layout(location = 2) in vec3 vtx_hsl_mod;\n"
+		"layout(location = 3) in vec3 vtx_rgb_mod;\n"
+		"layout(location = 4) in float vtx_packed_light;\n"
+		"layout(location = 5) in vec3 vtx_chunk_offset;\n"
 		"uniform mat4 MV;\n"
 		"uniform mat4 MVP;\n"
+		"uniform vec3 light_origin;\n"
 		"out vec3 frag_tex_uv;\n"
 		"out vec3 frag_hsl_mod;\n"
 		"out vec3 frag_rgb_mod;\n"
 		"out vec3 vtx_viewspace;\n"
 		"out float frag_light;\n"
+		"out vec3 frag_light_pos;\n"
 		"void main() {\n"
+			"vec3 vtx_position = vtx_packed_position / position_scale - position_bias + vtx_chunk_offset;\n"
 			"gl_Position = MVP * vec4(vtx_position, 1);\n"
-			"frag_tex_uv = vtx_tex_uv;\n"
+			"frag_tex_uv = vec3(vtx_packed_tex_uv.xy / tex_coord_scale, vtx_packed_tex_uv.z);\n"
 			"frag_hsl_mod = vtx_hsl_mod;\n"
 			"frag_rgb_mod = vtx_rgb_mod;\n"
 			"vtx_viewspace = (MV * vec4(vtx_position, 1)).xyz;\n"
-			"frag_light = vtx_light;\n"
+			"frag_light = vtx_packed_light / packed_light_scale;\n"
+			"frag_light_pos = vtx_position + light_origin;\n"
 		"}\n"
 	);
+	program.LoadShader(GL_VERTEX_SHADER, vertex_src.c_str());
 	program.LoadShader(
 		GL_FRAGMENT_SHADER,
 		"#version 330 core\n"
@@ -351,7 +538,11 @@ BlockLighting::BlockLighting()
 		"in vec3 frag_rgb_mod;\n"
 		"in vec3 vtx_viewspace;\n"
 		"in float frag_light;\n"
+		"in vec3 frag_light_pos;\n"
 		"uniform sampler2DArray tex_sampler;\n"
+		"uniform sampler3D light_sampler;\n"
+		"uniform bool light_volume;\n"
+		"uniform float light_scale;\n"
 		"uniform float fog_density;\n"
 		"out vec3 color;\n"
 		"vec3 rgb2hsl(vec3 c) {\n"
@@ -374,7 +565,14 @@ BlockLighting::BlockLighting()
 			"hsl_color.y *= frag_hsl_mod.y;\n"
 			"hsl_color.z *= frag_hsl_mod.z;\n"
 			"vec3 base_color = hsl2rgb(hsl_color) * frag_rgb_mod;\n"
-			"float light_power = clamp(pow(0.8, 15 - frag_light), 0, 1);\n"
+			"float light = frag_light;\n"
+			"if (light_volume) {\n"
+				// sample half a block in front of the face, so it's
+				// interpolated between the blocks the face is exposed to
+				"vec3 normal = normalize(cross(dFdx(frag_light_pos), dFdy(frag_light_pos)));\n"
+				"light = texture(light_sampler, (frag_light_pos + 0.5 * normal) * light_scale).r * 255.0;\n"
+			"}\n"
+			"float light_power = clamp(pow(0.8, 15 - light), 0, 1);\n"
 			"vec3 fog_color = vec3(0, 0, 0);\n"
 			"float e = 2.718281828;\n"
 			"vec3 reflect_color = base_color * light_power;\n"
@@ -391,7 +589,18 @@ BlockLighting::BlockLighting()
 	mv_handle = program.UniformLocation("MV");
 	mvp_handle = program.UniformLocation("MVP");
 	sampler_handle = program.UniformLocation("tex_sampler");
+	light_sampler_handle = program.UniformLocation("light_sampler");
+	light_volume_handle = program.UniformLocation("light_volume");
+	light_origin_handle = program.UniformLocation("light_origin");
+	light_scale_handle = program.UniformLocation("light_scale");
 	fog_density_handle = program.UniformLocation("fog_density");
+
+	// the light sampler must not share unit 0 with tex_sampler even
+	// while the light volume is off, sampler types differ and drawing
+	// would fail
+	Activate();
+	program.Uniform(light_sampler_handle, GLint(1));
+	program.Uniform(light_volume_handle, GLint(0));
 }
 
 
@@ -405,6 +614,20 @@ void BlockLighting::SetTexture(ArrayTexture &tex) noexcept {
 	program.Uniform(sampler_handle, GLint(0));
 }
 
+void BlockLighting::SetLightVolume(VolumeTexture &tex, const glm::vec3 &origin) noexcept {
+	glActiveTexture(GL_TEXTURE1);
+	tex.Bind();
+	program.Uniform(light_sampler_handle, GLint(1));
+	program.Uniform(light_volume_handle, GLint(1));
+	program.Uniform(light_origin_handle, origin);
+	program.Uniform(light_scale_handle, 1.0f / tex.Width());
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void BlockLighting::DisableLightVolume() noexcept {
+	program.Uniform(light_volume_handle, GLint(0));
+}
+
 void BlockLighting::SetFogDensity(float f) noexcept {
 	program.Uniform(fog_density_handle, f);
 }
@@ -20,7 +20,8 @@ Camera::Camera() noexcept
 , near(0.1f)
 , far(256.0f)
 , projection(glm::perspective(fov, aspect, near, far))
-, view(1.0f) {
+, view(1.0f)
+, position(0.0f) {
 
 }
 
@@ -47,6 +48,7 @@ void Camera::Clip(float n, float f) noexcept {
 
 void Camera::View(const glm::mat4 &v) noexcept {
 	view = v;
+	position = glm::vec3(glm::inverse(view)[3]);
 }
 
 void Camera::UpdateProjection() noexcept {
@@ -97,6 +99,7 @@ Viewport::Viewport()
 , cam_offset(0.0f)
 , chunk_prog()
 , entity_prog()
+, instanced_prog()
 , sky_prog()
 , sprite_prog()
 , active_prog(NONE) {
@@ -206,16 +209,16 @@ BlockLighting &Viewport::ChunkProgram() noexcept {
 	return chunk_prog;
 }
 
-DirectionalLighting &Viewport::EntityProgram() noexcept {
+InstancedLighting &Viewport::EntityProgram() noexcept {
 	if (active_prog != ENTITY) {
-		entity_prog.Activate();
+		instanced_prog.Activate();
 		EnableDepthTest();
 		EnableBackfaceCulling();
 		DisableBlending();
-		entity_prog.SetVP(cam.View(), cam.Projection());
+		instanced_prog.SetVP(cam.View(), cam.Projection());
 		active_prog = ENTITY;
 	}
-	return entity_prog;
+	return instanced_prog;
 }
 
 DirectionalLighting &Viewport::HUDProgram() noexcept {
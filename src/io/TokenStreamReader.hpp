@@ -5,6 +5,7 @@
 #include "Tokenizer.hpp"
 #include "../graphics/glm.hpp"
 
+#include <cstddef>
 #include <iosfwd>
 #include <string>
 
@@ -15,6 +16,10 @@ class TokenStreamReader {
 
 public:
 	explicit TokenStreamReader(std::istream &);
+	/// read text in [begin,end), which must outlive the reader
+	TokenStreamReader(const char *begin, const char *end);
+	/// read tokens compiled by Tokenizer::Compile()
+	TokenStreamReader(const void *data, std::size_t size);
 
 	bool HasMore();
 	const Token &Next();
@@ -3,31 +3,59 @@
 
 #include "Token.hpp"
 
+#include <cstddef>
 #include <iosfwd>
 
 
 namespace blank {
 
+/// Splits text into tokens. The current token's value is reused for
+/// every token read, so once it has grown to fit the longest one,
+/// reading doesn't allocate any more. Lexing text from memory also
+/// skips the per character overhead of a stream.
 class Tokenizer {
 
 public:
-
-public:
+	/// lex text from given stream
 	explicit Tokenizer(std::istream &in);
+	/// lex text in [begin,end), which must outlive the tokenizer
+	Tokenizer(const char *begin, const char *end);
+	/// read tokens compiled by Compile(), data must outlive the tokenizer
+	Tokenizer(const void *data, std::size_t size);
+
+	/// lex everything in given stream and write it to out in a binary
+	/// form that's quicker to read back, comments are dropped
+	static void Compile(std::istream &in, std::ostream &out);
 
 	bool HasMore();
 	const Token &Next();
 	const Token &Current() const noexcept { return current; }
 
 private:
+	/// skip whitespace
+	/// @return false if the end of input was reached
+	bool SkipSpace();
+	bool Get(char &);
+	void Putback(char);
+
 	void ReadToken();
 
 	void ReadNumber();
 	void ReadString();
 	void ReadComment();
 	void ReadIdentifier();
+	void ReadCompiled();
 
-	std::istream &in;
+	enum Mode {
+		STREAM,
+		TEXT,
+		COMPILED,
+	} mode;
+	std::istream *in;
+	const char *text;
+	const char *text_end;
+	const unsigned char *compiled;
+	const unsigned char *compiled_end;
 	Token current;
 
 };
@@ -34,6 +34,11 @@ bool WorldSave::Exists() const noexcept {
 	return is_dir(root_path) && is_file(world_conf_path);
 }
 
+bool WorldSave::HasChunks() const noexcept {
+	// the directory only gets created when the first chunk is written
+	return is_dir(root_path + "chunks");
+}
+
 
 void WorldSave::Read(World::Config &conf) const {
 	ifstream is(world_conf_path);
@@ -21,6 +21,8 @@ public:
 public:
 	// whole save
 	bool Exists() const noexcept;
+	/// if any chunk has ever been written to this save
+	bool HasChunks() const noexcept;
 	void Read(World::Config &) const;
 	void Write(const World::Config &) const;
 	void Read(Generator::Config &) const;
@@ -80,6 +80,14 @@ time_t file_mtime(const char *path) {
 	return get_mtime(info);
 }
 
+uint64_t file_size(const char *path) {
+	Stat info;
+	if (do_stat(path, info) != 0) {
+		return 0;
+	}
+	return info.st_size;
+}
+
 
 bool make_dir(const char *path) {
 #ifdef _WIN32
@@ -1,6 +1,7 @@
 #ifndef BLANK_IO_FILESYSTEM_HPP_
 #define BLANK_IO_FILESYSTEM_HPP_
 
+#include <cstdint>
 #include <ctime>
 #include <string>
 
@@ -22,6 +23,11 @@ std::time_t file_mtime(const char *);
 inline std::time_t file_mtime(const std::string &s) {
 	return file_mtime(s.c_str());
 }
+/// get size of given file in bytes, 0 if it can't be determined
+std::uint64_t file_size(const char *);
+inline std::uint64_t file_size(const std::string &s) {
+	return file_size(s.c_str());
+}
 
 /// create given directory
 /// @return true if the directory was created
@@ -3,6 +3,8 @@
 #include "TokenStreamReader.hpp"
 
 #include <cctype>
+#include <cstdint>
+#include <cstring>
 #include <istream>
 #include <ostream>
 #include <sstream>
@@ -68,14 +70,44 @@ ostream &operator <<(ostream &out, const Token &t) {
 }
 
 Tokenizer::Tokenizer(istream &in)
-: in(in)
+: mode(STREAM)
+, in(&in)
+, text(nullptr)
+, text_end(nullptr)
+, compiled(nullptr)
+, compiled_end(nullptr)
+, current() {
+
+}
+
+Tokenizer::Tokenizer(const char *begin, const char *end)
+: mode(TEXT)
+, in(nullptr)
+, text(begin)
+, text_end(end)
+, compiled(nullptr)
+, compiled_end(nullptr)
+, current() {
+
+}
+
+Tokenizer::Tokenizer(const void *data, size_t size)
+: mode(COMPILED)
+, in(nullptr)
+, text(nullptr)
+, text_end(nullptr)
+, compiled(static_cast<const unsigned char *>(data))
+, compiled_end(compiled + size)
 , current() {
 
 }
 
 
 bool Tokenizer::HasMore() {
-	return bool(istream::sentry(in));
+	if (mode == COMPILED) {
+		return compiled != compiled_end;
+	}
+	return SkipSpace();
 }
 
 const Token &Tokenizer::Next() {
@@ -83,18 +115,50 @@ const Token &Tokenizer::Next() {
 	return Current();
 }
 
+bool Tokenizer::SkipSpace() {
+	if (mode == STREAM) {
+		return bool(istream::sentry(*in));
+	}
+	while (text != text_end && isspace(static_cast<unsigned char>(*text))) {
+		++text;
+	}
+	return text != text_end;
+}
+
+bool Tokenizer::Get(char &c) {
+	if (mode == STREAM) {
+		return bool(in->get(c));
+	}
+	if (text == text_end) {
+		return false;
+	}
+	c = *text++;
+	return true;
+}
+
+void Tokenizer::Putback(char c) {
+	if (mode == STREAM) {
+		in->putback(c);
+	} else {
+		--text;
+	}
+}
+
 void Tokenizer::ReadToken() {
 	current.type = Token::UNKNOWN;
 	current.value.clear();
 
-	istream::sentry s(in);
-	if (!s) {
-		throw runtime_error("read past the end of stream");
+	if (mode == COMPILED) {
+		ReadCompiled();
 		return;
 	}
 
-	istream::char_type c;
-	in.get(c);
+	if (!SkipSpace()) {
+		throw runtime_error("read past the end of stream");
+	}
+
+	char c;
+	Get(c);
 	switch (c) {
 		case '{': case '}':
 		case '<': case '>':
@@ -107,7 +171,7 @@ void Tokenizer::ReadToken() {
 		case '+': case '-': case '.':
 		case '0': case '1': case '2': case '3': case '4':
 		case '5': case '6': case '7': case '8': case '9':
-			in.putback(c);
+			Putback(c);
 			ReadNumber();
 			break;
 		case '"':
@@ -115,11 +179,11 @@ void Tokenizer::ReadToken() {
 			break;
 		case '#':
 		case '/':
-			in.putback(c);
+			Putback(c);
 			ReadComment();
 			break;
 		default:
-			in.putback(c);
+			Putback(c);
 			ReadIdentifier();
 			break;
 	}
@@ -127,7 +191,7 @@ void Tokenizer::ReadToken() {
 
 namespace {
 
-bool is_num_char(istream::char_type c) {
+bool is_num_char(char c) {
 	return isxdigit(c)
 		|| c == '.'
 		|| c == '-'
@@ -135,16 +199,29 @@ bool is_num_char(istream::char_type c) {
 	;
 }
 
+bool is_ident_char(char c) {
+	return isalnum(c) || c == '_' || c == '.';
+}
+
 }
 
 void Tokenizer::ReadNumber() {
 	current.type = Token::NUMBER;
-	istream::char_type c;
-	while (in.get(c)) {
+	if (mode == TEXT) {
+		// the value is in the buffer as is, copy it in one go
+		const char *begin = text;
+		while (text != text_end && is_num_char(*text)) {
+			++text;
+		}
+		current.value.assign(begin, text);
+		return;
+	}
+	char c;
+	while (Get(c)) {
 		if (is_num_char(c)) {
 			current.value += c;
 		} else {
-			in.putback(c);
+			Putback(c);
 			break;
 		}
 	}
@@ -154,8 +231,8 @@ void Tokenizer::ReadString() {
 	current.type = Token::STRING;
 	bool escape = false;
 
-	istream::char_type c;
-	while (in.get(c)) {
+	char c;
+	while (Get(c)) {
 		if (escape) {
 			escape = false;
 			switch (c) {
@@ -184,22 +261,22 @@ void Tokenizer::ReadString() {
 
 void Tokenizer::ReadComment() {
 	current.type = Token::COMMENT;
-	istream::char_type c;
-	in.get(c);
+	char c;
+	Get(c);
 
 	if (c == '#') {
-		while (in.get(c) && c != '\n') {
+		while (Get(c) && c != '\n') {
 			current.value += c;
 		}
 		return;
 	}
 
 	// c is guaranteed to be '/' now
-	if (!in.get(c)) {
+	if (!Get(c)) {
 		throw runtime_error("unexpected end of stream");
 	}
 	if (c == '/') {
-		while (in.get(c) && c != '\n') {
+		while (Get(c) && c != '\n') {
 			current.value += c;
 		}
 		return;
@@ -207,10 +284,10 @@ void Tokenizer::ReadComment() {
 		throw runtime_error("invalid character after /");
 	}
 
-	while (in.get(c)) {
+	while (Get(c)) {
 		if (c == '*') {
-			istream::char_type c2;
-			if (!in.get(c2)) {
+			char c2;
+			if (!Get(c2)) {
 				throw runtime_error("unexpected end of stream");
 			}
 			if (c2 == '/') {
@@ -227,25 +304,76 @@ void Tokenizer::ReadComment() {
 
 void Tokenizer::ReadIdentifier() {
 	current.type = Token::IDENTIFIER;
-
-	istream::char_type c;
-	while (in.get(c)) {
-		if (isalnum(c) || c == '_' || c == '.') {
+	if (mode == TEXT) {
+		const char *begin = text;
+		while (text != text_end && is_ident_char(*text)) {
+			++text;
+		}
+		current.value.assign(begin, text);
+		return;
+	}
+	char c;
+	while (Get(c)) {
+		if (is_ident_char(c)) {
 			current.value += c;
 		} else {
-			in.putback(c);
+			Putback(c);
 			break;
 		}
 	}
 }
 
 
+void Tokenizer::ReadCompiled() {
+	// one byte type, four byte length, then the value
+	if (compiled_end - compiled < 5) {
+		throw runtime_error("read past the end of compiled tokens");
+	}
+	current.type = Token::Type(compiled[0]);
+	uint32_t len;
+	memcpy(&len, compiled + 1, sizeof(len));
+	compiled += 5;
+	if (size_t(compiled_end - compiled) < len) {
+		throw runtime_error("truncated compiled token");
+	}
+	current.value.assign(reinterpret_cast<const char *>(compiled), len);
+	compiled += len;
+}
+
+void Tokenizer::Compile(istream &in, ostream &out) {
+	Tokenizer tokens(in);
+	while (tokens.HasMore()) {
+		const Token &token = tokens.Next();
+		if (token.type == Token::COMMENT) {
+			continue;
+		}
+		const char type = char(token.type);
+		const uint32_t len = token.value.size();
+		out.write(&type, 1);
+		out.write(reinterpret_cast<const char *>(&len), sizeof(len));
+		out.write(token.value.data(), len);
+	}
+}
+
+
 TokenStreamReader::TokenStreamReader(istream &in)
 : in(in)
 , cached(false) {
 
 }
 
+TokenStreamReader::TokenStreamReader(const char *begin, const char *end)
+: in(begin, end)
+, cached(false) {
+
+}
+
+TokenStreamReader::TokenStreamReader(const void *data, size_t size)
+: in(data, size)
+, cached(false) {
+
+}
+
 
 bool TokenStreamReader::HasMore() {
 	if (cached) {
@@ -0,0 +1,708 @@
+#include "app/Assets.hpp"
+#include "app/Config.hpp"
+#include "app/init.hpp"
+#include "client/ChunkReceiver.hpp"
+#include "client/Client.hpp"
+#include "client/NetworkedInput.hpp"
+#include "geometry/const.hpp"
+#include "io/filesystem.hpp"
+#include "io/LineBuffer.hpp"
+#include "io/WorldSave.hpp"
+#include "net/ConnectionHandler.hpp"
+#include "net/Packet.hpp"
+#include "net/tcp.hpp"
+#include "rand/GaloisLFSR.hpp"
+#include "server/Server.hpp"
+#include "shared/WorldResources.hpp"
+#include "world/Chunk.hpp"
+#include "world/ChunkLoader.hpp"
+#include "world/ChunkStore.hpp"
+#include "world/EntityState.hpp"
+#include "world/Generator.hpp"
+#include "world/Player.hpp"
+#include "world/World.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace blank;
+using namespace std;
+using namespace chrono;
+
+
+namespace {
+
+enum Behaviour {
+	WALK = 1,
+	EDIT = 2,
+	CHAT = 4,
+};
+
+unsigned ParseBehaviour(const string &spec) {
+	unsigned result = 0;
+	string::size_type begin = 0;
+	while (begin <= spec.size()) {
+		string::size_type end = spec.find(',', begin);
+		if (end == string::npos) {
+			end = spec.size();
+		}
+		const string item = spec.substr(begin, end - begin);
+		if (item == "walk") {
+			result |= WALK;
+		} else if (item == "edit") {
+			result |= EDIT;
+		} else if (item == "chat") {
+			result |= CHAT;
+		} else if (item == "idle") {
+			// explicitly nothing
+		} else {
+			throw runtime_error("unknown behaviour \"" + item + '"');
+		}
+		begin = end + 1;
+	}
+	return result;
+}
+
+/// cumulative counters of one bot
+struct BotStats {
+	uint64_t rx = 0;
+	uint64_t tx = 0;
+	unsigned int corrections = 0;
+	unsigned int chat_samples = 0;
+	/// sum of chat round trips in milliseconds
+	int chat_latency = 0;
+	/// milliseconds since the bot joined
+	int alive = 0;
+};
+
+BotStats operator -(const BotStats &a, const BotStats &b) noexcept {
+	BotStats d;
+	d.rx = a.rx - b.rx;
+	d.tx = a.tx - b.tx;
+	d.corrections = a.corrections - b.corrections;
+	d.chat_samples = a.chat_samples - b.chat_samples;
+	d.chat_latency = a.chat_latency - b.chat_latency;
+	d.alive = a.alive - b.alive;
+	return d;
+}
+
+/// synthetic player, drives a NetworkedInput like the interactive
+/// client would, all bots share one world so chunks are kept once
+class Bot
+: public ConnectionHandler {
+
+public:
+	Bot(
+		const Config::Network &conf,
+		World &world,
+		const WorldSave &save,
+		const string &name,
+		unsigned int behaviour,
+		uint64_t seed)
+	: client(conf)
+	, receiver(client, world.Chunks(), save)
+	, world(world)
+	, name(name)
+	, behaviour(behaviour)
+	, random(seed)
+	, login_packet(-1)
+	, parted(false)
+	, player(nullptr)
+	, input()
+	, time_skipped(0)
+	, packets_skipped(0)
+	, walk_timer(0)
+	, edit_timer(1000 + random.Next<unsigned short>() % 2000)
+	, chat_timer(2000 + random.Next<unsigned short>() % 4000)
+	, editing(false)
+	, place_next(false)
+	, chat_seq(0)
+	, chat_sent()
+	, stats() {
+		client.GetConnection().SetHandler(this);
+		login_packet = client.SendLogin(name);
+	}
+
+	/// process everything that arrived since the last tick and decide
+	/// what to do next, like the interactive client's event handling
+	void Handle(int dt) {
+		client.Handle();
+		receiver.Update(dt);
+		if (input) {
+			Behave(dt);
+		}
+	}
+
+	/// tell the server, call after the world was updated
+	void Update(int dt) {
+		if (input) {
+			stats.alive += dt;
+			if (input->UpdateImportant() || packets_skipped >= NetStat().SuggestedPacketSkip()) {
+				input->PushPlayerUpdate(time_skipped + dt);
+				time_skipped = 0;
+				packets_skipped = 0;
+			} else {
+				time_skipped += dt;
+				++packets_skipped;
+			}
+		}
+		client.Update(dt);
+	}
+
+	void Part() {
+		client.SendPart();
+	}
+
+	const string &Name() const noexcept { return name; }
+	bool Joined() const noexcept { return input && !Closed(); }
+	bool Closed() const noexcept { return parted || client.GetConnection().Closed(); }
+
+	BotStats Stats() const noexcept {
+		BotStats s(stats);
+		s.rx = NetStat().BytesReceived();
+		s.tx = NetStat().BytesSent();
+		return s;
+	}
+
+private:
+	void Behave(int dt) {
+		if (behaviour & WALK) {
+			walk_timer -= dt;
+			if (walk_timer <= 0) {
+				walk_timer = 1000 + random.Next<unsigned short>() % 3000;
+				input->TurnHead(0.0f, random.SNorm() * PI);
+				// stand still every once in a while
+				input->SetMovement(glm::vec3(0.0f, 0.0f, random.UNorm() < 0.2f ? 0.0f : -1.0f));
+			}
+		}
+		if (behaviour & EDIT) {
+			edit_timer -= dt;
+			if (edit_timer <= 0) {
+				if (editing) {
+					input->StopPrimaryAction();
+					input->StopTertiaryAction();
+					editing = false;
+					edit_timer = 1000 + random.Next<unsigned short>() % 2000;
+				} else {
+					// look at the ground in front and alternate between
+					// digging and placing
+					input->TurnHead(-PI_0p25 - input->GetPitch(), 0.0f);
+					if (place_next) {
+						input->StartTertiaryAction();
+					} else {
+						input->StartPrimaryAction();
+					}
+					place_next = !place_next;
+					editing = true;
+					// long enough for the server to see it, short enough
+					// to only hit once
+					edit_timer = 100;
+				}
+			}
+		}
+		if (behaviour & CHAT) {
+			chat_timer -= dt;
+			if (chat_timer <= 0) {
+				chat_timer = 2000 + random.Next<unsigned short>() % 4000;
+				const auto now = steady_clock::now();
+				// forget about lines that got lost on the way
+				for (auto i = chat_sent.begin(); i != chat_sent.end();) {
+					if (now - i->second > seconds(10)) {
+						i = chat_sent.erase(i);
+					} else {
+						++i;
+					}
+				}
+				chat_sent[++chat_seq] = now;
+				client.SendMessage(1, 0, name + " #" + to_string(chat_seq));
+			}
+		}
+	}
+
+	void OnPacketLost(uint16_t id) override {
+		if (id == login_packet) {
+			login_packet = client.SendLogin(name);
+		}
+	}
+
+	void On(const Packet::Join &pack) override {
+		login_packet = -1;
+		if (player) {
+			// world change, don't care
+			return;
+		}
+		uint32_t player_id;
+		pack.ReadPlayerID(player_id);
+		player = world.AddPlayer(name, player_id);
+		if (!player) {
+			parted = true;
+			return;
+		}
+		EntityState state;
+		pack.ReadPlayerState(state);
+		player->GetEntity().SetState(state);
+		input.reset(new client::NetworkedInput(world, *player, client));
+	}
+
+	void On(const Packet::Part &) override {
+		parted = true;
+	}
+
+	void On(const Packet::PlayerCorrection &pack) override {
+		if (!input) return;
+		uint16_t seq;
+		EntityState state;
+		pack.ReadPacketSeq(seq);
+		pack.ReadPlayerState(state);
+		input->MergePlayerCorrection(seq, state);
+		++stats.corrections;
+	}
+
+	void On(const Packet::ChunkBegin &pack) override {
+		receiver.Handle(pack);
+	}
+
+	void On(const Packet::ChunkData &pack) override {
+		receiver.Handle(pack);
+	}
+
+	void On(const Packet::BlockUpdate &pack) override {
+		glm::ivec3 pos;
+		pack.ReadChunkCoords(pos);
+		// every bot gets these, but the world is shared, so all except
+		// the first just set the same blocks again
+		Chunk *chunk = world.Chunks().Get(pos);
+		if (!chunk) return;
+		uint32_t count = 0;
+		pack.ReadBlockCount(count);
+		for (uint32_t i = 0; i < count; ++i) {
+			uint16_t index;
+			Block block;
+			pack.ReadIndex(index, i);
+			pack.ReadBlock(block, i);
+			if (index < Chunk::size && block.type < world.BlockTypes().size()) {
+				chunk->SetBlock(index, block);
+			}
+		}
+	}
+
+	void On(const Packet::Message &pack) override {
+		if (!player) return;
+		uint8_t type;
+		uint32_t ref;
+		string msg;
+		pack.ReadType(type);
+		pack.ReadReferral(ref);
+		pack.ReadMessage(msg);
+		const string prefix = name + " #";
+		if (type != 1 || ref != player->GetEntity().ID() || msg.compare(0, prefix.size(), prefix) != 0) {
+			return;
+		}
+		auto sent = chat_sent.find(strtoul(msg.c_str() + prefix.size(), nullptr, 10));
+		if (sent == chat_sent.end()) {
+			// duplicate or too late
+			return;
+		}
+		stats.chat_latency += duration_cast<milliseconds>(steady_clock::now() - sent->second).count();
+		++stats.chat_samples;
+		chat_sent.erase(sent);
+	}
+
+private:
+	client::Client client;
+	client::ChunkReceiver receiver;
+	World &world;
+	string name;
+	unsigned int behaviour;
+	GaloisLFSR random;
+	int login_packet;
+	bool parted;
+
+	Player *player;
+	unique_ptr<client::NetworkedInput> input;
+	int time_skipped;
+	unsigned int packets_skipped;
+
+	int walk_timer;
+	int edit_timer;
+	int chat_timer;
+	bool editing;
+	bool place_next;
+	uint32_t chat_seq;
+	map<uint32_t, steady_clock::time_point> chat_sent;
+
+	BotStats stats;
+
+};
+
+/// server tick time histogram as reported by the metrics command
+struct TickHistogram {
+	/// upper bounds in seconds with cumulative counts, +Inf comes last
+	vector<pair<double, uint64_t>> buckets;
+	double sum = 0.0;
+	uint64_t count = 0;
+};
+
+TickHistogram operator -(const TickHistogram &a, const TickHistogram &b) {
+	if (a.buckets.size() != b.buckets.size()) {
+		throw runtime_error("tick histogram changed its buckets");
+	}
+	TickHistogram d(a);
+	for (size_t i = 0; i < d.buckets.size(); ++i) {
+		d.buckets[i].second -= b.buckets[i].second;
+	}
+	d.sum -= b.sum;
+	d.count -= b.count;
+	return d;
+}
+
+/// fetches tick times from a remote server's command port
+class MetricsScraper {
+
+public:
+	MetricsScraper(const string &host, unsigned short port)
+	: conn(host, port)
+	, buf() { }
+
+	TickHistogram Scrape() {
+		static const string prefix(" > ");
+		static const string bucket("blank_tick_seconds_bucket{le=\"");
+		static const string sum("blank_tick_seconds_sum ");
+		static const string count("blank_tick_seconds_count ");
+		const string cmd("metrics\n");
+		for (size_t sent = 0; sent < cmd.size();) {
+			sent += conn.Send(cmd.data() + sent, cmd.size() - sent);
+		}
+		TickHistogram hist;
+		string line;
+		while (true) {
+			line = ReadLine();
+			if (line.compare(0, 3, " ! ") == 0) {
+				throw runtime_error("metrics command failed:" + line.substr(2));
+			}
+			if (line.compare(0, prefix.size(), prefix) != 0) {
+				// broadcast or whatever else
+				continue;
+			}
+			line.erase(0, prefix.size());
+			if (line == "# EOF") {
+				break;
+			}
+			if (line.compare(0, bucket.size(), bucket) == 0) {
+				const char *bound = line.c_str() + bucket.size();
+				const string::size_type value = line.find("} ", bucket.size());
+				if (value == string::npos) continue;
+				hist.buckets.emplace_back(
+					strncmp(bound, "+Inf", 4) == 0 ? HUGE_VAL : strtod(bound, nullptr),
+					strtoull(line.c_str() + value + 2, nullptr, 10));
+			} else if (line.compare(0, sum.size(), sum) == 0) {
+				hist.sum = strtod(line.c_str() + sum.size(), nullptr);
+			} else if (line.compare(0, count.size(), count) == 0) {
+				hist.count = strtoull(line.c_str() + count.size(), nullptr, 10);
+			}
+		}
+		if (hist.buckets.empty()) {
+			throw runtime_error("server reported no tick times");
+		}
+		return hist;
+	}
+
+private:
+	string ReadLine() {
+		string line;
+		while (!buf.Extract(line)) {
+			const size_t len = conn.Recv(buf.WriteHead(), buf.Remain());
+			if (len == 0) {
+				throw runtime_error("command connection closed by server");
+			}
+			buf.Update(len);
+		}
+		return line;
+	}
+
+private:
+	tcp::Socket conn;
+	LineBuffer<BUFSIZ> buf;
+
+};
+
+void PrintRates(const BotStats &s, float rtt) {
+	const float secs = max(s.alive, 1) * 0.001f;
+	cout << (s.rx / 1024.0f / secs) << "KiB/s down, "
+		<< (s.tx / 1024.0f / secs) << "KiB/s up, "
+		<< (s.corrections / secs) << " corrections/s, "
+		<< rtt << "ms RTT, ";
+	if (s.chat_samples > 0) {
+		cout << (s.chat_latency / s.chat_samples) << "ms chat";
+	} else {
+		cout << "no chat";
+	}
+}
+
+int ParseInt(int argc, char **argv, int &i) {
+	if (i + 1 >= argc || argv[i + 1][0] == '\0') {
+		throw runtime_error(string("missing argument to ") + argv[i]);
+	}
+	return strtol(argv[++i], nullptr, 10);
+}
+
+string ParseString(int argc, char **argv, int &i) {
+	if (i + 1 >= argc || argv[i + 1][0] == '\0') {
+		throw runtime_error(string("missing argument to ") + argv[i]);
+	}
+	return argv[++i];
+}
+
+}
+
+
+int main(int argc, char **argv) {
+	int max_bots = 64;
+	int step = 4;
+	int stage_time = 5000;
+	int tick = 16;
+	unsigned int behaviour = WALK | EDIT | CHAT;
+	bool remote = false;
+	unsigned short cmd_port = 0;
+	Config::Network conf;
+
+	try {
+		for (int i = 1; i < argc; ++i) {
+			const char *arg = argv[i];
+			if (strcmp(arg, "-n") == 0) {
+				max_bots = ParseInt(argc, argv, i);
+			} else if (strcmp(arg, "--step") == 0) {
+				step = ParseInt(argc, argv, i);
+			} else if (strcmp(arg, "--stage") == 0) {
+				stage_time = ParseInt(argc, argv, i);
+			} else if (strcmp(arg, "--tick") == 0) {
+				tick = ParseInt(argc, argv, i);
+			} else if (strcmp(arg, "--behaviour") == 0) {
+				behaviour = ParseBehaviour(ParseString(argc, argv, i));
+			} else if (strcmp(arg, "--host") == 0) {
+				conf.host = ParseString(argc, argv, i);
+				remote = true;
+			} else if (strcmp(arg, "--port") == 0) {
+				conf.port = ParseInt(argc, argv, i);
+			} else if (strcmp(arg, "--cmd-port") == 0) {
+				cmd_port = ParseInt(argc, argv, i);
+			} else if (strcmp(arg, "--impair") == 0) {
+				conf.impairment = ParseString(argc, argv, i);
+				// fail early rather than after loading the world
+				udp::Impairment::Parse(conf.impairment);
+			} else {
+				throw runtime_error(string("unknown argument ") + arg);
+			}
+		}
+		if (max_bots < 1 || step < 1 || stage_time < tick || tick < 1) {
+			throw runtime_error("bot count, step, and tick must be positive, stage at least one tick");
+		}
+		if (cmd_port && !remote) {
+			throw runtime_error("--cmd-port only makes sense with --host");
+		}
+	} catch (exception &e) {
+		cerr << e.what() << endl;
+		cerr << "usage: " << argv[0] << " [-n <max bots>] [--step <bots>] [--stage <ms>] [--tick <ms>]"
+			" [--behaviour walk,edit,chat] [--host <hostname>] [--port <number>] [--cmd-port <number>] [--impair <spec>]" << endl;
+		return 1;
+	}
+
+	InitHeadless init;
+	AssetLoader loader("assets/");
+	loader.OpenBundle("default");
+	WorldResources res;
+	res.Load(loader, "default");
+
+	// in process server, unless told to hit a remote one
+	TempDir server_dir;
+	WorldSave server_save(server_dir.Path());
+	World::Config wc;
+	World server_world(res.block_types, wc);
+	Generator::Config gc;
+	Generator gen(gc);
+	gen.LoadTypes(res.block_types);
+	ChunkLoader chunk_loader(server_world.Chunks(), gen, server_save);
+	unique_ptr<server::Server> server;
+	Config::Network bot_conf(conf);
+	if (!remote) {
+		// one socket sees both directions, so it's enough to impair the server
+		bot_conf.impairment = "none";
+		server.reset(new server::Server(conf, server_world, wc, server_save));
+		server->SetPlayerModel(res.models[0]);
+		cout << "loading spawn chunks" << endl;
+		chunk_loader.LoadN(chunk_loader.ToLoad());
+	}
+	// tick times of a remote server are only known if it lets us ask
+	unique_ptr<MetricsScraper> scraper;
+	if (cmd_port) {
+		scraper.reset(new MetricsScraper(conf.host, cmd_port));
+	}
+
+	TempDir bot_dir;
+	WorldSave bot_save(bot_dir.Path());
+	World bot_world(res.block_types, wc);
+	vector<unique_ptr<Bot>> bots;
+
+	int exceeded_at = 0;
+	auto next_tick = steady_clock::now();
+	while (bots.size() < size_t(max_bots) && exceeded_at == 0) {
+		const size_t target = min(bots.size() + step, size_t(max_bots));
+		while (bots.size() < target) {
+			bots.emplace_back(new Bot(bot_conf, bot_world, bot_save, "bot" + to_string(bots.size()), behaviour, bots.size() + 1));
+		}
+
+		vector<BotStats> stage_begin;
+		for (const auto &bot : bots) {
+			stage_begin.push_back(bot->Stats());
+		}
+		vector<int> tick_times;
+		TickHistogram hist_begin;
+		if (scraper) {
+			hist_begin = scraper->Scrape();
+		}
+		for (int elapsed = 0; elapsed < stage_time; elapsed += tick) {
+			next_tick += milliseconds(tick);
+			this_thread::sleep_until(next_tick);
+			if (server) {
+				const auto tick_begin = steady_clock::now();
+				server->Handle();
+				server_world.Update(tick);
+				chunk_loader.Update(tick);
+				server->Update(tick);
+				server->Flush();
+				const auto tick_time = steady_clock::now() - tick_begin;
+				server->RecordTick(tick_time);
+				tick_times.push_back(duration_cast<microseconds>(tick_time).count());
+			}
+			for (auto &bot : bots) {
+				bot->Handle(tick);
+			}
+			bot_world.Update(tick);
+			for (auto &bot : bots) {
+				bot->Update(tick);
+			}
+			// if bots and server together can't keep up, don't try to
+			// catch up with a burst of ticks
+			if (steady_clock::now() - next_tick > milliseconds(tick)) {
+				next_tick = steady_clock::now();
+			}
+		}
+
+		BotStats sum;
+		float rtt = 0.0f;
+		size_t joined = 0;
+		for (size_t i = 0; i < bots.size(); ++i) {
+			if (!bots[i]->Joined()) continue;
+			const BotStats d = bots[i]->Stats() - stage_begin[i];
+			sum.rx += d.rx;
+			sum.tx += d.tx;
+			sum.corrections += d.corrections;
+			sum.chat_samples += d.chat_samples;
+			sum.chat_latency += d.chat_latency;
+			sum.alive += d.alive;
+			rtt += bots[i]->NetStat().RoundTripTime();
+			++joined;
+		}
+		cout << bots.size() << " bots (" << joined << " joined)";
+		if (!tick_times.empty()) {
+			sort(tick_times.begin(), tick_times.end());
+			int64_t total = 0;
+			size_t over = 0;
+			for (int t : tick_times) {
+				total += t;
+				if (t > tick * 1000) ++over;
+			}
+			const int p95 = tick_times[tick_times.size() * 95 / 100];
+			cout << ": tick mean " << (total / tick_times.size() / 1000.0f) << "ms"
+				<< ", p95 " << (p95 / 1000.0f) << "ms"
+				<< ", max " << (tick_times.back() / 1000.0f) << "ms"
+				<< ", " << (over * 100 / tick_times.size()) << "% over budget";
+			if (p95 > tick * 1000) {
+				exceeded_at = bots.size();
+			}
+		} else if (scraper) {
+			const TickHistogram hist = scraper->Scrape() - hist_begin;
+			if (hist.count > 0) {
+				// only known at the resolution of the server's buckets,
+				// so p95 is the bound of the bucket it falls into
+				const double budget = tick * 0.001;
+				const uint64_t p95_count = (hist.count * 95 + 99) / 100;
+				double p95 = HUGE_VAL;
+				uint64_t within = 0;
+				for (const auto &bucket : hist.buckets) {
+					if (p95 == HUGE_VAL && bucket.second >= p95_count) {
+						p95 = bucket.first;
+					}
+					// allow for rounding in the printed bound
+					if (bucket.first <= budget * 1.0001) {
+						within = bucket.second;
+					}
+				}
+				cout << ": tick mean " << (hist.sum / hist.count * 1000.0) << "ms, p95 ";
+				if (p95 == HUGE_VAL) {
+					cout << "beyond the largest bucket";
+				} else {
+					cout << "<= " << (p95 * 1000.0) << "ms";
+				}
+				cout << ", " << ((hist.count - within) * 100 / hist.count) << "% over budget";
+				if (p95 > budget * 1.0001) {
+					exceeded_at = bots.size();
+				}
+			}
+		}
+		if (joined > 0) {
+			// averages per bot
+			sum.rx /= joined;
+			sum.tx /= joined;
+			sum.corrections /= joined;
+			sum.alive /= joined;
+			cout << "; per bot ";
+			PrintRates(sum, rtt / joined);
+		}
+		cout << endl;
+	}
+
+	cout << endl;
+	for (const auto &bot : bots) {
+		cout << bot->Name() << ": ";
+		if (bot->Joined()) {
+			PrintRates(bot->Stats(), bot->NetStat().RoundTripTime());
+		} else {
+			cout << "never joined";
+		}
+		cout << endl;
+	}
+	if (server || scraper) {
+		cout << endl;
+		if (exceeded_at > 0) {
+			cout << "p95 tick exceeded the " << tick << "ms budget at " << exceeded_at << " bots" << endl;
+		} else {
+			cout << "p95 tick stayed within the " << tick << "ms budget up to " << bots.size() << " bots" << endl;
+		}
+	}
+
+	// let the server see the parts so players get detached
+	for (auto &bot : bots) {
+		bot->Part();
+	}
+	if (server) {
+		for (int i = 0; i < 4; ++i) {
+			this_thread::sleep_for(milliseconds(tick));
+			server->Handle();
+			server->Update(tick);
+			server->Flush();
+		}
+	}
+	return 0;
+}
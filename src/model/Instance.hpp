@@ -10,7 +10,7 @@
 
 namespace blank {
 
-class DirectionalLighting;
+class EntityBatch;
 class Model;
 class Part;
 
@@ -32,7 +32,10 @@ public:
 	glm::mat4 EyesTransform() const noexcept;
 	Part::State &EyesState() noexcept;
 
-	void Render(const glm::mat4 &, DirectionalLighting &);
+	/// queue all parts except those smaller than min_radius
+	void Render(const glm::mat4 &, EntityBatch &, float min_radius = 0.0f);
+	/// queue the model's merged mesh, ignoring the instance's pose
+	void RenderMerged(const glm::mat4 &, EntityBatch &);
 
 private:
 	const Model *model;
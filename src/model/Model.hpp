@@ -6,6 +6,7 @@
 
 #include <cstdint>
 #include <list>
+#include <memory>
 #include <vector>
 #include <glm/gtc/quaternion.hpp>
 
@@ -40,12 +41,16 @@ public:
 	void Enumerate();
 	void Instantiate(Instance &) const;
 
+	/// all parts in their initial pose merged into a single mesh
+	const EntityMesh &MergedMesh() const;
+
 private:
 	std::uint32_t id;
 	Part root;
 	std::vector<Part *> part;
 	std::uint16_t body_id;
 	std::uint16_t eyes_id;
+	mutable std::unique_ptr<EntityMesh> merged;
 
 };
 
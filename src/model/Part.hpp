@@ -13,7 +13,7 @@
 
 namespace blank {
 
-class DirectionalLighting;
+class EntityBatch;
 class Instance;
 class Model;
 class ResourceIndex;
@@ -45,10 +45,20 @@ public:
 	glm::mat4 LocalTransform(const Instance &) const noexcept;
 	glm::mat4 GlobalTransform(const Instance &) const noexcept;
 
+	/// queue this part and its children for drawing
+	/// parts whose shape is smaller than min_radius are left out
+	/// together with their children
 	void Render(
 		const glm::mat4 &,
 		const Instance &,
-		DirectionalLighting &) const;
+		EntityBatch &,
+		float min_radius = 0.0f) const;
+
+	/// append this part and its children in their initial pose
+	void FillRestPose(EntityMesh::Buffer &, const glm::mat4 &) const;
+
+private:
+	const EntityMesh &Mesh() const;
 
 private:
 	const Part *parent;
@@ -56,6 +66,9 @@ private:
 	std::list<Part> children;
 	std::vector<float> tex_map;
 	mutable std::unique_ptr<EntityMesh> mesh;
+	/// distance between origin and farthest vertex of the shape,
+	/// known once the mesh has been built
+	mutable float radius;
 	State initial;
 	EntityMesh::ColorMod hsl_mod;
 	EntityMesh::ColorMod rgb_mod;
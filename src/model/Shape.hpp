@@ -59,7 +59,8 @@ public:
 	void Fill(
 		EntityMesh::Buffer &,
 		const glm::mat4 &transform,
-		const std::vector<float> &tex_map
+		const std::vector<float> &tex_map,
+		std::size_t idx_offset = 0
 	) const;
 	void Fill(
 		BlockMesh::Buffer &,
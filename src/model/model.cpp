@@ -6,10 +6,11 @@
 #include "Shape.hpp"
 #include "ShapeRegistry.hpp"
 #include "../io/TokenStreamReader.hpp"
-#include "../graphics/DirectionalLighting.hpp"
+#include "../graphics/EntityBatch.hpp"
 #include "../graphics/EntityMesh.hpp"
 #include "../shared/ResourceIndex.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <glm/gtx/quaternion.hpp>
 #include <glm/gtx/io.hpp>
@@ -43,8 +44,15 @@ glm::mat4 Instance::EyesTransform() const noexcept {
 	return model->GetEyesPart().GlobalTransform(*this);
 }
 
-void Instance::Render(const glm::mat4 &M, DirectionalLighting &prog) {
-	model->RootPart().Render(M, *this, prog);
+void Instance::Render(const glm::mat4 &M, EntityBatch &batch, float min_radius) {
+	model->RootPart().Render(M, *this, batch, min_radius);
+}
+
+void Instance::RenderMerged(const glm::mat4 &M, EntityBatch &batch) {
+	const EntityMesh &mesh = model->MergedMesh();
+	if (!mesh.Empty()) {
+		batch.Add(mesh, M);
+	}
 }
 
 
@@ -53,7 +61,8 @@ Model::Model()
 , root()
 , part()
 , body_id(0)
-, eyes_id(0) {
+, eyes_id(0)
+, merged() {
 
 }
 
@@ -69,6 +78,16 @@ void Model::Instantiate(Instance &inst) const {
 	inst.state.resize(part.size());
 }
 
+const EntityMesh &Model::MergedMesh() const {
+	if (!merged) {
+		EntityMesh::Buffer parts;
+		root.FillRestPose(parts, glm::mat4(1.0f));
+		merged.reset(new EntityMesh());
+		merged->Update(parts);
+	}
+	return *merged;
+}
+
 
 ModelRegistry::ModelRegistry()
 : models()
@@ -108,6 +127,7 @@ Part::Part()
 , children()
 , tex_map()
 , mesh()
+, radius(0.0f)
 , initial()
 , hsl_mod(0, 255, 255)
 , rgb_mod(255, 255, 255)
@@ -212,26 +232,52 @@ EntityMesh::Buffer buf;
 
 }
 
+const EntityMesh &Part::Mesh() const {
+	if (!mesh) {
+		buf.Clear();
+		buf.hsl_mods.resize(shape->VertexCount(), hsl_mod);
+		buf.rgb_mods.resize(shape->VertexCount(), rgb_mod);
+		shape->Fill(buf, tex_map);
+		radius = 0.0f;
+		for (const EntityMesh::Position &pos : buf.vertices) {
+			radius = std::max(radius, glm::length(pos));
+		}
+		mesh.reset(new EntityMesh());
+		mesh->Update(buf);
+	}
+	return *mesh;
+}
+
 void Part::Render(
 	const glm::mat4 &M,
 	const Instance &inst,
-	DirectionalLighting &prog
+	EntityBatch &batch,
+	float min_radius
 ) const {
 	glm::mat4 transform = M * LocalTransform(inst);
 	if (shape && shape->IndexCount() > 0) {
-		if (!mesh) {
-			buf.Clear();
-			buf.hsl_mods.resize(shape->VertexCount(), hsl_mod);
-			buf.rgb_mods.resize(shape->VertexCount(), rgb_mod);
-			shape->Fill(buf, tex_map);
-			mesh.reset(new EntityMesh());
-			mesh->Update(buf);
+		const EntityMesh &m = Mesh();
+		if (radius < min_radius) {
+			return;
 		}
-		prog.SetM(transform);
-		mesh->Draw();
+		batch.Add(m, transform);
+	}
+	for (const Part &part : children) {
+		part.Render(transform, inst, batch, min_radius);
+	}
+}
+
+void Part::FillRestPose(EntityMesh::Buffer &out, const glm::mat4 &M) const {
+	glm::mat4 transform(glm::toMat4(initial.orientation));
+	transform[3] = glm::vec4(initial.position, 1.0f);
+	transform = M * transform;
+	if (shape && shape->IndexCount() > 0) {
+		shape->Fill(out, transform, tex_map, out.vertices.size());
+		out.hsl_mods.resize(out.vertices.size(), hsl_mod);
+		out.rgb_mods.resize(out.vertices.size(), rgb_mod);
 	}
 	for (const Part &part : children) {
-		part.Render(transform, inst, prog);
+		part.FillRestPose(out, transform);
 	}
 }
 
@@ -144,7 +144,8 @@ void Shape::Fill(
 void Shape::Fill(
 	EntityMesh::Buffer &buf,
 	const glm::mat4 &transform,
-	const vector<float> &tex_map
+	const vector<float> &tex_map,
+	size_t idx_offset
 ) const {
 	for (const auto &vtx : vertices) {
 		buf.vertices.emplace_back(transform * glm::vec4(vtx.position, 1.0f));
@@ -152,7 +153,7 @@ void Shape::Fill(
 		buf.tex_coords.emplace_back(vtx.tex_st.s, vtx.tex_st.t, TexR(tex_map, vtx.tex_id));
 	}
 	for (auto idx : indices) {
-		buf.indices.emplace_back(idx);
+		buf.indices.emplace_back(idx_offset + idx);
 	}
 }
 
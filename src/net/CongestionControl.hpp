@@ -16,6 +16,16 @@ public:
 		UGLY,
 	};
 
+	/// what kind of traffic is asking for send budget
+	enum Priority {
+		/// large data that may be delayed arbitrarily, like chunks
+		BULK,
+		/// state that is superseded by the next one, like entity updates
+		UPDATE,
+		/// must go out right away, like block updates or spawns
+		URGENT,
+	};
+
 public:
 	CongestionControl();
 
@@ -35,9 +45,24 @@ public:
 	/// estimated kilobytes received per second
 	float Downstream() const noexcept { return rx_kbps; }
 
+	/// bytes per second this connection should send at most
+	float SendRate() const noexcept { return rate; }
+	/// bytes that may be sent right now at given priority
+	/// lower priorities leave part of the budget to higher ones,
+	/// so the result may be negative
+	int Budget(Priority) const noexcept;
+	/// add budget for dt milliseconds of sending at current rate
+	void Refill(int dt) noexcept;
+	/// bytes sent over the lifetime of the connection, including overhead
+	std::uint64_t BytesSent() const noexcept { return tx_total; }
+	/// bytes received over the lifetime of the connection, including overhead
+	std::uint64_t BytesReceived() const noexcept { return rx_total; }
+
 	void PacketSent(std::uint16_t) noexcept;
-	void PacketLost(std::uint16_t) noexcept;
-	void PacketReceived(std::uint16_t) noexcept;
+	/// stamp is the SDL tick at which the packet carrying the
+	/// information arrived
+	void PacketLost(std::uint16_t, Uint32 stamp) noexcept;
+	void PacketReceived(std::uint16_t, Uint32 stamp) noexcept;
 
 	void PacketIn(const UDPpacket &) noexcept;
 	void PacketOut(const UDPpacket &) noexcept;
@@ -45,7 +70,12 @@ public:
 private:
 	void UpdatePacketLoss() noexcept;
 
-	void UpdateRTT(std::uint16_t) noexcept;
+	void UpdateRTT(std::uint16_t, Uint32 stamp) noexcept;
+
+	/// bytes that may be sent at once
+	float Burst() const noexcept;
+	void IncreaseRate(Uint32 stamp) noexcept;
+	void DecreaseRate(Uint32 stamp, float factor) noexcept;
 	bool SamplePacket(std::uint16_t) const noexcept;
 	std::size_t SampleIndex(std::uint16_t) const noexcept;
 
@@ -69,10 +99,13 @@ private:
 	Uint32 stamps[16];
 	std::uint16_t stamp_last;
 	float rtt;
+	float rtt_min;
 
 	Uint32 next_sample;
 	std::size_t tx_bytes;
 	std::size_t rx_bytes;
+	std::uint64_t tx_total;
+	std::uint64_t rx_total;
 	float tx_kbps;
 	float rx_kbps;
 
@@ -86,6 +119,16 @@ private:
 	Uint32 mode_keep_time;
 	Uint32 mode_step;
 
+	const float min_rate;
+	const float max_rate;
+	const float rate_step;
+	float rate;
+	float budget;
+	bool slow_start;
+	Uint32 rate_changed;
+	Uint32 rate_decreased;
+	std::size_t rate_bytes;
+
 };
 
 }
@@ -2,9 +2,13 @@
 #define BLANK_NET_CONNECTION_HPP_
 
 #include "Packet.hpp"
+#include "udp.hpp"
 #include "../app/IntervalTimer.hpp"
 
+#include <atomic>
 #include <cstdint>
+#include <mutex>
+#include <vector>
 #include <SDL_net.h>
 
 
@@ -12,19 +16,24 @@ namespace blank {
 
 class ConnectionHandler;
 
-class Connection {
+/// Sequencing, acks, and keepalives for one remote end. When attached
+/// to a threaded socket, that part of handling packets runs on the
+/// socket's I/O thread and only packets with a payload make it to the
+/// owner, see udp::Endpoint.
+class Connection
+: public udp::Endpoint {
 
 public:
 	explicit Connection(const IPaddress &);
 
-	void SetHandler(ConnectionHandler *h) noexcept { handler = h; }
-	void RemoveHandler() noexcept { handler = nullptr; }
+	void SetHandler(ConnectionHandler *h) noexcept;
+	void RemoveHandler() noexcept { SetHandler(nullptr); }
 	bool HasHandler() const noexcept { return handler; }
 	ConnectionHandler &Handler() noexcept { return *handler; }
 
 	const IPaddress &Address() const noexcept { return addr; }
 
-	bool Matches(const IPaddress &) const noexcept;
+	bool Matches(const IPaddress &) const noexcept override;
 
 	bool ShouldPing() const noexcept;
 	bool TimedOut() const noexcept;
@@ -34,25 +43,47 @@ public:
 
 	void Update(int dt);
 
-	std::uint16_t SendPing(UDPpacket &, UDPsocket);
+	std::uint16_t SendPing(UDPpacket &, udp::Socket &);
 
-	std::uint16_t Send(UDPpacket &, UDPsocket);
-	void Received(const UDPpacket &);
+	/// queue given packet on socket, it goes out with the next flush
+	std::uint16_t Send(UDPpacket &, udp::Socket &);
+	/// handle packet that arrived at given SDL tick
+	void Received(const UDPpacket &, Uint32 stamp);
+	/// hand a packet the socket's I/O thread already filtered to the handler
+	void Deliver(const UDPpacket &);
+
+	bool Filter(const UDPpacket &, Uint32 stamp) override;
+	bool Keepalive(UDPpacket &, Uint32 now) override;
 
 private:
 	void FlagSend() noexcept;
 	void FlagRecv() noexcept;
+	/// tell the handler about acks and losses found by Filter()
+	void Notify();
 
 private:
 	ConnectionHandler *handler;
 	IPaddress addr;
 	CoarseTimer send_timer;
 	CoarseTimer recv_timer;
+	Uint32 last_send;
 
 	Packet::TControl ctrl_out;
 	Packet::TControl ctrl_in;
 
-	bool closed;
+	struct Ack {
+		std::uint16_t seq;
+		bool lost;
+	};
+	// found by Filter(), waiting for Notify()
+	std::vector<Ack> acks;
+	// what Notify() is working through
+	std::vector<Ack> acks_notify;
+
+	std::atomic<bool> closed;
+
+	// guards everything Filter() and Keepalive() touch
+	mutable std::mutex transport_mutex;
 
 };
 
@@ -4,6 +4,7 @@
 #include "CongestionControl.hpp"
 #include "Packet.hpp"
 
+#include <mutex>
 #include <SDL_net.h>
 
 
@@ -14,11 +15,24 @@ class ConnectionHandler {
 public:
 	ConnectionHandler();
 
-	const CongestionControl &NetStat() const noexcept { return cc; }
+	/// a snapshot, because the statistics may be updated by the
+	/// socket's I/O thread at any time
+	CongestionControl NetStat() const noexcept;
 
 	void PacketSent(std::uint16_t) noexcept;
-	void PacketLost(std::uint16_t);
-	void PacketReceived(std::uint16_t);
+	void PacketLost(std::uint16_t, Uint32 stamp);
+	void PacketReceived(std::uint16_t, Uint32 stamp);
+
+	/// the statistics half of PacketLost() and PacketReceived(),
+	/// safe to call from any thread
+	void RecordLost(std::uint16_t, Uint32 stamp) noexcept;
+	void RecordReceived(std::uint16_t, Uint32 stamp) noexcept;
+	/// the other half, for the owning thread only
+	void NotifyLost(std::uint16_t);
+	void NotifyReceived(std::uint16_t);
+
+	/// replenish the send budget after dt milliseconds
+	void Refill(int dt) noexcept;
 
 	void PacketIn(const UDPpacket &) noexcept;
 	void PacketOut(const UDPpacket &) noexcept;
@@ -48,6 +62,7 @@ private:
 	virtual void On(const Packet::Message &) { }
 
 private:
+	mutable std::mutex cc_mutex;
 	CongestionControl cc;
 
 };
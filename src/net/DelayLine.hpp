@@ -0,0 +1,61 @@
+#ifndef BLANK_NET_DELAYLINE_HPP_
+#define BLANK_NET_DELAYLINE_HPP_
+
+#include "udp.hpp"
+#include "../rand/GaloisLFSR.hpp"
+
+#include <cstdint>
+#include <vector>
+#include <SDL_net.h>
+
+
+namespace blank {
+namespace udp {
+
+/// holds back, drops, and duplicates packets according to an Impairment
+class DelayLine {
+
+public:
+	DelayLine(const Impairment &, std::size_t packet_size, std::uint64_t seed);
+
+	/// feed a packet passing through at time now
+	void Push(const UDPpacket &, Uint32 now);
+	/// get the next packet that is due at time now or nullptr if none is
+	/// stays valid until the next call to Pop()
+	const UDPpacket *Pop(Uint32 now);
+	/// milliseconds until the next packet is due, -1 if there is none
+	int NextDue(Uint32 now) const noexcept;
+
+private:
+	struct Held {
+		Uint32 due;
+		std::uint64_t order;
+		IPaddress address;
+		std::vector<Uint8> data;
+		bool operator <(const Held &other) const noexcept {
+			// inverted for a min heap
+			return due > other.due || (due == other.due && order > other.order);
+		}
+	};
+
+private:
+	Impairment conf;
+	GaloisLFSR random;
+	std::size_t packet_size;
+
+	std::vector<Held> held;
+	std::uint64_t counter;
+	// time at which the simulated link has drained everything so far
+	double link_free;
+	// due time of the last packet that isn't supposed to be reordered
+	Uint32 last_due;
+
+	std::vector<Uint8> current_data;
+	UDPpacket current;
+
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef BLANK_NET_NETCLOCK_HPP_
+#define BLANK_NET_NETCLOCK_HPP_
+
+#include <atomic>
+#include <SDL.h>
+
+
+namespace blank {
+
+/// Milliseconds that connection timing (RTT samples, rate changes,
+/// and quality modes) is measured in. Follows SDL_GetTicks(), unless
+/// a replay pins it to the recorded session's time, so that timing
+/// comes out the same however fast the replay runs.
+class NetClock {
+
+public:
+	static Uint32 Now() noexcept {
+		return pinned.load(std::memory_order_acquire)
+			? pinned_time.load(std::memory_order_relaxed)
+			: SDL_GetTicks();
+	}
+
+	/// report given time from now on, until released
+	static void Pin(Uint32 t) noexcept {
+		pinned_time.store(t, std::memory_order_relaxed);
+		pinned.store(true, std::memory_order_release);
+	}
+	/// go back to following SDL_GetTicks()
+	static void Release() noexcept {
+		pinned.store(false, std::memory_order_release);
+	}
+
+private:
+	static std::atomic<bool> pinned;
+	static std::atomic<Uint32> pinned_time;
+
+};
+
+}
+
+#endif
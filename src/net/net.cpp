@@ -2,7 +2,9 @@
 #include "Connection.hpp"
 #include "ConnectionHandler.hpp"
 #include "io.hpp"
+#include "NetClock.hpp"
 #include "Packet.hpp"
+#include "udp.hpp"
 
 #include "../app/error.hpp"
 #include "../geometry/const.hpp"
@@ -10,7 +12,9 @@
 #include "../world/Entity.hpp"
 #include "../world/EntityState.hpp"
 
+#include <algorithm>
 #include <cstring>
+#include <mutex>
 
 using namespace std;
 
@@ -33,6 +37,10 @@ constexpr size_t Packet::Message::MAX_LEN;
 constexpr size_t Packet::Message::MAX_MESSAGE_LEN;
 
 
+std::atomic<bool> NetClock::pinned(false);
+std::atomic<Uint32> NetClock::pinned_time(0);
+
+
 CongestionControl::CongestionControl()
 // I know, I know, it's an estimate (about 20 for IPv4, 48 for IPv6)
 : packet_overhead(20)
@@ -43,9 +51,12 @@ CongestionControl::CongestionControl()
 , packet_loss(0.0f)
 , stamp_last(0)
 , rtt(64.0f)
+, rtt_min(64.0f)
 , next_sample(1000)
 , tx_bytes(0)
 , rx_bytes(0)
+, tx_total(0)
+, rx_total(0)
 , tx_kbps(0.0f)
 , rx_kbps(0.0f)
 , mode(GOOD)
@@ -55,8 +66,17 @@ CongestionControl::CongestionControl()
 // rtt > 150ms or packet loss > 15% is UGLY
 , ugly_rtt(150.0f)
 , ugly_loss(0.15f)
-, mode_keep_time(1000) {
-	Uint32 now = SDL_GetTicks();
+, mode_keep_time(1000)
+// pace between 4KiB/s and 1MiB/s, starting at 32KiB/s
+, min_rate(4 * 1024)
+, max_rate(1024 * 1024)
+// grow by 4KiB/s every RTT once past slow start
+, rate_step(4 * 1024)
+, rate(32 * 1024)
+, budget(0.0f)
+, slow_start(true)
+, rate_bytes(0) {
+	Uint32 now = NetClock::Now();
 	for (Uint32 &s : stamps) {
 		s = now;
 	}
@@ -64,26 +84,31 @@ CongestionControl::CongestionControl()
 	mode_entered = now;
 	mode_reset = now;
 	mode_step = now;
+	rate_changed = now;
+	rate_decreased = now;
+	budget = Burst();
 }
 
 void CongestionControl::PacketSent(uint16_t seq) noexcept {
 	if (!SamplePacket(seq)) {
 		return;
 	}
-	stamps[SampleIndex(seq)] = SDL_GetTicks();
+	stamps[SampleIndex(seq)] = NetClock::Now();
 	stamp_last = seq;
 }
 
-void CongestionControl::PacketLost(uint16_t seq) noexcept {
+void CongestionControl::PacketLost(uint16_t seq, Uint32 stamp) noexcept {
 	++packets_lost;
 	UpdatePacketLoss();
-	UpdateRTT(seq);
+	UpdateRTT(seq, stamp);
+	DecreaseRate(stamp, 0.7f);
 }
 
-void CongestionControl::PacketReceived(uint16_t seq) noexcept {
+void CongestionControl::PacketReceived(uint16_t seq, Uint32 stamp) noexcept {
 	++packets_received;
 	UpdatePacketLoss();
-	UpdateRTT(seq);
+	UpdateRTT(seq, stamp);
+	IncreaseRate(stamp);
 }
 
 void CongestionControl::UpdatePacketLoss() noexcept {
@@ -95,15 +120,81 @@ void CongestionControl::UpdatePacketLoss() noexcept {
 	}
 }
 
-void CongestionControl::UpdateRTT(uint16_t seq) noexcept {
+void CongestionControl::UpdateRTT(uint16_t seq, Uint32 stamp) noexcept {
 	if (!SamplePacket(seq)) return;
 	int16_t diff = int16_t(stamp_last) - int16_t(seq);
 	if (diff < 0 || diff > int(15 * sample_skip)) {
 		// packet outside observed frame
 		return;
 	}
-	int cur_rtt = SDL_GetTicks() - stamps[SampleIndex(seq)];
+	// using the time of arrival rather than now keeps the time it
+	// took us to get around to handling the packet out of the RTT
+	int cur_rtt = stamp - stamps[SampleIndex(seq)];
 	rtt += (cur_rtt - rtt) * 0.1f;
+	// the minimum creeps up slowly in case the route changed
+	if (cur_rtt < rtt_min) {
+		rtt_min = cur_rtt;
+	} else {
+		rtt_min += (cur_rtt - rtt_min) * 0.01f;
+	}
+	if (cur_rtt > 2.0f * rtt_min + 20.0f) {
+		// packets are piling up in some queue along the way, back off
+		// before it overflows
+		DecreaseRate(stamp, 0.85f);
+	}
+}
+
+int CongestionControl::Budget(Priority prio) const noexcept {
+	switch (prio) {
+		case BULK:
+			return int(budget - Burst() * 0.25f);
+		case UPDATE:
+			return int(budget);
+		default:
+			return int(budget + Burst());
+	}
+}
+
+void CongestionControl::Refill(int dt) noexcept {
+	budget = min(budget + rate * dt * 0.001f, Burst());
+}
+
+float CongestionControl::Burst() const noexcept {
+	// 50ms worth, but at least two full packets
+	return max(rate * 0.05f, 2.0f * (sizeof(Packet) + packet_overhead));
+}
+
+void CongestionControl::IncreaseRate(Uint32 stamp) noexcept {
+	Uint32 interval = stamp - rate_changed;
+	if (interval < max(rtt, 10.0f)) {
+		return;
+	}
+	// only grow if the current rate is actually being used, otherwise
+	// it would climb without bound while there's nothing to send
+	if (rate_bytes * 1000.0f / interval >= rate * 0.5f) {
+		if (slow_start) {
+			rate *= 2.0f;
+		} else {
+			rate += rate_step;
+		}
+		rate = min(rate, max_rate);
+	}
+	rate_changed = stamp;
+	rate_bytes = 0;
+}
+
+void CongestionControl::DecreaseRate(Uint32 stamp, float factor) noexcept {
+	// a single congestion event tends to show up as several lost or
+	// late packets, so only react once per round trip
+	if (stamp - rate_decreased < rtt) {
+		return;
+	}
+	rate = max(rate * factor, min_rate);
+	slow_start = false;
+	budget = min(budget, Burst());
+	rate_changed = stamp;
+	rate_decreased = stamp;
+	rate_bytes = 0;
 }
 
 bool CongestionControl::SamplePacket(uint16_t seq) const noexcept {
@@ -116,16 +207,20 @@ size_t CongestionControl::SampleIndex(uint16_t seq) const noexcept {
 
 void CongestionControl::PacketIn(const UDPpacket &pack) noexcept {
 	rx_bytes += pack.len + packet_overhead;
+	rx_total += pack.len + packet_overhead;
 	UpdateStats();
 }
 
 void CongestionControl::PacketOut(const UDPpacket &pack) noexcept {
 	tx_bytes += pack.len + packet_overhead;
+	tx_total += pack.len + packet_overhead;
+	rate_bytes += pack.len + packet_overhead;
+	budget -= pack.len + packet_overhead;
 	UpdateStats();
 }
 
 void CongestionControl::UpdateStats() noexcept {
-	Uint32 now = SDL_GetTicks();
+	Uint32 now = NetClock::Now();
 	if (now < next_sample) {
 		// not yet
 		return;
@@ -150,7 +245,7 @@ void CongestionControl::UpdateMode() noexcept {
 }
 
 void CongestionControl::CheckUpgrade(Mode m) noexcept {
-	Uint32 now = SDL_GetTicks();
+	Uint32 now = NetClock::Now();
 	Uint32 time_in_mode = now - mode_entered;
 	if (time_in_mode < mode_keep_time) {
 		return;
@@ -159,7 +254,7 @@ void CongestionControl::CheckUpgrade(Mode m) noexcept {
 }
 
 void CongestionControl::ChangeMode(Mode m) noexcept {
-	Uint32 now = SDL_GetTicks();
+	Uint32 now = NetClock::Now();
 	if (m > mode) {
 		// changed to worse mode
 		// if we spent less than 10 seconds in better mode
@@ -176,7 +271,7 @@ void CongestionControl::ChangeMode(Mode m) noexcept {
 }
 
 void CongestionControl::KeepMode() noexcept {
-	mode_reset = SDL_GetTicks();
+	mode_reset = NetClock::Now();
 	// if in good mode for 10 seconds, halve keep time till down to one second
 	if (mode == GOOD && mode_keep_time > 1000 && mode_step - mode_reset > 10000) {
 		mode_keep_time /= 2;
@@ -202,19 +297,31 @@ Connection::Connection(const IPaddress &addr)
 // acks that the remote end will use to measure RTT
 , send_timer(50)
 , recv_timer(10000)
+, last_send(NetClock::Now())
 , ctrl_out{ 0, 0xFFFF, 0xFFFFFFFF }
 , ctrl_in{ 0, 0xFFFF, 0xFFFFFFFF }
-, closed(false) {
+, acks()
+, acks_notify()
+, closed(false)
+, transport_mutex() {
 	send_timer.Start();
 	recv_timer.Start();
 }
 
+void Connection::SetHandler(ConnectionHandler *h) noexcept {
+	lock_guard<mutex> lock(transport_mutex);
+	handler = h;
+	// whatever was found for the old one is of no use to the new one
+	acks.clear();
+}
+
 bool Connection::Matches(const IPaddress &remote) const noexcept {
 	return memcmp(&addr, &remote, sizeof(IPaddress)) == 0;
 }
 
 void Connection::FlagSend() noexcept {
 	send_timer.Reset();
+	last_send = NetClock::Now();
 }
 
 void Connection::FlagRecv() noexcept {
@@ -222,16 +329,25 @@ void Connection::FlagRecv() noexcept {
 }
 
 bool Connection::ShouldPing() const noexcept {
+	lock_guard<mutex> lock(transport_mutex);
 	return !closed && send_timer.HitOnce();
 }
 
 bool Connection::TimedOut() const noexcept {
+	lock_guard<mutex> lock(transport_mutex);
 	return recv_timer.HitOnce();
 }
 
 void Connection::Update(int dt) {
-	send_timer.Update(dt);
-	recv_timer.Update(dt);
+	{
+		lock_guard<mutex> lock(transport_mutex);
+		send_timer.Update(dt);
+		recv_timer.Update(dt);
+	}
+	Notify();
+	if (HasHandler()) {
+		Handler().Refill(dt);
+	}
 	if (TimedOut()) {
 		Close();
 		if (HasHandler()) {
@@ -241,30 +357,80 @@ void Connection::Update(int dt) {
 }
 
 
-uint16_t Connection::Send(UDPpacket &udp_pack, UDPsocket sock) {
+uint16_t Connection::Send(UDPpacket &udp_pack, udp::Socket &sock) {
 	Packet &pack = *reinterpret_cast<Packet *>(udp_pack.data);
-	pack.header.ctrl = ctrl_out;
-	uint16_t seq = ctrl_out.seq++;
+	uint16_t seq;
+	{
+		lock_guard<mutex> lock(transport_mutex);
+		pack.header.ctrl = ctrl_out;
+		seq = ctrl_out.seq++;
+		FlagSend();
+	}
 
 	udp_pack.address = addr;
-	if (SDLNet_UDP_Send(sock, -1, &udp_pack) == 0) {
-		throw NetError("SDLNet_UDP_Send");
-	}
+	sock.Queue(udp_pack);
 
 	if (HasHandler()) {
 		Handler().PacketOut(udp_pack);
 		Handler().PacketSent(seq);
 	}
 
-	FlagSend();
 	return seq;
 }
 
-void Connection::Received(const UDPpacket &udp_pack) {
+uint16_t Connection::SendPing(UDPpacket &udp_pack, udp::Socket &sock) {
+	Packet::Make<Packet::Ping>(udp_pack);
+	return Send(udp_pack, sock);
+}
+
+bool Connection::Keepalive(UDPpacket &udp_pack, Uint32 now) {
+	lock_guard<mutex> lock(transport_mutex);
+	if (closed || now - last_send < Uint32(send_timer.Interval())) {
+		return false;
+	}
+	Packet::Make<Packet::Ping>(udp_pack);
 	Packet &pack = *reinterpret_cast<Packet *>(udp_pack.data);
+	pack.header.ctrl = ctrl_out;
+	uint16_t seq = ctrl_out.seq++;
+	udp_pack.address = addr;
+	FlagSend();
+	if (handler) {
+		handler->PacketOut(udp_pack);
+		handler->PacketSent(seq);
+	}
+	return true;
+}
+
+void Connection::Received(const UDPpacket &udp_pack, Uint32 stamp) {
+	if (Filter(udp_pack, stamp)) {
+		Deliver(udp_pack);
+	} else {
+		Notify();
+	}
+}
+
+void Connection::Deliver(const UDPpacket &udp_pack) {
+	if (HasHandler()) {
+		Handler().Handle(udp_pack);
+	}
+	Notify();
+}
+
+bool Connection::Filter(const UDPpacket &udp_pack, Uint32 stamp) {
+	const Packet &pack = *reinterpret_cast<const Packet *>(udp_pack.data);
+	if (udp_pack.len < int(sizeof(Packet::Header)) || pack.header.tag != Packet::TAG) {
+		// not one of ours, drop
+		return false;
+	}
+	lock_guard<mutex> lock(transport_mutex);
 
 	// ack to the remote
 	int16_t diff = int16_t(pack.header.ctrl.seq) - int16_t(ctrl_out.ack);
+	if (diff == 0 || (diff < 0 && diff >= -32 && (ctrl_out.hist & (1 << (-diff - 1))))) {
+		// already got that one, the network must have duplicated it
+		FlagRecv();
+		return false;
+	}
 	if (diff > 0) {
 		if (diff >= 32) {
 			ctrl_out.hist = 0;
@@ -272,19 +438,19 @@ void Connection::Received(const UDPpacket &udp_pack) {
 			ctrl_out.hist <<= diff;
 			ctrl_out.hist |= 1 << (diff - 1);
 		}
-	} else if (diff < 0 && diff >= -32) {
+		ctrl_out.ack = pack.header.ctrl.seq;
+	} else if (diff >= -32) {
+		// late arrival, ack it without moving back in time
 		ctrl_out.hist |= 1 << (-diff - 1);
 	}
-	ctrl_out.ack = pack.header.ctrl.seq;
 	FlagRecv();
 
-	if (!HasHandler()) {
-		return;
+	if (!handler) {
+		return false;
 	}
 
 	Packet::TControl ctrl_new = pack.header.ctrl;
-	Handler().PacketIn(udp_pack);
-	Handler().Handle(udp_pack);
+	handler->PacketIn(udp_pack);
 
 	if (diff > 0) {
 		// if the packet holds more recent information
@@ -294,18 +460,43 @@ void Connection::Received(const UDPpacket &udp_pack) {
 		if (diff > 0) {
 			for (int i = 0; i < diff; ++i) {
 				if (i > 32 || (i < 32 && (ctrl_in.hist & (1 << (31 - i))) == 0)) {
-					Handler().PacketLost(ctrl_in.ack - 32 + i);
+					uint16_t seq = ctrl_in.ack - 32 + i;
+					handler->RecordLost(seq, stamp);
+					acks.push_back({ seq, true });
 				}
 			}
 		}
 		// check for newly ack'd packets
 		for (uint16_t s = ctrl_new.AckBegin(); s != ctrl_new.AckEnd(); --s) {
 			if (ctrl_new.Acks(s) && !ctrl_in.Acks(s)) {
-				Handler().PacketReceived(s);
+				handler->RecordReceived(s, stamp);
+				acks.push_back({ s, false });
 			}
 		}
 		ctrl_in = ctrl_new;
 	}
+
+	// pings carry nothing but acks, and those are taken care of now
+	return pack.Type() != Packet::Ping::TYPE;
+}
+
+void Connection::Notify() {
+	{
+		lock_guard<mutex> lock(transport_mutex);
+		swap(acks, acks_notify);
+	}
+	// not holding the lock, handlers are likely to send something
+	for (const Ack &ack : acks_notify) {
+		if (!HasHandler()) {
+			break;
+		}
+		if (ack.lost) {
+			Handler().NotifyLost(ack.seq);
+		} else {
+			Handler().NotifyReceived(ack.seq);
+		}
+	}
+	acks_notify.clear();
 }
 
 bool Packet::TControl::Acks(uint16_t s) const noexcept {
@@ -315,36 +506,63 @@ bool Packet::TControl::Acks(uint16_t s) const noexcept {
 	return (hist & (1 << (diff - 1))) != 0;
 }
 
-uint16_t Connection::SendPing(UDPpacket &udp_pack, UDPsocket sock) {
-	Packet::Make<Packet::Ping>(udp_pack);
-	return Send(udp_pack, sock);
-}
-
 
 ConnectionHandler::ConnectionHandler()
-: cc() {
+: cc_mutex()
+, cc() {
+
+}
 
+CongestionControl ConnectionHandler::NetStat() const noexcept {
+	lock_guard<mutex> lock(cc_mutex);
+	return cc;
 }
 
 void ConnectionHandler::PacketSent(uint16_t seq) noexcept {
+	lock_guard<mutex> lock(cc_mutex);
 	cc.PacketSent(seq);
 }
 
-void ConnectionHandler::PacketLost(uint16_t seq) {
+void ConnectionHandler::PacketLost(uint16_t seq, Uint32 stamp) {
+	NotifyLost(seq);
+	RecordLost(seq, stamp);
+}
+
+void ConnectionHandler::PacketReceived(uint16_t seq, Uint32 stamp) {
+	NotifyReceived(seq);
+	RecordReceived(seq, stamp);
+}
+
+void ConnectionHandler::RecordLost(uint16_t seq, Uint32 stamp) noexcept {
+	lock_guard<mutex> lock(cc_mutex);
+	cc.PacketLost(seq, stamp);
+}
+
+void ConnectionHandler::RecordReceived(uint16_t seq, Uint32 stamp) noexcept {
+	lock_guard<mutex> lock(cc_mutex);
+	cc.PacketReceived(seq, stamp);
+}
+
+void ConnectionHandler::NotifyLost(uint16_t seq) {
 	OnPacketLost(seq);
-	cc.PacketLost(seq);
 }
 
-void ConnectionHandler::PacketReceived(uint16_t seq) {
+void ConnectionHandler::NotifyReceived(uint16_t seq) {
 	OnPacketReceived(seq);
-	cc.PacketReceived(seq);
+}
+
+void ConnectionHandler::Refill(int dt) noexcept {
+	lock_guard<mutex> lock(cc_mutex);
+	cc.Refill(dt);
 }
 
 void ConnectionHandler::PacketIn(const UDPpacket &pack) noexcept {
+	lock_guard<mutex> lock(cc_mutex);
 	cc.PacketIn(pack);
 }
 
 void ConnectionHandler::PacketOut(const UDPpacket &pack) noexcept {
+	lock_guard<mutex> lock(cc_mutex);
 	cc.PacketOut(pack);
 }
 
@@ -0,0 +1,1040 @@
+#include "udp.hpp"
+
+#include "DelayLine.hpp"
+#include "Packet.hpp"
+#include "../app/error.hpp"
+#include "../app/Profiler.hpp"
+
+#ifdef __linux__
+#  include <cerrno>
+#  include <netinet/in.h>
+#  include <poll.h>
+#  include <sys/eventfd.h>
+#  include <sys/socket.h>
+#  include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+
+namespace blank {
+namespace udp {
+
+struct Socket::Impl {
+
+	Impl(uint16_t port, size_t batch_size);
+	~Impl();
+
+	bool Wait(int timeout) noexcept;
+	size_t Receive();
+	void Queue(const UDPpacket &);
+	void Flush();
+
+	// straight to the socket, bypassing impairment
+	// returns early without data if woken
+	bool Poll(int timeout) noexcept;
+	size_t ReceiveBatch();
+	void QueueDirect(const UDPpacket &);
+	void SendBatch();
+
+	size_t batch_size;
+	size_t packet_size;
+
+	vector<Uint8> in_data;
+	vector<UDPpacket> in;
+	Uint32 in_stamp;
+
+	vector<Uint8> out_data;
+	vector<UDPpacket> out;
+	size_t out_count;
+
+	unique_ptr<DelayLine> in_line;
+	unique_ptr<DelayLine> out_line;
+
+	// read by the I/O thread, if there is one
+	atomic<bool> discard;
+
+#ifdef __linux__
+	int fd;
+	// eventfd the I/O thread gets woken through, if there is one
+	int wake_fd;
+	vector<sockaddr_in> in_addr;
+	vector<iovec> in_iov;
+	vector<mmsghdr> in_msg;
+	vector<sockaddr_in> out_addr;
+	vector<iovec> out_iov;
+	vector<mmsghdr> out_msg;
+#else
+	UDPsocket sock;
+	SDLNet_SocketSet set;
+#endif
+
+};
+
+
+/// lock free queue of packets for exactly one producer and one consumer
+/// the producer may Push() several packets and make them visible to the
+/// consumer all at once with Publish()
+class PacketRing {
+
+public:
+	struct Entry {
+		UDPpacket pack;
+		Uint32 stamp;
+		bool filtered;
+	};
+
+public:
+	PacketRing(size_t capacity, size_t packet_size);
+
+	PacketRing(const PacketRing &) = delete;
+	PacketRing &operator =(const PacketRing &) = delete;
+
+	/// producer: get next free entry or nullptr if the queue is full
+	Entry *Back() noexcept;
+	/// producer: commit the entry obtained from Back()
+	void Push() noexcept;
+	/// producer: make all pushed entries available to the consumer
+	void Publish() noexcept;
+	/// producer: number of pushed, but unpublished entries
+	size_t Pending() const noexcept;
+
+	/// consumer: get oldest published entry or nullptr if there is none
+	const Entry *Front() const noexcept;
+	/// consumer: release the entry obtained from Front()
+	void Pop() noexcept;
+
+	/// copy packet data into given entry
+	void Assign(Entry &, const UDPpacket &, Uint32 stamp) const noexcept;
+
+private:
+	size_t Next(size_t i) const noexcept { return (i + 1) % entries.size(); }
+
+private:
+	size_t packet_size;
+	vector<Uint8> data;
+	vector<Entry> entries;
+
+	// written by consumer only
+	atomic<size_t> read;
+	// written by producer only
+	atomic<size_t> write;
+	size_t pending;
+
+};
+
+
+struct Socket::Worker {
+
+	Worker(Impl &, size_t queue_size);
+	~Worker();
+
+	void Run() noexcept;
+	void SendQueued();
+	void SendKeepalives();
+	void ReceiveWaiting();
+	/// how long the I/O thread may sleep before something's due
+	int Timeout() noexcept;
+	/// get the I/O thread out of waiting on the socket
+	void Wake() noexcept;
+	/// sleep for given milliseconds or until shut down
+	void Pause(int ms) noexcept;
+	void Rethrow();
+
+	Impl &impl;
+	PacketRing in_ring;
+	PacketRing out_ring;
+
+	// staging area for packets handed to the socket's owner
+	vector<Uint8> in_data;
+	vector<UDPpacket> in;
+	vector<Uint32> in_stamp;
+	vector<bool> in_filtered;
+
+	// locked by the I/O thread for as long as it uses an endpoint
+	mutex endpoint_mutex;
+	vector<Endpoint *> endpoints;
+	vector<Uint8> keepalive_data;
+	UDPpacket keepalive;
+
+	atomic<bool> running;
+	mutex wait_mutex;
+	condition_variable wait_cond;
+
+	mutex error_mutex;
+	exception_ptr error;
+
+	thread worker;
+
+};
+
+
+Socket::Socket(uint16_t port, size_t batch_size)
+: impl(new Impl(port, batch_size))
+, worker() {
+
+}
+
+Socket::~Socket() noexcept {
+	StopThread();
+}
+
+void Socket::StartThread(size_t queue_size) {
+	if (worker) {
+		return;
+	}
+	// whatever's left in the direct queue goes out before the thread takes over
+	Flush();
+	worker.reset(new Worker(*impl, queue_size));
+}
+
+void Socket::StopThread() noexcept {
+	worker.reset();
+}
+
+void Socket::Attach(Endpoint &ep) {
+	if (!worker) {
+		return;
+	}
+	lock_guard<mutex> lock(worker->endpoint_mutex);
+	worker->endpoints.push_back(&ep);
+}
+
+void Socket::Detach(Endpoint &ep) noexcept {
+	if (!worker) {
+		return;
+	}
+	lock_guard<mutex> lock(worker->endpoint_mutex);
+	worker->endpoints.erase(
+		remove(worker->endpoints.begin(), worker->endpoints.end(), &ep),
+		worker->endpoints.end());
+}
+
+void Socket::Impair(const Impairment &conf) {
+	if (worker) {
+		throw runtime_error("cannot change impairment of a threaded socket");
+	}
+	if (conf.Enabled()) {
+		// fixed seeds so runs with the same traffic are comparable
+		impl->in_line.reset(new DelayLine(conf, impl->packet_size, 0x1F2E3D4C5B6A7988));
+		impl->out_line.reset(new DelayLine(conf, impl->packet_size, 0x8897A6B5C4D3E2F1));
+	} else {
+		impl->in_line.reset();
+		impl->out_line.reset();
+	}
+}
+
+void Socket::Discard() noexcept {
+	impl->discard = true;
+}
+
+bool Socket::Wait(int timeout) noexcept {
+	if (!worker) {
+		return impl->Wait(timeout);
+	}
+	unique_lock<mutex> lock(worker->wait_mutex);
+	return worker->wait_cond.wait_for(lock, chrono::milliseconds(timeout), [this]() {
+		return worker->in_ring.Front() != nullptr;
+	});
+}
+
+size_t Socket::Receive() {
+	if (!worker) {
+		size_t count = impl->Receive();
+		impl->in_stamp = SDL_GetTicks();
+		return count;
+	}
+	worker->Rethrow();
+	size_t count = 0;
+	while (count < impl->batch_size) {
+		const PacketRing::Entry *entry = worker->in_ring.Front();
+		if (!entry) {
+			break;
+		}
+		UDPpacket &dst = worker->in[count];
+		dst.len = entry->pack.len;
+		dst.status = entry->pack.status;
+		dst.address = entry->pack.address;
+		memcpy(dst.data, entry->pack.data, dst.len);
+		worker->in_stamp[count] = entry->stamp;
+		worker->in_filtered[count] = entry->filtered;
+		worker->in_ring.Pop();
+		++count;
+	}
+	return count;
+}
+
+const UDPpacket &Socket::Received(size_t i) const noexcept {
+	return worker ? worker->in[i] : impl->in[i];
+}
+
+Uint32 Socket::ReceivedAt(size_t i) const noexcept {
+	return worker ? worker->in_stamp[i] : impl->in_stamp;
+}
+
+bool Socket::Filtered(size_t i) const noexcept {
+	return worker && worker->in_filtered[i];
+}
+
+void Socket::Queue(const UDPpacket &pack) {
+	if (!worker) {
+		impl->Queue(pack);
+		return;
+	}
+	PacketRing::Entry *entry = worker->out_ring.Back();
+	if (!entry) {
+		// the I/O thread can't keep up, let it have what we've got
+		// and drop this one. the remote end will treat it as lost.
+		worker->out_ring.Publish();
+		worker->Wake();
+		return;
+	}
+	worker->out_ring.Assign(*entry, pack, 0);
+	worker->out_ring.Push();
+}
+
+size_t Socket::Queued() const noexcept {
+	return worker ? worker->out_ring.Pending() : impl->out_count;
+}
+
+void Socket::Flush() {
+	if (worker) {
+		worker->Rethrow();
+		worker->out_ring.Publish();
+		worker->Wake();
+	} else {
+		impl->Flush();
+	}
+}
+
+size_t Socket::BatchSize() const noexcept {
+	return impl->batch_size;
+}
+
+
+Socket::Impl::Impl(uint16_t port, size_t batch_size)
+: batch_size(max(batch_size, size_t(1)))
+, packet_size(sizeof(Packet))
+, in_data(this->batch_size * packet_size)
+, in(this->batch_size)
+, in_stamp(0)
+, out_data(this->batch_size * packet_size)
+, out(this->batch_size)
+, out_count(0)
+, in_line()
+, out_line()
+, discard(false)
+#ifdef __linux__
+, fd(-1)
+, wake_fd(-1)
+, in_addr(this->batch_size)
+, in_iov(this->batch_size)
+, in_msg(this->batch_size)
+, out_addr(this->batch_size)
+, out_iov(this->batch_size)
+, out_msg(this->batch_size)
+#else
+, sock(nullptr)
+, set(nullptr)
+#endif
+{
+	for (size_t i = 0; i < this->batch_size; ++i) {
+		in[i].channel = -1;
+		in[i].data = &in_data[i * packet_size];
+		in[i].maxlen = packet_size;
+		out[i].channel = -1;
+		out[i].data = &out_data[i * packet_size];
+		out[i].maxlen = packet_size;
+#ifdef __linux__
+		in_iov[i].iov_base = in[i].data;
+		in_iov[i].iov_len = packet_size;
+		memset(&in_msg[i], 0, sizeof(mmsghdr));
+		in_msg[i].msg_hdr.msg_name = &in_addr[i];
+		in_msg[i].msg_hdr.msg_iov = &in_iov[i];
+		in_msg[i].msg_hdr.msg_iovlen = 1;
+		out_iov[i].iov_base = out[i].data;
+		memset(&out_msg[i], 0, sizeof(mmsghdr));
+		out_msg[i].msg_hdr.msg_name = &out_addr[i];
+		out_msg[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+		out_msg[i].msg_hdr.msg_iov = &out_iov[i];
+		out_msg[i].msg_hdr.msg_iovlen = 1;
+#endif
+	}
+
+#ifdef __linux__
+	fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd == -1) {
+		throw SysError("socket");
+	}
+	sockaddr_in local;
+	memset(&local, 0, sizeof(sockaddr_in));
+	local.sin_family = AF_INET;
+	local.sin_addr.s_addr = htonl(INADDR_ANY);
+	local.sin_port = htons(port);
+	if (bind(fd, reinterpret_cast<sockaddr *>(&local), sizeof(sockaddr_in)) == -1) {
+		int err = errno;
+		close(fd);
+		throw SysError(err, "bind");
+	}
+#else
+	set = SDLNet_AllocSocketSet(1);
+	if (!set) {
+		throw NetError("SDLNet_AllocSocketSet");
+	}
+	sock = SDLNet_UDP_Open(port);
+	if (!sock) {
+		SDLNet_FreeSocketSet(set);
+		throw NetError("SDLNet_UDP_Open");
+	}
+	if (SDLNet_UDP_AddSocket(set, sock) == -1) {
+		SDLNet_UDP_Close(sock);
+		SDLNet_FreeSocketSet(set);
+		throw NetError("SDLNet_UDP_AddSocket");
+	}
+#endif
+}
+
+Socket::Impl::~Impl() {
+#ifdef __linux__
+	close(fd);
+#else
+	SDLNet_UDP_DelSocket(set, sock);
+	SDLNet_UDP_Close(sock);
+	SDLNet_FreeSocketSet(set);
+#endif
+}
+
+
+bool Socket::Impl::Wait(int timeout) noexcept {
+	if (in_line) {
+		int due = in_line->NextDue(SDL_GetTicks());
+		if (due == 0) {
+			return true;
+		}
+		if (due > 0 && (timeout < 0 || due < timeout)) {
+			timeout = due;
+		}
+	}
+	// the socket having data doesn't mean anything is due yet, but
+	// Receive() handles coming up empty
+	return Poll(timeout) || (in_line && in_line->NextDue(SDL_GetTicks()) == 0);
+}
+
+size_t Socket::Impl::Receive() {
+	size_t count = ReceiveBatch();
+	if (!in_line) {
+		return count;
+	}
+	Uint32 now = SDL_GetTicks();
+	for (size_t i = 0; i < count; ++i) {
+		in_line->Push(in[i], now);
+	}
+	count = 0;
+	while (count < batch_size) {
+		const UDPpacket *pack = in_line->Pop(now);
+		if (!pack) {
+			break;
+		}
+		in[count].len = pack->len;
+		in[count].status = pack->len;
+		in[count].address = pack->address;
+		memcpy(in[count].data, pack->data, pack->len);
+		++count;
+	}
+	return count;
+}
+
+void Socket::Impl::Queue(const UDPpacket &pack) {
+	if (discard) {
+		return;
+	}
+	if (out_line) {
+		out_line->Push(pack, SDL_GetTicks());
+	} else {
+		QueueDirect(pack);
+	}
+}
+
+void Socket::Impl::Flush() {
+	if (discard) {
+		// whatever got queued before
+		out_count = 0;
+		return;
+	}
+	if (out_line) {
+		Uint32 now = SDL_GetTicks();
+		for (const UDPpacket *pack = out_line->Pop(now); pack; pack = out_line->Pop(now)) {
+			QueueDirect(*pack);
+		}
+	}
+	if (out_count > 0) {
+		SendBatch();
+	}
+}
+
+void Socket::Impl::QueueDirect(const UDPpacket &pack) {
+	if (out_count >= batch_size) {
+		SendBatch();
+	}
+	UDPpacket &slot = out[out_count];
+	slot.len = min(size_t(pack.len), packet_size);
+	slot.address = pack.address;
+	memcpy(slot.data, pack.data, slot.len);
+	++out_count;
+}
+
+
+#ifdef __linux__
+
+bool Socket::Impl::Poll(int timeout) noexcept {
+	pollfd pfd[2];
+	pfd[0].fd = fd;
+	pfd[0].events = POLLIN;
+	pfd[0].revents = 0;
+	pfd[1].fd = wake_fd;
+	pfd[1].events = POLLIN;
+	pfd[1].revents = 0;
+	if (poll(pfd, wake_fd == -1 ? 1 : 2, timeout) <= 0) {
+		return false;
+	}
+	if (pfd[1].revents & POLLIN) {
+		// resets the counter, nothing to be done if that fails
+		uint64_t count;
+		ssize_t result = read(wake_fd, &count, sizeof(count));
+		static_cast<void>(result);
+	}
+	return pfd[0].revents & POLLIN;
+}
+
+size_t Socket::Impl::ReceiveBatch() {
+	for (size_t i = 0; i < batch_size; ++i) {
+		// gets overwritten with the actual address length on receive
+		in_msg[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+	}
+	int result = recvmmsg(fd, in_msg.data(), batch_size, MSG_DONTWAIT, nullptr);
+	if (result == -1) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+			return 0;
+		}
+		throw SysError("recvmmsg");
+	}
+	for (int i = 0; i < result; ++i) {
+		in[i].len = in_msg[i].msg_len;
+		in[i].status = in[i].len;
+		// both IPaddress and sockaddr_in are in network byte order
+		in[i].address.host = in_addr[i].sin_addr.s_addr;
+		in[i].address.port = in_addr[i].sin_port;
+	}
+	return result;
+}
+
+void Socket::Impl::SendBatch() {
+	for (size_t i = 0; i < out_count; ++i) {
+		out_addr[i].sin_family = AF_INET;
+		out_addr[i].sin_addr.s_addr = out[i].address.host;
+		out_addr[i].sin_port = out[i].address.port;
+		out_iov[i].iov_len = out[i].len;
+	}
+	size_t sent = 0;
+	while (sent < out_count) {
+		int result = sendmmsg(fd, &out_msg[sent], out_count - sent, MSG_DONTWAIT);
+		if (result == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				// send buffer is full, drop the rest like the
+				// network would. acks will sort it out.
+				break;
+			}
+			out_count = 0;
+			throw SysError("sendmmsg");
+		}
+		sent += result;
+	}
+	out_count = 0;
+}
+
+#else
+
+bool Socket::Impl::Poll(int timeout) noexcept {
+	return SDLNet_CheckSockets(set, timeout) > 0;
+}
+
+size_t Socket::Impl::ReceiveBatch() {
+	size_t count = 0;
+	while (count < batch_size) {
+		int result = SDLNet_UDP_Recv(sock, &in[count]);
+		if (result == 0) {
+			break;
+		}
+		if (result == -1) {
+			throw NetError("SDLNet_UDP_Recv");
+		}
+		++count;
+	}
+	return count;
+}
+
+void Socket::Impl::SendBatch() {
+	size_t count = out_count;
+	out_count = 0;
+	for (size_t i = 0; i < count; ++i) {
+		if (SDLNet_UDP_Send(sock, -1, &out[i]) == 0) {
+			throw NetError("SDLNet_UDP_Send");
+		}
+	}
+}
+
+#endif
+
+
+namespace {
+
+bool parse_percent(const string &value, float &out) {
+	char *end;
+	float v = strtof(value.c_str(), &end);
+	if (value.empty() || *end != '\0' || v < 0.0f || v > 100.0f) {
+		return false;
+	}
+	out = v * 0.01f;
+	return true;
+}
+
+bool parse_int(const string &value, int &out) {
+	char *end;
+	long v = strtol(value.c_str(), &end, 10);
+	if (value.empty() || *end != '\0' || v < 0 || v > 0x7FFFFFFF) {
+		return false;
+	}
+	out = v;
+	return true;
+}
+
+}
+
+Impairment Impairment::Parse(const string &spec) {
+	Impairment result;
+	string::size_type begin = 0;
+	while (begin <= spec.size()) {
+		string::size_type end = spec.find(',', begin);
+		if (end == string::npos) {
+			end = spec.size();
+		}
+		string entry(spec, begin, end - begin);
+		begin = end + 1;
+		if (entry.empty()) {
+			continue;
+		}
+		string::size_type eq = entry.find('=');
+		if (eq == string::npos) {
+			if (entry == "none") {
+				result = Impairment();
+			} else if (entry == "lan") {
+				result = Impairment();
+				result.latency = 1;
+				result.jitter = 1;
+			} else if (entry == "wifi") {
+				result = Impairment();
+				result.loss = 0.01f;
+				result.latency = 5;
+				result.jitter = 15;
+			} else if (entry == "dsl") {
+				result = Impairment();
+				result.loss = 0.005f;
+				result.latency = 20;
+				result.jitter = 5;
+				result.bandwidth = 256 * 1024;
+			} else if (entry == "mobile") {
+				result = Impairment();
+				result.loss = 0.03f;
+				result.duplicate = 0.01f;
+				result.reorder = 0.02f;
+				result.latency = 60;
+				result.jitter = 40;
+				result.bandwidth = 64 * 1024;
+			} else if (entry == "awful") {
+				result = Impairment();
+				result.loss = 0.15f;
+				result.duplicate = 0.05f;
+				result.reorder = 0.05f;
+				result.latency = 150;
+				result.jitter = 100;
+				result.bandwidth = 16 * 1024;
+			} else {
+				throw runtime_error("unknown network profile " + entry);
+			}
+			continue;
+		}
+		string key(entry, 0, eq);
+		string value(entry, eq + 1);
+		bool valid;
+		if (key == "loss") {
+			valid = parse_percent(value, result.loss);
+		} else if (key == "duplicate") {
+			valid = parse_percent(value, result.duplicate);
+		} else if (key == "reorder") {
+			valid = parse_percent(value, result.reorder);
+		} else if (key == "latency") {
+			valid = parse_int(value, result.latency);
+		} else if (key == "jitter") {
+			valid = parse_int(value, result.jitter);
+		} else if (key == "bandwidth") {
+			valid = parse_int(value, result.bandwidth);
+		} else {
+			throw runtime_error("unknown network impairment " + key);
+		}
+		if (!valid) {
+			throw runtime_error("bad value for network impairment " + key + ": " + value);
+		}
+	}
+	return result;
+}
+
+
+DelayLine::DelayLine(const Impairment &conf, size_t packet_size, uint64_t seed)
+: conf(conf)
+, random(seed)
+, packet_size(packet_size)
+, held()
+, counter(0)
+, link_free(0.0)
+, last_due(0)
+, current_data(packet_size)
+, current() {
+	current.channel = -1;
+	current.data = current_data.data();
+	current.maxlen = packet_size;
+}
+
+void DelayLine::Push(const UDPpacket &pack, Uint32 now) {
+	if (conf.loss > 0.0f && random.UNorm() < conf.loss) {
+		return;
+	}
+	int copies = (conf.duplicate > 0.0f && random.UNorm() < conf.duplicate) ? 2 : 1;
+	size_t len = min(size_t(pack.len), packet_size);
+	for (int i = 0; i < copies; ++i) {
+		double sent = now;
+		if (conf.bandwidth > 0) {
+			link_free = max(link_free, double(now));
+			if (link_free - now > 500.0) {
+				// more than half a second's worth queued up, the
+				// router would start dropping
+				return;
+			}
+			link_free += len * 1000.0 / conf.bandwidth;
+			sent = link_free;
+		}
+		Uint32 due = Uint32(sent) + conf.latency;
+		if (conf.jitter > 0) {
+			due += Uint32(random.UNorm() * conf.jitter);
+		}
+		if (conf.reorder > 0.0f && random.UNorm() < conf.reorder) {
+			// hold back long enough for some followers to overtake
+			due += conf.jitter + 10 + Uint32(random.UNorm() * 20.0f);
+		} else {
+			// jitter alone doesn't reorder packets on a real link
+			due = max(due, last_due);
+			last_due = due;
+		}
+		held.emplace_back();
+		Held &h = held.back();
+		h.due = due;
+		h.order = counter++;
+		h.address = pack.address;
+		h.data.assign(pack.data, pack.data + len);
+		push_heap(held.begin(), held.end());
+	}
+}
+
+const UDPpacket *DelayLine::Pop(Uint32 now) {
+	if (held.empty() || held.front().due > now) {
+		return nullptr;
+	}
+	pop_heap(held.begin(), held.end());
+	Held &h = held.back();
+	current.len = h.data.size();
+	current.status = current.len;
+	current.address = h.address;
+	memcpy(current.data, h.data.data(), h.data.size());
+	held.pop_back();
+	return &current;
+}
+
+int DelayLine::NextDue(Uint32 now) const noexcept {
+	if (held.empty()) {
+		return -1;
+	}
+	return held.front().due > now ? held.front().due - now : 0;
+}
+
+
+PacketRing::PacketRing(size_t capacity, size_t packet_size)
+: packet_size(packet_size)
+// one entry always stays empty to tell a full ring from an empty one
+, data((capacity + 1) * packet_size)
+, entries(capacity + 1)
+, read(0)
+, write(0)
+, pending(0) {
+	for (size_t i = 0; i < entries.size(); ++i) {
+		entries[i].pack.channel = -1;
+		entries[i].pack.data = &data[i * packet_size];
+		entries[i].pack.maxlen = packet_size;
+		entries[i].stamp = 0;
+		entries[i].filtered = false;
+	}
+}
+
+PacketRing::Entry *PacketRing::Back() noexcept {
+	if (Next(pending) == read.load(memory_order_acquire)) {
+		return nullptr;
+	}
+	return &entries[pending];
+}
+
+void PacketRing::Push() noexcept {
+	pending = Next(pending);
+}
+
+void PacketRing::Publish() noexcept {
+	write.store(pending, memory_order_release);
+}
+
+size_t PacketRing::Pending() const noexcept {
+	size_t published = write.load(memory_order_relaxed);
+	return (pending + entries.size() - published) % entries.size();
+}
+
+const PacketRing::Entry *PacketRing::Front() const noexcept {
+	size_t r = read.load(memory_order_relaxed);
+	if (r == write.load(memory_order_acquire)) {
+		return nullptr;
+	}
+	return &entries[r];
+}
+
+void PacketRing::Pop() noexcept {
+	read.store(Next(read.load(memory_order_relaxed)), memory_order_release);
+}
+
+void PacketRing::Assign(Entry &entry, const UDPpacket &pack, Uint32 stamp) const noexcept {
+	entry.pack.len = min(size_t(pack.len), packet_size);
+	entry.pack.status = entry.pack.len;
+	entry.pack.address = pack.address;
+	memcpy(entry.pack.data, pack.data, entry.pack.len);
+	entry.stamp = stamp;
+	entry.filtered = false;
+}
+
+
+namespace {
+
+// how often the I/O thread checks endpoints for due keepalives
+constexpr int keepalive_check = 10;
+// longest pause after a failing socket operation
+constexpr int max_backoff = 1000;
+
+}
+
+Socket::Worker::Worker(Impl &impl, size_t queue_size)
+: impl(impl)
+, in_ring(queue_size, impl.packet_size)
+, out_ring(queue_size, impl.packet_size)
+, in_data(impl.batch_size * impl.packet_size)
+, in(impl.batch_size)
+, in_stamp(impl.batch_size, 0)
+, in_filtered(impl.batch_size, false)
+, endpoint_mutex()
+, endpoints()
+, keepalive_data(impl.packet_size)
+, keepalive()
+, running(true)
+, wait_mutex()
+, wait_cond()
+, error_mutex()
+, error()
+, worker() {
+	for (size_t i = 0; i < impl.batch_size; ++i) {
+		in[i].channel = -1;
+		in[i].data = &in_data[i * impl.packet_size];
+		in[i].maxlen = impl.packet_size;
+	}
+	keepalive.channel = -1;
+	keepalive.data = keepalive_data.data();
+	keepalive.maxlen = impl.packet_size;
+#ifdef __linux__
+	impl.wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (impl.wake_fd == -1) {
+		throw SysError("eventfd");
+	}
+#endif
+	worker = thread(&Worker::Run, this);
+}
+
+Socket::Worker::~Worker() {
+	{
+		// so Pause() can't miss it
+		lock_guard<mutex> lock(wait_mutex);
+		running.store(false, memory_order_release);
+	}
+	wait_cond.notify_all();
+	Wake();
+	worker.join();
+#ifdef __linux__
+	close(impl.wake_fd);
+	impl.wake_fd = -1;
+#endif
+}
+
+void Socket::Worker::Run() noexcept {
+	int backoff = 0;
+	while (running.load(memory_order_acquire)) {
+		try {
+			SendQueued();
+			SendKeepalives();
+			// also releases delayed packets that became due meanwhile
+			impl.Flush();
+			if (impl.Wait(Timeout())) {
+				ReceiveWaiting();
+			}
+			backoff = 0;
+		} catch (...) {
+			{
+				lock_guard<mutex> lock(error_mutex);
+				error = current_exception();
+			}
+			// whatever failed is likely to fail again right away, so
+			// give it some time before trying again
+			backoff = backoff ? min(backoff * 2, max_backoff) : keepalive_check;
+			Pause(backoff);
+		}
+	}
+}
+
+void Socket::Worker::SendQueued() {
+	Profiler::Zone zone("udp::Socket send");
+	for (const PacketRing::Entry *entry = out_ring.Front(); entry; entry = out_ring.Front()) {
+		impl.Queue(entry->pack);
+		out_ring.Pop();
+	}
+}
+
+void Socket::Worker::SendKeepalives() {
+	Uint32 now = SDL_GetTicks();
+	lock_guard<mutex> lock(endpoint_mutex);
+	for (Endpoint *ep : endpoints) {
+		if (ep->Keepalive(keepalive, now)) {
+			impl.Queue(keepalive);
+		}
+	}
+}
+
+void Socket::Worker::ReceiveWaiting() {
+	Profiler::Zone zone("udp::Socket receive");
+	size_t count = impl.Receive();
+	if (count == 0) {
+		return;
+	}
+	Uint32 now = SDL_GetTicks();
+	{
+		lock_guard<mutex> lock(endpoint_mutex);
+		for (size_t i = 0; i < count; ++i) {
+			PacketRing::Entry *entry = in_ring.Back();
+			if (!entry) {
+				// owner isn't picking up, drop like an overflowing buffer
+				// would. this happens before filtering so the packet
+				// doesn't get acked either.
+				break;
+			}
+			const UDPpacket &pack = impl.in[i];
+			auto ep = find_if(endpoints.begin(), endpoints.end(), [&pack](const Endpoint *e) {
+				return e->Matches(pack.address);
+			});
+			bool filtered = ep != endpoints.end();
+			if (filtered && !(*ep)->Filter(pack, now)) {
+				// fully handled, nothing for the owner
+				continue;
+			}
+			in_ring.Assign(*entry, pack, now);
+			entry->filtered = filtered;
+			in_ring.Push();
+		}
+	}
+	if (in_ring.Pending() == 0) {
+		return;
+	}
+	in_ring.Publish();
+	{
+		// lock so the notification can't slip in between the owner's
+		// check and its wait
+		lock_guard<mutex> lock(wait_mutex);
+	}
+	wait_cond.notify_all();
+}
+
+int Socket::Worker::Timeout() noexcept {
+	int timeout = -1;
+	{
+		lock_guard<mutex> lock(endpoint_mutex);
+		if (!endpoints.empty()) {
+			timeout = keepalive_check;
+		}
+	}
+	if (impl.out_line) {
+		int due = impl.out_line->NextDue(SDL_GetTicks());
+		if (due >= 0 && (timeout < 0 || due < timeout)) {
+			timeout = due;
+		}
+	}
+#ifndef __linux__
+	// can't be woken, so flushed packets wait for the timeout
+	if (timeout < 0 || timeout > 1) {
+		timeout = 1;
+	}
+#endif
+	return timeout;
+}
+
+void Socket::Worker::Wake() noexcept {
+#ifdef __linux__
+	uint64_t one = 1;
+	// can only fail if the counter is about to overflow, in which
+	// case the thread's going to wake up anyway
+	ssize_t result = write(impl.wake_fd, &one, sizeof(one));
+	static_cast<void>(result);
+#endif
+}
+
+void Socket::Worker::Pause(int ms) noexcept {
+	unique_lock<mutex> lock(wait_mutex);
+	wait_cond.wait_for(lock, chrono::milliseconds(ms), [this]() {
+		return !running.load(memory_order_acquire);
+	});
+}
+
+void Socket::Worker::Rethrow() {
+	exception_ptr e;
+	{
+		lock_guard<mutex> lock(error_mutex);
+		swap(e, error);
+	}
+	if (e) {
+		rethrow_exception(e);
+	}
+}
+
+}
+}
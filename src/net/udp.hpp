@@ -0,0 +1,142 @@
+#ifndef BLANK_NET_UDP_HPP_
+#define BLANK_NET_UDP_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <SDL_net.h>
+
+
+namespace blank {
+namespace udp {
+
+/// simulated network conditions applied by a Socket to packets
+/// passing through it in either direction
+struct Impairment {
+
+	/// probability of a packet getting dropped
+	float loss = 0.0f;
+	/// probability of a packet getting delivered twice
+	float duplicate = 0.0f;
+	/// probability of a packet being held back long enough to be
+	/// overtaken by the ones following it
+	float reorder = 0.0f;
+	/// base one way delay in milliseconds
+	int latency = 0;
+	/// maximum random delay added on top of latency
+	int jitter = 0;
+	/// link capacity in bytes per second, 0 for unlimited
+	int bandwidth = 0;
+
+	bool Enabled() const noexcept {
+		return loss > 0.0f || duplicate > 0.0f || reorder > 0.0f
+			|| latency > 0 || jitter > 0 || bandwidth > 0;
+	}
+
+	/// parse a comma separated list of profile names and key=value
+	/// pairs, later entries override earlier ones
+	/// profiles are none, lan, wifi, dsl, mobile, and awful
+	/// keys are loss, duplicate, and reorder in percent, latency and
+	/// jitter in milliseconds, and bandwidth in bytes per second
+	/// throws std::runtime_error if the spec cannot be parsed
+	static Impairment Parse(const std::string &);
+
+};
+
+/// Transport level bookkeeping for packets from one remote address.
+/// A threaded Socket runs it on its I/O thread as packets arrive, so
+/// acks and keepalives keep flowing while the owner is busy with a
+/// long tick. Implementations synchronize with the owner themselves.
+class Endpoint {
+
+public:
+	virtual ~Endpoint() { }
+
+	virtual bool Matches(const IPaddress &) const noexcept = 0;
+
+	/// do the transport part of handling a packet that arrived at stamp
+	/// @return true if it carries anything for the owner
+	virtual bool Filter(const UDPpacket &, Uint32 stamp) = 0;
+
+	/// fill given packet with a keepalive if one is due at now
+	/// @return true if the packet should be sent
+	virtual bool Keepalive(UDPpacket &, Uint32 now) = 0;
+
+};
+
+/// UDP socket that queues outgoing packets and moves datagrams in
+/// batches. On linux, each batch is a single recvmmsg/sendmmsg call,
+/// elsewhere it falls back to one SDL_net call per packet.
+/// all failing functions throw NetError or SysError
+class Socket {
+
+public:
+	/// open a socket bound to given port, 0 picks any free one
+	/// batch_size is the maximum number of packets moved at once
+	explicit Socket(std::uint16_t port = 0, std::size_t batch_size = 64);
+	~Socket() noexcept;
+
+	Socket(const Socket &) = delete;
+	Socket &operator =(const Socket &) = delete;
+
+public:
+	/// hand all I/O over to a background thread
+	/// from then on, inbound packets are stamped and queued as soon as
+	/// they arrive and outbound ones go out right after Flush(),
+	/// regardless of what the calling thread is busy with
+	/// queue_size is the capacity of both the inbound and outbound queue
+	void StartThread(std::size_t queue_size = 1024);
+	/// stop the background thread, dropping anything still queued
+	void StopThread() noexcept;
+	bool Threaded() const noexcept { return bool(worker); }
+
+	/// let the I/O thread filter packets from given endpoint's address
+	/// and send its keepalives, has no effect without a thread
+	/// the endpoint must be detached before it's destroyed
+	void Attach(Endpoint &);
+	/// once this returns, the I/O thread doesn't touch the endpoint anymore
+	void Detach(Endpoint &) noexcept;
+
+	/// simulate given network conditions for all traffic through this
+	/// socket, must be called before StartThread()
+	void Impair(const Impairment &);
+
+	/// from now on, drop outgoing packets instead of sending them,
+	/// for when nobody is listening anyway, e.g. during a replay
+	void Discard() noexcept;
+
+	/// wait at most timeout milliseconds for incoming data
+	/// @return true if there is data to receive
+	bool Wait(int timeout) noexcept;
+
+	/// receive as many waiting packets as fit in a batch
+	/// @return the number of packets received, use Received() to
+	///         access them. they stay valid until the next call.
+	std::size_t Receive();
+	const UDPpacket &Received(std::size_t i) const noexcept;
+	/// SDL ticks at which packet i arrived
+	Uint32 ReceivedAt(std::size_t i) const noexcept;
+	/// true if an attached endpoint already filtered packet i
+	bool Filtered(std::size_t i) const noexcept;
+
+	/// copy given packet into the send queue, flushing it if full
+	void Queue(const UDPpacket &);
+	/// number of packets waiting to be sent
+	std::size_t Queued() const noexcept;
+	/// send all queued packets
+	void Flush();
+
+	std::size_t BatchSize() const noexcept;
+
+private:
+	struct Impl;
+	std::unique_ptr<Impl> impl;
+	struct Worker;
+	std::unique_ptr<Worker> worker;
+
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,218 @@
+#include "app/Assets.hpp"
+#include "app/Config.hpp"
+#include "app/init.hpp"
+#include "client/Client.hpp"
+#include "io/filesystem.hpp"
+#include "io/WorldSave.hpp"
+#include "net/ConnectionHandler.hpp"
+#include "net/Packet.hpp"
+#include "server/Server.hpp"
+#include "shared/WorldResources.hpp"
+#include "world/ChunkLoader.hpp"
+#include "world/ChunkStore.hpp"
+#include "world/EntityState.hpp"
+#include "world/Generator.hpp"
+#include "world/World.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace blank;
+using namespace std;
+using namespace chrono;
+
+
+namespace {
+
+/// minimal client that logs in, keeps ack'ing with player updates,
+/// and counts completed chunk transmissions
+class BenchClient
+: public ConnectionHandler {
+
+public:
+	BenchClient(const Config::Network &conf, const string &name)
+	: client(conf)
+	, name(name)
+	, login_packet(-1)
+	, joined(false)
+	, state()
+	, transmissions()
+	, chunks_complete(0) {
+		client.GetConnection().SetHandler(this);
+		login_packet = client.SendLogin(name);
+	}
+
+	void Update(int dt) {
+		client.Handle();
+		if (joined) {
+			// a real client sends one of these every frame, which is
+			// what carries the acks the chunk transmitter waits for
+			client.SendPlayerUpdate(state, glm::vec3(0.0f), 0.0f, 0.0f, 0, 0);
+		}
+		client.Update(dt);
+	}
+
+	void Part() {
+		client.SendPart();
+	}
+
+	bool Closed() const noexcept { return client.GetConnection().Closed(); }
+	size_t ChunksComplete() const noexcept { return chunks_complete; }
+
+private:
+	void OnPacketLost(uint16_t id) override {
+		if (id == login_packet) {
+			login_packet = client.SendLogin(name);
+		}
+	}
+
+	void On(const Packet::Join &pack) override {
+		pack.ReadPlayerState(state);
+		login_packet = -1;
+		joined = true;
+	}
+
+	void On(const Packet::ChunkBegin &pack) override {
+		uint32_t id;
+		pack.ReadTransmissionId(id);
+		Transmission &trans = transmissions[id];
+		pack.ReadDataSize(trans.size);
+		Check(trans);
+	}
+
+	void On(const Packet::ChunkData &pack) override {
+		uint32_t id, offset, size;
+		pack.ReadTransmissionId(id);
+		pack.ReadDataOffset(offset);
+		pack.ReadDataSize(size);
+		Transmission &trans = transmissions[id];
+		// count each piece only once, the network may have duplicated it
+		if (trans.offsets.insert(offset).second) {
+			trans.received += size;
+		}
+		Check(trans);
+	}
+
+private:
+	struct Transmission {
+		uint32_t size = 0;
+		uint32_t received = 0;
+		set<uint32_t> offsets;
+		bool complete = false;
+	};
+
+	void Check(Transmission &trans) {
+		if (!trans.complete && trans.size > 0 && trans.received >= trans.size) {
+			trans.complete = true;
+			++chunks_complete;
+		}
+	}
+
+private:
+	client::Client client;
+	string name;
+	int login_packet;
+	bool joined;
+	EntityState state;
+	map<uint32_t, Transmission> transmissions;
+	size_t chunks_complete;
+
+};
+
+}
+
+
+int main(int argc, char **argv) {
+	vector<string> profiles;
+	for (int i = 1; i < argc; ++i) {
+		profiles.push_back(argv[i]);
+	}
+	if (profiles.empty()) {
+		profiles = { "none", "lan", "wifi", "dsl", "mobile", "awful" };
+	}
+	for (const string &profile : profiles) {
+		// fail early rather than after loading the world
+		udp::Impairment::Parse(profile);
+	}
+
+	InitHeadless init;
+	AssetLoader loader("assets/");
+	WorldResources res;
+	res.Load(loader, "default");
+	TempDir dir;
+	WorldSave save(dir.Path());
+	World::Config wc;
+	World world(res.block_types, wc);
+	Generator::Config gc;
+	Generator gen(gc);
+	gen.LoadTypes(res.block_types);
+	ChunkLoader chunk_loader(world.Chunks(), gen, save);
+
+	// players get an index of extent 6 around their chunk, have it all
+	// loaded beforehand so only the network is measured
+	constexpr int extent = 6;
+	constexpr size_t full_view = (2 * extent + 1) * (2 * extent + 1) * (2 * extent + 1);
+	ChunkIndex &view = world.Chunks().MakeIndex(wc.spawn, extent);
+	cout << "loading " << full_view << " chunks around spawn" << endl;
+	chunk_loader.LoadN(chunk_loader.ToLoad());
+
+	constexpr int tick = 16;
+	constexpr int limit = 60000;
+
+	int run = 0;
+	for (const string &profile : profiles) {
+		Config::Network conf;
+		conf.impairment = profile;
+		// one socket sees both directions, so it's enough to impair the server
+		Config::Network client_conf;
+
+		server::Server server(conf, world, wc, save);
+		server.SetPlayerModel(res.models[0]);
+		BenchClient client(client_conf, "bench" + to_string(run++));
+
+		auto enter = steady_clock::now();
+		auto next_tick = enter;
+		int elapsed = 0;
+		while (client.ChunksComplete() < full_view && !client.Closed() && elapsed < limit) {
+			next_tick += milliseconds(tick);
+			this_thread::sleep_until(next_tick);
+			server.Handle();
+			chunk_loader.Update(tick);
+			server.Update(tick);
+			server.Flush();
+			client.Update(tick);
+			elapsed = duration_cast<milliseconds>(steady_clock::now() - enter).count();
+		}
+
+		const CongestionControl &stat = client.NetStat();
+		cout << profile << ": ";
+		if (client.ChunksComplete() < full_view) {
+			cout << "gave up after " << elapsed << "ms with "
+				<< client.ChunksComplete() << " of " << full_view << " chunks";
+		} else {
+			cout << "full view after " << elapsed << "ms";
+		}
+		cout << ", " << (stat.BytesReceived() / 1024) << "KiB down, "
+			<< (stat.BytesSent() / 1024) << "KiB up per player"
+			<< ", " << (stat.PacketLoss() * 100.0f) << "% loss"
+			<< ", " << stat.RoundTripTime() << "ms RTT" << endl;
+
+		// let the server see the part so the player gets detached
+		client.Part();
+		for (int i = 0; i < 4; ++i) {
+			this_thread::sleep_for(milliseconds(tick));
+			server.Handle();
+			server.Update(tick);
+			server.Flush();
+		}
+	}
+
+	world.Chunks().UnregisterIndex(view);
+	return 0;
+}
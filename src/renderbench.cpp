@@ -0,0 +1,173 @@
+#include "app/Assets.hpp"
+#include "app/init.hpp"
+#include "geometry/Location.hpp"
+#include "graphics/EntityBatch.hpp"
+#include "graphics/Viewport.hpp"
+#include "io/filesystem.hpp"
+#include "io/WorldSave.hpp"
+#include "shared/WorldResources.hpp"
+#include "world/ChunkLoader.hpp"
+#include "world/ChunkRenderer.hpp"
+#include "world/ChunkStore.hpp"
+#include "world/Entity.hpp"
+#include "world/Generator.hpp"
+#include "world/Player.hpp"
+#include "world/World.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <GL/glew.h>
+
+using namespace blank;
+using namespace std;
+using namespace chrono;
+
+
+namespace {
+
+/// average and peak of one phase over all frames
+struct Phase {
+
+	steady_clock::duration sum = steady_clock::duration::zero();
+	steady_clock::duration peak = steady_clock::duration::zero();
+
+	void Add(steady_clock::duration d) {
+		sum += d;
+		peak = max(peak, d);
+	}
+
+	void Print(const char *name, int frames) const {
+		cout << setw(9) << name
+			<< setw(10) << (duration_cast<microseconds>(sum).count() / double(frames) / 1000.0)
+			<< setw(10) << (duration_cast<microseconds>(peak).count() / 1000.0)
+			<< endl;
+	}
+
+};
+
+}
+
+
+int main(int argc, char **argv) {
+	int frames = 600;
+	if (argc > 1) {
+		frames = max(1, atoi(argv[1]));
+	}
+
+	// no audio and no visible window, so this runs on a plain offscreen
+	// context like Xvfb with Mesa's llvmpipe
+	InitVideo init_video;
+	InitIMG init_img;
+	InitGL init_gl(false);
+	Window window(false);
+	GLContext context(window.Handle());
+	InitGLEW init_glew;
+
+	AssetLoader loader("assets/");
+	WorldResources res;
+	res.Load(loader, "default");
+	TempDir dir;
+	WorldSave save(dir.Path());
+	World::Config wc;
+	World world(res.block_types, wc);
+	Generator::Config gc;
+	gc.seed = 0x0b1a5e;
+	Generator gen(gc);
+	gen.LoadTypes(res.block_types);
+	ChunkLoader chunk_loader(world.Chunks(), gen, save);
+
+	Viewport viewport;
+	viewport.Resize(960, 600);
+	viewport.VSync(false);
+
+	Player &player = *world.AddPlayer("bench");
+	Entity &camera = player.GetEntity();
+	camera.WorldCollidable(false);
+	ChunkRenderer renderer(player.GetChunks());
+	renderer.LoadTextures(loader, res.tex_index);
+	renderer.FogDensity(wc.fog_density);
+
+	// a grid of floating entities around the path, they don't move
+	// because the world is only ever updated with a zero timestep
+	if (res.models.size() > 0) {
+		for (int z = -4; z < 4; ++z) {
+			for (int x = -4; x < 4; ++x) {
+				Entity &e = world.AddEntity();
+				e.Position(glm::vec3(x * 8.0f + 4.0f, 24.0f, z * 8.0f + 4.0f));
+				e.Bounds({{ -0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, 0.5f }});
+				res.models[(x + z + 8) % res.models.size()].Instantiate(e.GetModel());
+			}
+		}
+	}
+
+	cout << "loading chunks around the camera" << endl;
+	chunk_loader.LoadN(chunk_loader.ToLoad());
+
+	// one lap around the origin, crossing a few chunk borders
+	constexpr float radius = 40.0f;
+	constexpr float height = 32.0f;
+	constexpr float pi = 3.14159265358979323846f;
+
+	Phase cull, mesh, upload, draw, entities, total;
+	size_t meshes = 0;
+	size_t draw_calls = 0;
+	size_t uploaded_bytes = 0;
+
+	for (int frame = 0; frame < frames; ++frame) {
+		const float angle = 2.0f * pi * frame / frames;
+		ExactLocation pos(glm::vec3(radius * cos(angle), height, radius * sin(angle)));
+		pos.Sanitize();
+		camera.Position(pos.chunk, pos.block);
+		// look along the path and a little down
+		camera.SetHead(-0.3f, -angle);
+		world.Update(0);
+		// loading isn't part of rendering, so everything the path
+		// uncovers gets generated before the clock starts
+		chunk_loader.LoadN(chunk_loader.ToLoad());
+
+		renderer.ResetStats();
+		const steady_clock::time_point begin = steady_clock::now();
+		renderer.Update(16);
+		viewport.WorldPosition(camera.ViewTransform(camera.ChunkCoords()));
+		viewport.Clear();
+		renderer.Render(viewport);
+		const steady_clock::time_point entities_begin = steady_clock::now();
+		world.Render(viewport, true);
+		const steady_clock::time_point end = steady_clock::now();
+		// let the driver catch up outside the measured part, so
+		// one frame's work doesn't spill into the next
+		glFinish();
+
+		const ChunkRenderer::Stats &stats = renderer.GetStats();
+		cull.Add(stats.cull);
+		mesh.Add(stats.mesh);
+		upload.Add(stats.upload);
+		draw.Add(stats.draw);
+		entities.Add(end - entities_begin);
+		total.Add(end - begin);
+		meshes += stats.meshes;
+		draw_calls += stats.draw_calls + world.EntityDraws().DrawCalls();
+		uploaded_bytes += stats.uploaded_bytes + world.EntityDraws().UploadedBytes();
+	}
+
+	cout << frames << " frames on " << glGetString(GL_RENDERER) << endl;
+	cout << fixed << setprecision(3);
+	cout << setw(9) << "CPU ms" << setw(10) << "avg" << setw(10) << "peak" << endl;
+	cull.Print("cull", frames);
+	mesh.Print("mesh", frames);
+	upload.Print("upload", frames);
+	draw.Print("draw", frames);
+	entities.Print("entities", frames);
+	total.Print("total", frames);
+	cout << setprecision(1)
+		<< meshes << " meshes built, "
+		<< (double(draw_calls) / frames) << " draw calls and "
+		<< (double(uploaded_bytes) / frames / 1024.0) << "KiB uploaded per frame" << endl;
+
+	return 0;
+}
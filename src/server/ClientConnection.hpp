@@ -53,6 +53,9 @@ public:
 	/// send the previously prepared packet of given payload length
 	std::uint16_t Send(std::size_t len);
 
+	/// get a unique ID for a chunk transmission to this client
+	std::uint32_t NextTransmissionId() noexcept { return ++transmission_id; }
+
 	void AttachPlayer(Player &);
 	void DetachPlayer();
 	bool HasPlayer() const noexcept { return !!input; }
@@ -66,6 +69,8 @@ public:
 	const Model &GetPlayerModel() const noexcept;
 
 	bool ChunkInRange(const glm::ivec3 &) const noexcept;
+	/// number of chunks waiting to be sent to the player
+	std::size_t QueuedChunks() const noexcept { return chunk_queue.size(); }
 
 	std::uint16_t SendMessage(std::uint8_t type, std::uint32_t from, const std::string &msg);
 
@@ -106,6 +111,9 @@ private:
 	void CheckPlayerFix();
 
 	void CheckChunkQueue();
+	/// start transmitting the next chunk in queue
+	/// returns false if there is none ready
+	bool SendNextChunk(ChunkTransmitter &);
 
 private:
 	Server &server;
@@ -117,17 +125,18 @@ private:
 	unsigned int confirm_wait;
 
 	std::vector<SpawnStatus *> entity_updates;
-	unsigned int entity_updates_skipped;
 
 	EntityState player_update_state;
 	std::uint16_t player_update_pack;
 	CoarseTimer player_update_timer;
 	std::uint8_t old_actions;
 
-	ChunkTransmitter transmitter;
+	// several chunks may be in flight at once, so waiting for acks
+	// doesn't limit streaming to one chunk per round trip
+	std::list<ChunkTransmitter> transmitters;
+	std::uint32_t transmission_id;
 	std::deque<glm::ivec3> chunk_queue;
 	glm::ivec3 old_base;
-	unsigned int chunk_blocks_skipped;
 
 };
 
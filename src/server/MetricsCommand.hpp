@@ -0,0 +1,30 @@
+#ifndef BLANK_SERVER_METRICSCOMMAND_HPP_
+#define BLANK_SERVER_METRICSCOMMAND_HPP_
+
+#include "../shared/CLI.hpp"
+
+
+namespace blank {
+namespace server {
+
+class Server;
+
+/// sends the server's metrics as one message per line, ending with
+/// a "# EOF" line so a scraper knows when it's got everything
+class MetricsCommand
+: public CLI::Command {
+
+public:
+	explicit MetricsCommand(const Server &server) : server(server) { }
+
+	void Execute(CLI &, CLIContext &, TokenStreamReader &) override;
+
+private:
+	const Server &server;
+
+};
+
+}
+}
+
+#endif
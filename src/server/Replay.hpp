@@ -0,0 +1,98 @@
+#ifndef BLANK_SERVER_REPLAY_HPP_
+#define BLANK_SERVER_REPLAY_HPP_
+
+#include "../graphics/glm.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <SDL_net.h>
+
+
+namespace blank {
+namespace server {
+
+/// everything besides the packets that a replay needs to start off
+/// from the same state as the recorded server
+struct ReplayHeader {
+
+	/// generator seed of the world
+	std::uint64_t seed = 0;
+	/// seed of the world's random source
+	std::uint64_t rng_seed = 0;
+	/// chunk base where players spawn
+	glm::ivec3 spawn = { 0, 0, 0 };
+	/// length of one world step in milliseconds
+	int interval = 16;
+	/// if the world had no saved chunks when recording started, a
+	/// replay only reproduces the terrain when this is set
+	bool fresh_world = true;
+
+};
+
+/// Writes every packet a server receives, grouped by the tick that
+/// handled it, so the session can be run again without any clients.
+/// Like asset bundles, recordings are only meant to be read on the
+/// machine type that wrote them.
+class ReplayWriter {
+
+public:
+	/// bump whenever the layout changes
+	static constexpr std::uint32_t version = 3;
+
+public:
+	/// @throws std::runtime_error if the file can't be created
+	ReplayWriter(const std::string &path, const ReplayHeader &);
+
+	/// add a packet to the current tick, delay is how many
+	/// milliseconds it had been waiting when the tick handled it
+	void Record(const UDPpacket &, Uint32 delay);
+	/// close the current tick, dt is the time it accounted for and
+	/// world_dt how far it advanced the world (a multiple of the
+	/// header's interval, possibly zero)
+	void EndTick(int dt, int world_dt);
+
+private:
+	std::ofstream out;
+
+};
+
+/// Reads a recording tick by tick. A recording that ends in the middle
+/// of a tick (because the server crashed, say) ends before that tick.
+class ReplayReader {
+
+public:
+	struct Tick {
+		int dt = 0;
+		int world_dt = 0;
+		/// data stays valid until the next call to Next()
+		std::vector<UDPpacket> packets;
+		/// per packet, how many milliseconds it had been waiting
+		/// when the tick handled it
+		std::vector<Uint32> delays;
+	};
+
+public:
+	/// read the header
+	/// @throws std::runtime_error if the file can't be read or isn't
+	///         a recording of the current version
+	explicit ReplayReader(const std::string &path);
+
+	const ReplayHeader &Header() const noexcept { return header; }
+
+	/// read the next tick
+	/// @return false at the end of the recording
+	bool Next(Tick &);
+
+private:
+	std::ifstream in;
+	ReplayHeader header;
+	std::vector<Uint8> data;
+
+};
+
+}
+}
+
+#endif
@@ -2,13 +2,17 @@
 #define BLANK_SERVER_SERVER_HPP
 
 #include "../app/Config.hpp"
+#include "../net/udp.hpp"
 #include "../shared/CLI.hpp"
 #include "../world/World.hpp"
 #include "../world/WorldManipulator.hpp"
 
+#include <chrono>
 #include <cstdint>
+#include <iosfwd>
 #include <memory>
 #include <list>
+#include <vector>
 #include <SDL_net.h>
 
 
@@ -17,6 +21,7 @@ namespace blank {
 class ChunkIndex;
 class CLIContext;
 class CommandService;
+class FixedRate;
 class Model;
 class Player;
 class WorldSave;
@@ -24,6 +29,7 @@ class WorldSave;
 namespace server {
 
 class ClientConnection;
+class ReplayWriter;
 
 class Server
 : public WorldManipulator {
@@ -37,10 +43,25 @@ public:
 	// true if there's data waiting to be handled
 	bool Ready() noexcept;
 	void Handle();
+	/// handle a packet that didn't come through the socket, e.g. one
+	/// read from a recording, stamp is its time of arrival
+	void Inject(const UDPpacket &, Uint32 stamp);
+	/// write everything coming through the socket to given recorder
+	/// from now on, nullptr stops recording
+	/// has to be set before clients connect, their connections are
+	/// otherwise handled partly on the socket's I/O thread
+	void SetRecorder(ReplayWriter *r) noexcept { recorder = r; }
+	/// switch to replaying a recording, nothing gets sent and
+	/// connections stay on the main thread, so transport runs
+	/// exactly as it did while recording
+	/// has to be called before any packets are injected
+	void StartReplay() noexcept;
 
 	void Update(int dt);
+	/// send everything queued up during this tick
+	void Flush();
 
-	UDPsocket &GetSocket() noexcept { return serv_sock; }
+	udp::Socket &GetSocket() noexcept { return serv_sock; }
 	UDPpacket &GetPacket() noexcept { return serv_pack; }
 
 	World &GetWorld() noexcept { return world; }
@@ -53,6 +74,8 @@ public:
 	Player *JoinPlayer(const std::string &name);
 
 	void SetBlock(Chunk &, int, const Block &) override;
+	/// like SetBlock, but packs up to BlockUpdate::MAX_BLOCKS changes per packet
+	void SetBlocks(Chunk &, const std::vector<int> &, const std::vector<Block> &) override;
 
 	/// for use by client connections when they receive a line from the player
 	void DispatchMessage(CLIContext &, const std::string &);
@@ -60,17 +83,25 @@ public:
 	/// send message to all connected clients
 	void DistributeMessage(std::uint8_t type, std::uint32_t ref, const std::string &msg);
 
+	/// account for the time one tick took, for metrics
+	void RecordTick(std::chrono::steady_clock::duration) noexcept;
+	/// include step statistics of given rate in metrics
+	void SetFixedRate(const FixedRate &rate) noexcept { fixed_rate = &rate; }
+	/// write counters and gauges in Prometheus' text exposition format
+	void WriteMetrics(std::ostream &) const;
+
 private:
-	void HandlePacket(const UDPpacket &);
+	/// filtered tells if the socket's I/O thread already did the
+	/// connection's part of handling the packet
+	void HandlePacket(const UDPpacket &, Uint32 stamp, bool filtered = false);
 
 	ClientConnection &GetClient(const IPaddress &);
 
 	void SendAll();
 
 private:
-	UDPsocket serv_sock;
+	udp::Socket serv_sock;
 	UDPpacket serv_pack;
-	SDLNet_SocketSet serv_set;
 	std::list<ClientConnection> clients;
 
 	World &world;
@@ -80,6 +111,17 @@ private:
 
 	CLI cli;
 	std::unique_ptr<CommandService> cmd_srv;
+	ReplayWriter *recorder;
+	bool replaying;
+
+	/// upper bounds of the tick time histogram's buckets in microseconds
+	static constexpr int tick_bounds[] = { 1000, 2000, 4000, 8000, 16000, 32000, 64000, 128000 };
+	static constexpr std::size_t num_tick_buckets = sizeof(tick_bounds) / sizeof(tick_bounds[0]);
+	/// ticks that took at most the corresponding bound, not cumulative
+	std::uint64_t tick_buckets[num_tick_buckets];
+	std::uint64_t tick_count;
+	std::chrono::steady_clock::duration tick_sum;
+	const FixedRate *fixed_rate;
 
 };
 
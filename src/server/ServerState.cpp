@@ -1,10 +1,16 @@
 #include "ServerState.hpp"
 
+#include "Replay.hpp"
 #include "../app/Environment.hpp"
 #include "../io/WorldSave.hpp"
 #include "../net/io.hpp"
+#include "../net/NetClock.hpp"
+#include "../rand/GaloisLFSR.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <stdexcept>
 
 
 namespace blank {
@@ -24,7 +30,10 @@ ServerState::ServerState(
 , chunk_loader(world.Chunks(), generator, ws)
 , spawner(world, res.models)
 , server(config.net, world, wc, ws)
-, loop_timer(16) {
+// at a fixed tick, each frame's dt is exactly one interval
+, loop_timer(config.net.tick > 0 ? config.net.tick : 16)
+, recorder()
+, record_dt(0) {
 	res.Load(env.loader, "default");
 	if (res.models.size() < 2) {
 		throw std::runtime_error("need at least two models to run");
@@ -33,11 +42,28 @@ ServerState::ServerState(
 	spawner.LimitModels(1, res.models.size());
 	server.SetPlayerModel(res.models[0]);
 
+	// before loading, so only chunks from earlier runs count
+	const bool fresh_world = !ws.HasChunks();
 	std::cout << "loading spawn chunks" << std::endl;
 	chunk_loader.LoadN(chunk_loader.ToLoad());
 
 	loop_timer.Start();
 
+	if (!config.net.record.empty()) {
+		ReplayHeader header;
+		header.seed = gc.seed;
+		// the world's random source is seeded from the clock, so pick a
+		// seed that can be written down
+		header.rng_seed = world.Random().Next<std::uint64_t>();
+		world.Random() = GaloisLFSR(header.rng_seed);
+		header.spawn = wc.spawn;
+		header.interval = loop_timer.Interval();
+		header.fresh_world = fresh_world;
+		recorder.reset(new ReplayWriter(config.net.record, header));
+		server.SetRecorder(recorder.get());
+		std::cout << "recording to " << config.net.record << std::endl;
+	}
+
 	std::cout << "listening on UDP port " << config.net.port << std::endl;
 }
 
@@ -61,6 +87,7 @@ void ServerState::Handle(const SDL_Event &event) {
 
 void ServerState::Update(int dt) {
 	loop_timer.Update(dt);
+	record_dt += dt;
 	if (!loop_timer.HitOnce() && loop_timer.IntervalRemain() > 1) {
 		server.Wait(loop_timer.IntervalRemain() - 1);
 		return;
@@ -70,21 +97,81 @@ void ServerState::Update(int dt) {
 		return;
 	}
 
+	const std::chrono::steady_clock::time_point tick_begin = std::chrono::steady_clock::now();
 	server.Handle();
 	int world_dt = 0;
 	while (loop_timer.HitOnce()) {
-		spawner.Update(loop_timer.Interval());
-		world.Update(loop_timer.Interval());
 		world_dt += loop_timer.Interval();
 		loop_timer.PopIteration();
 	}
+	Tick(dt, world_dt);
+	server.RecordTick(std::chrono::steady_clock::now() - tick_begin);
+	if (recorder) {
+		recorder->EndTick(record_dt, world_dt);
+	}
+	record_dt = 0;
+	if (world_dt > 32) {
+		std::cout << "world dt at " << world_dt << "ms!" << std::endl;
+	}
+}
+
+void ServerState::Tick(int dt, int world_dt) {
+	for (int step = 0; step < world_dt; step += loop_timer.Interval()) {
+		spawner.Update(loop_timer.Interval());
+		world.Update(loop_timer.Interval());
+	}
 	chunk_loader.Update(dt);
 	if (world_dt > 0) {
 		server.Update(world_dt);
 	}
-	if (world_dt > 32) {
-		std::cout << "world dt at " << world_dt << "ms!" << std::endl;
+	server.Flush();
+}
+
+
+void ServerState::SetFixedRate(const FixedRate &rate) noexcept {
+	server.SetFixedRate(rate);
+}
+
+void ServerState::Replay(ReplayReader &replay) {
+	if (replay.Header().interval != loop_timer.Interval()) {
+		throw std::runtime_error("recording was made with a different world step");
+	}
+	server.StartReplay();
+	world.Random() = GaloisLFSR(replay.Header().rng_seed);
+	// connection timing follows the recorded session's time rather than
+	// how fast the replay gets through it
+	Uint32 session_time = SDL_GetTicks();
+	NetClock::Pin(session_time);
+
+	ReplayReader::Tick tick;
+	std::size_t ticks = 0;
+	std::size_t packets = 0;
+	long long recorded = 0;
+	std::chrono::steady_clock::duration slowest = std::chrono::steady_clock::duration::zero();
+	const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	while (replay.Next(tick)) {
+		const std::chrono::steady_clock::time_point tick_begin = std::chrono::steady_clock::now();
+		session_time += tick.dt;
+		NetClock::Pin(session_time);
+		for (std::size_t i = 0; i < tick.packets.size(); ++i) {
+			server.Inject(tick.packets[i], session_time - tick.delays[i]);
+		}
+		Tick(tick.dt, tick.world_dt);
+		const std::chrono::steady_clock::duration tick_time = std::chrono::steady_clock::now() - tick_begin;
+		server.RecordTick(tick_time);
+		slowest = std::max(slowest, tick_time);
+		++ticks;
+		packets += tick.packets.size();
+		recorded += tick.dt;
 	}
+	const std::chrono::steady_clock::duration total = std::chrono::steady_clock::now() - begin;
+	NetClock::Release();
+
+	using ms = std::chrono::duration<double, std::milli>;
+	std::cout << "replayed " << ticks << " ticks with " << packets << " packets ("
+		<< (recorded / 1000.0) << "s recorded) in " << ms(total).count() << "ms, "
+		<< (ticks ? ms(total).count() / ticks : 0.0) << "ms mean tick, "
+		<< ms(slowest).count() << "ms slowest" << std::endl;
 }
 
 
@@ -10,15 +10,21 @@
 #include "../world/Generator.hpp"
 #include "../world/World.hpp"
 
+#include <memory>
+
 
 namespace blank {
 
 class Config;
+class FixedRate;
 class HeadlessEnvironment;
 class WorldSave;
 
 namespace server {
 
+class ReplayReader;
+class ReplayWriter;
+
 class ServerState
 : public State {
 
@@ -36,6 +42,18 @@ public:
 	void Update(int dt) override;
 	void Render(Viewport &) override;
 
+	/// report step statistics of the rate the state is run at
+	void SetFixedRate(const FixedRate &) noexcept;
+
+	/// run all ticks of given recording back to back, with the server
+	/// cut off from the network
+	/// the world has to be set up from the recording's header
+	void Replay(ReplayReader &);
+
+private:
+	/// everything a tick does after handling input
+	void Tick(int dt, int world_dt);
+
 private:
 	HeadlessEnvironment &env;
 	WorldResources res;
@@ -46,6 +64,10 @@ private:
 	Server server;
 	CoarseTimer loop_timer;
 
+	std::unique_ptr<ReplayWriter> recorder;
+	/// time passed since the last recorded tick
+	int record_dt;
+
 };
 
 }
@@ -1,18 +1,28 @@
 #include "ClientConnection.hpp"
 #include "ChunkTransmitter.hpp"
+#include "MetricsCommand.hpp"
+#include "Replay.hpp"
 #include "Server.hpp"
 
 #include "../app/error.hpp"
+#include "../app/FixedRate.hpp"
+#include "../app/Profiler.hpp"
 #include "../geometry/distance.hpp"
 #include "../io/WorldSave.hpp"
 #include "../model/Model.hpp"
+#include "../net/NetClock.hpp"
+#include "../shared/CLIContext.hpp"
 #include "../shared/CommandService.hpp"
+#include "../shared/commands.hpp"
 #include "../world/ChunkIndex.hpp"
+#include "../world/ChunkStore.hpp"
 #include "../world/Entity.hpp"
+#include "../world/Player.hpp"
 #include "../world/World.hpp"
 
 #include <algorithm>
 #include <iostream>
+#include <sstream>
 #include <zlib.h>
 #include <glm/gtx/io.hpp>
 
@@ -132,7 +142,7 @@ void ChunkTransmitter::Send(Chunk &chunk) {
 	num_packets = (buffer_len / packet_len) + (buffer_len % packet_len != 0);
 	data_packets.resize(num_packets, -1);
 
-	++trans_id;
+	trans_id = conn.NextTransmissionId();
 	SendBegin();
 }
 
@@ -182,32 +192,38 @@ ClientConnection::ClientConnection(Server &server, const IPaddress &addr)
 , spawns()
 , confirm_wait(0)
 , entity_updates()
-, entity_updates_skipped(0)
 , player_update_state()
 , player_update_pack(0)
 , player_update_timer(1500)
 , old_actions(0)
-, transmitter(*this)
+, transmitters()
+, transmission_id(0)
 , chunk_queue()
-, old_base()
-, chunk_blocks_skipped(0) {
+, old_base() {
 	conn.SetHandler(this);
+	constexpr int max_transmissions = 8;
+	for (int i = 0; i < max_transmissions; ++i) {
+		transmitters.emplace_back(*this);
+	}
 }
 
 ClientConnection::~ClientConnection() {
+	server.GetSocket().Detach(conn);
 	DetachPlayer();
 }
 
 void ClientConnection::Update(int dt) {
+	Profiler::Zone zone("ClientConnection::Update");
 	conn.Update(dt);
 	if (Disconnected()) {
 		return;
 	}
 	if (HasPlayer()) {
+		// in order of priority, chunks get whatever budget is left
 		CheckPlayerFix();
-		CheckChunkQueue();
 		CheckEntities();
 		SendUpdates();
+		CheckChunkQueue();
 	}
 	if (conn.ShouldPing()) {
 		conn.SendPing(server.GetPacket(), server.GetSocket());
@@ -315,7 +331,7 @@ void ClientConnection::SendDespawn(SpawnStatus &status) {
 }
 
 bool ClientConnection::SendingUpdates() const noexcept {
-	return entity_updates_skipped >= NetStat().SuggestedPacketHold();
+	return NetStat().Budget(CongestionControl::UPDATE) > 0;
 }
 
 void ClientConnection::QueueUpdate(SpawnStatus &status) {
@@ -328,7 +344,6 @@ void ClientConnection::QueueUpdate(SpawnStatus &status) {
 void ClientConnection::SendUpdates() {
 	if (!SendingUpdates()) {
 		entity_updates.clear();
-		++entity_updates_skipped;
 		return;
 	}
 	auto base = PlayerChunks().Base();
@@ -350,7 +365,6 @@ void ClientConnection::SendUpdates() {
 		Send(Packet::EntityUpdate::GetSize(entity_pos));
 	}
 	entity_updates.clear();
-	entity_updates_skipped = 0;
 }
 
 void ClientConnection::CheckPlayerFix() {
@@ -404,35 +418,50 @@ void ClientConnection::CheckChunkQueue() {
 		sort(chunk_queue.begin(), chunk_queue.end(), QueueCompare(old_base));
 		chunk_queue.erase(unique(chunk_queue.begin(), chunk_queue.end()), chunk_queue.end());
 	}
-	// don't push entity updates and chunk data in the same tick
-	if (chunk_blocks_skipped >= NetStat().SuggestedPacketHold() && !SendingUpdates()) {
-		++chunk_blocks_skipped;
-		return;
-	}
-	if (transmitter.Transmitting()) {
-		transmitter.Transmit();
-		chunk_blocks_skipped = 0;
-		return;
+	// send chunk data for as long as the budget allows, finishing
+	// started transmissions before beginning new ones
+	while (NetStat().Budget(CongestionControl::BULK) > 0) {
+		ChunkTransmitter *next = nullptr;
+		for (ChunkTransmitter &trans : transmitters) {
+			if (trans.Transmitting()) {
+				next = &trans;
+				break;
+			}
+		}
+		if (next) {
+			next->Transmit();
+			continue;
+		}
+		for (ChunkTransmitter &trans : transmitters) {
+			if (trans.Idle()) {
+				next = &trans;
+				break;
+			}
+		}
+		if (!next || !SendNextChunk(*next)) {
+			break;
+		}
 	}
-	if (transmitter.Idle()) {
-		int count = 0;
-		constexpr int max = 64;
-		while (count < max && !chunk_queue.empty()) {
-			ExactLocation::Coarse pos = chunk_queue.front();
-			chunk_queue.pop_front();
-			if (PlayerChunks().InRange(pos)) {
-				Chunk *chunk = PlayerChunks().Get(pos);
-				if (chunk) {
-					transmitter.Send(*chunk);
-					chunk_blocks_skipped = 0;
-					return;
-				} else {
-					chunk_queue.push_back(pos);
-				}
-				++count;
+}
+
+bool ClientConnection::SendNextChunk(ChunkTransmitter &transmitter) {
+	int count = 0;
+	constexpr int max = 64;
+	while (count < max && !chunk_queue.empty()) {
+		ExactLocation::Coarse pos = chunk_queue.front();
+		chunk_queue.pop_front();
+		if (PlayerChunks().InRange(pos)) {
+			Chunk *chunk = PlayerChunks().Get(pos);
+			if (chunk) {
+				transmitter.Send(*chunk);
+				return true;
+			} else {
+				chunk_queue.push_back(pos);
 			}
+			++count;
 		}
 	}
+	return false;
 }
 
 void ClientConnection::AttachPlayer(Player &player) {
@@ -474,7 +503,9 @@ void ClientConnection::DetachPlayer() {
 	PlayerEntity().UnRef();
 	cli_ctx.reset();
 	input.reset();
-	transmitter.Abort();
+	for (ChunkTransmitter &transmitter : transmitters) {
+		transmitter.Abort();
+	}
 	chunk_queue.clear();
 	old_actions = 0;
 }
@@ -495,8 +526,10 @@ const Model &ClientConnection::GetPlayerModel() const noexcept {
 }
 
 void ClientConnection::OnPacketReceived(uint16_t seq) {
-	if (transmitter.Waiting()) {
-		transmitter.Ack(seq);
+	for (ChunkTransmitter &transmitter : transmitters) {
+		if (transmitter.Waiting()) {
+			transmitter.Ack(seq);
+		}
 	}
 	if (!confirm_wait) return;
 	for (auto iter = spawns.begin(), end = spawns.end(); iter != end; ++iter) {
@@ -514,8 +547,10 @@ void ClientConnection::OnPacketReceived(uint16_t seq) {
 }
 
 void ClientConnection::OnPacketLost(uint16_t seq) {
-	if (transmitter.Waiting()) {
-		transmitter.Nack(seq);
+	for (ChunkTransmitter &transmitter : transmitters) {
+		if (transmitter.Waiting()) {
+			transmitter.Nack(seq);
+		}
 	}
 	if (!confirm_wait) return;
 	for (SpawnStatus &status : spawns) {
@@ -675,38 +710,32 @@ Server::Server(
 	World &world,
 	const World::Config &wc,
 	const WorldSave &save)
-: serv_sock(nullptr)
+: serv_sock(conf.port)
 , serv_pack{ -1, nullptr, 0 }
-, serv_set(SDLNet_AllocSocketSet(1))
 , clients()
 , world(world)
 , spawn_index(world.Chunks().MakeIndex(wc.spawn, 3))
 , save(save)
 , player_model(nullptr)
 , cli(world)
-, cmd_srv() {
+, cmd_srv()
+, recorder(nullptr)
+, replaying(false)
+, tick_buckets()
+, tick_count(0)
+, tick_sum(chrono::steady_clock::duration::zero())
+, fixed_rate(nullptr) {
 #pragma GCC diagnostic pop
-	if (!serv_set) {
-		throw NetError("SDLNet_AllocSocketSet");
-	}
-
-	serv_sock = SDLNet_UDP_Open(conf.port);
-	if (!serv_sock) {
-		SDLNet_FreeSocketSet(serv_set);
-		throw NetError("SDLNet_UDP_Open");
-	}
-
-	if (SDLNet_UDP_AddSocket(serv_set, serv_sock) == -1) {
-		SDLNet_UDP_Close(serv_sock);
-		SDLNet_FreeSocketSet(serv_set);
-		throw NetError("SDLNet_UDP_AddSocket");
-	}
-
 	serv_pack.data = new Uint8[sizeof(Packet)];
 	serv_pack.maxlen = sizeof(Packet);
 
+	serv_sock.Impair(udp::Impairment::Parse(conf.impairment));
+	serv_sock.StartThread();
+
+	cli.AddCommand("metrics", new MetricsCommand(*this));
+	cli.AddCommand("fill", new FillCommand(*this));
 	if (conf.cmd_port) {
-		cmd_srv.reset(new CommandService(cli, conf.cmd_port));
+		cmd_srv.reset(new CommandService(cli, conf.cmd_port, conf.cmd_budget));
 	}
 }
 
@@ -717,42 +746,52 @@ Server::~Server() {
 	clients.clear();
 	world.Chunks().UnregisterIndex(spawn_index);
 	delete[] serv_pack.data;
-	SDLNet_UDP_DelSocket(serv_set, serv_sock);
-	SDLNet_UDP_Close(serv_sock);
-	SDLNet_FreeSocketSet(serv_set);
 }
 
 
 void Server::Wait(int dt) noexcept {
-	SDLNet_CheckSockets(serv_set, dt);
+	serv_sock.Wait(dt);
 	if (cmd_srv) {
 		cmd_srv->Wait(0);
 	}
 }
 
 bool Server::Ready() noexcept {
-	if (SDLNet_CheckSockets(serv_set, 0) > 0) {
+	if (serv_sock.Wait(0)) {
 		return true;
 	}
 	return cmd_srv && cmd_srv->Ready();
 }
 
 void Server::Handle() {
-	int result = SDLNet_UDP_Recv(serv_sock, &serv_pack);
-	while (result > 0) {
-		HandlePacket(serv_pack);
-		result = SDLNet_UDP_Recv(serv_sock, &serv_pack);
-	}
-	if (result == -1) {
-		// a boo boo happened
-		throw NetError("SDLNet_UDP_Recv");
+	Profiler::Zone zone("Server::Handle");
+	const Uint32 now = NetClock::Now();
+	for (size_t count = serv_sock.Receive(); count > 0; count = serv_sock.Receive()) {
+		for (size_t i = 0; i < count; ++i) {
+			if (recorder) {
+				// arrival relative to handling, so a replay can put it
+				// on its own timeline
+				const Uint32 stamp = serv_sock.ReceivedAt(i);
+				recorder->Record(serv_sock.Received(i), now > stamp ? now - stamp : 0);
+			}
+			HandlePacket(serv_sock.Received(i), serv_sock.ReceivedAt(i), serv_sock.Filtered(i));
+		}
 	}
 	if (cmd_srv) {
 		cmd_srv->Handle();
 	}
 }
 
-void Server::HandlePacket(const UDPpacket &udp_pack) {
+void Server::StartReplay() noexcept {
+	serv_sock.Discard();
+	replaying = true;
+}
+
+void Server::Inject(const UDPpacket &pack, Uint32 stamp) {
+	HandlePacket(pack, stamp);
+}
+
+void Server::HandlePacket(const UDPpacket &udp_pack, Uint32 stamp, bool filtered) {
 	if (udp_pack.len < int(sizeof(Packet::Header))) {
 		// packet too small, drop
 		return;
@@ -764,7 +803,11 @@ void Server::HandlePacket(const UDPpacket &udp_pack) {
 	}
 
 	ClientConnection &client = GetClient(udp_pack.address);
-	client.GetConnection().Received(udp_pack);
+	if (filtered) {
+		client.GetConnection().Deliver(udp_pack);
+	} else {
+		client.GetConnection().Received(udp_pack, stamp);
+	}
 }
 
 ClientConnection &Server::GetClient(const IPaddress &addr) {
@@ -774,6 +817,12 @@ ClientConnection &Server::GetClient(const IPaddress &addr) {
 		}
 	}
 	clients.emplace_back(*this, addr);
+	if (!recorder && !replaying) {
+		// a recording has to see every packet, so it can't have the
+		// I/O thread keep pings to itself, and a replay must not have
+		// it send keepalives on the wall clock
+		serv_sock.Attach(clients.back().GetConnection());
+	}
 	if (HasPlayerModel()) {
 		clients.back().SetPlayerModel(GetPlayerModel());
 	}
@@ -794,6 +843,10 @@ void Server::Update(int dt) {
 	}
 }
 
+void Server::Flush() {
+	serv_sock.Flush();
+}
+
 void Server::SetPlayerModel(const Model &m) noexcept {
 	player_model = &m;
 	for (ClientConnection &client : clients) {
@@ -841,6 +894,28 @@ void Server::SetBlock(Chunk &chunk, int index, const Block &block) {
 	}
 }
 
+void Server::SetBlocks(Chunk &chunk, const vector<int> &indices, const vector<Block> &blocks) {
+	for (size_t i = 0; i < indices.size(); ++i) {
+		chunk.SetBlock(indices[i], blocks[i]);
+	}
+	for (size_t begin = 0; begin < indices.size(); begin += Packet::BlockUpdate::MAX_BLOCKS) {
+		const uint32_t count = min(indices.size() - begin, size_t(Packet::BlockUpdate::MAX_BLOCKS));
+		auto pack = Packet::Make<Packet::BlockUpdate>(GetPacket());
+		pack.WriteChunkCoords(chunk.Position());
+		pack.WriteBlockCount(count);
+		for (uint32_t i = 0; i < count; ++i) {
+			pack.WriteIndex(indices[begin + i], i);
+			pack.WriteBlock(chunk.BlockAt(indices[begin + i]), i);
+		}
+		GetPacket().len = sizeof(Packet::Header) + Packet::BlockUpdate::GetSize(count);
+		for (ClientConnection &client : clients) {
+			if (client.ChunkInRange(chunk.Position())) {
+				client.Send();
+			}
+		}
+	}
+}
+
 void Server::DispatchMessage(CLIContext &ctx, const string &msg) {
 	if (msg.empty()) {
 		return;
@@ -852,6 +927,142 @@ void Server::DispatchMessage(CLIContext &ctx, const string &msg) {
 	}
 }
 
+constexpr int Server::tick_bounds[];
+constexpr size_t Server::num_tick_buckets;
+
+void Server::RecordTick(chrono::steady_clock::duration d) noexcept {
+	const auto us = chrono::duration_cast<chrono::microseconds>(d).count();
+	for (size_t i = 0; i < num_tick_buckets; ++i) {
+		if (us <= tick_bounds[i]) {
+			++tick_buckets[i];
+			break;
+		}
+	}
+	++tick_count;
+	tick_sum += d;
+}
+
+namespace {
+
+/// quote given string as a Prometheus label value
+string Label(const string &value) {
+	string quoted("\"");
+	for (char c : value) {
+		switch (c) {
+			case '\\':
+				quoted += "\\\\";
+				break;
+			case '"':
+				quoted += "\\\"";
+				break;
+			case '\n':
+				quoted += "\\n";
+				break;
+			default:
+				quoted += c;
+				break;
+		}
+	}
+	quoted += '"';
+	return quoted;
+}
+
+void Describe(ostream &out, const char *name, const char *type, const char *help) {
+	out << "# HELP " << name << ' ' << help << '\n';
+	out << "# TYPE " << name << ' ' << type << '\n';
+}
+
+}
+
+void Server::WriteMetrics(ostream &out) const {
+	Describe(out, "blank_tick_seconds", "histogram", "time spent handling, updating, and flushing per server tick");
+	uint64_t cumulative = 0;
+	for (size_t i = 0; i < num_tick_buckets; ++i) {
+		cumulative += tick_buckets[i];
+		out << "blank_tick_seconds_bucket{le=\"" << (tick_bounds[i] * 1.0e-6) << "\"} " << cumulative << '\n';
+	}
+	out << "blank_tick_seconds_bucket{le=\"+Inf\"} " << tick_count << '\n';
+	out << "blank_tick_seconds_sum " << chrono::duration<double>(tick_sum).count() << '\n';
+	out << "blank_tick_seconds_count " << tick_count << '\n';
+	if (fixed_rate) {
+		Describe(out, "blank_tick_steps_total", "counter", "fixed rate steps run");
+		out << "blank_tick_steps_total " << fixed_rate->Steps() << '\n';
+		Describe(out, "blank_tick_overruns_total", "counter", "times a fixed rate step was started late");
+		out << "blank_tick_overruns_total " << fixed_rate->Overruns() << '\n';
+		Describe(out, "blank_tick_dropped_total", "counter", "fixed rate steps skipped to catch up");
+		out << "blank_tick_dropped_total " << fixed_rate->Dropped() << '\n';
+		Describe(out, "blank_tick_lateness_max_seconds", "gauge", "worst delay of a fixed rate step");
+		out << "blank_tick_lateness_max_seconds " << (fixed_rate->MaxLateness() * 1.0e-9) << '\n';
+	}
+
+	const ChunkStore &chunks = world.Chunks();
+	Describe(out, "blank_chunks_loaded", "gauge", "chunks held in memory");
+	out << "blank_chunks_loaded " << chunks.NumLoaded() << '\n';
+	Describe(out, "blank_chunks_free", "gauge", "chunk objects kept for reuse");
+	out << "blank_chunks_free " << chunks.NumFree() << '\n';
+	Describe(out, "blank_chunks_missing", "gauge", "chunks waiting to be loaded or generated");
+	out << "blank_chunks_missing " << chunks.EstimateMissing() << '\n';
+	Describe(out, "blank_chunks_unsaved", "gauge", "loaded chunks with changes not yet written to disk");
+	out << "blank_chunks_unsaved " << chunks.NumUnsaved() << '\n';
+
+	Describe(out, "blank_entities", "gauge", "entities in the world, including players");
+	out << "blank_entities " << world.Entities().size() << '\n';
+	Describe(out, "blank_players", "gauge", "players in the world");
+	out << "blank_players " << world.Players().size() << '\n';
+	Describe(out, "blank_clients", "gauge", "connected clients, with or without a player");
+	out << "blank_clients " << clients.size() << '\n';
+
+	// per client numbers are labelled by player name, so clients that
+	// haven't joined yet are left out
+	Describe(out, "blank_client_chunk_queue", "gauge", "chunks waiting to be sent to the client");
+	for (const ClientConnection &client : clients) {
+		if (client.HasPlayer()) {
+			out << "blank_client_chunk_queue{player=" << Label(client.PlayerEntity().Name()) << "} "
+				<< client.QueuedChunks() << '\n';
+		}
+	}
+	Describe(out, "blank_client_rtt_seconds", "gauge", "smoothed round trip time");
+	for (const ClientConnection &client : clients) {
+		if (client.HasPlayer()) {
+			out << "blank_client_rtt_seconds{player=" << Label(client.PlayerEntity().Name()) << "} "
+				<< (client.NetStat().RoundTripTime() * 1.0e-3) << '\n';
+		}
+	}
+	Describe(out, "blank_client_packet_loss_ratio", "gauge", "fraction of recent packets lost");
+	for (const ClientConnection &client : clients) {
+		if (client.HasPlayer()) {
+			out << "blank_client_packet_loss_ratio{player=" << Label(client.PlayerEntity().Name()) << "} "
+				<< client.NetStat().PacketLoss() << '\n';
+		}
+	}
+	Describe(out, "blank_client_tx_kbps", "gauge", "recent send rate towards the client");
+	for (const ClientConnection &client : clients) {
+		if (client.HasPlayer()) {
+			out << "blank_client_tx_kbps{player=" << Label(client.PlayerEntity().Name()) << "} "
+				<< client.NetStat().Upstream() << '\n';
+		}
+	}
+	Describe(out, "blank_client_rx_kbps", "gauge", "recent receive rate from the client");
+	for (const ClientConnection &client : clients) {
+		if (client.HasPlayer()) {
+			out << "blank_client_rx_kbps{player=" << Label(client.PlayerEntity().Name()) << "} "
+				<< client.NetStat().Downstream() << '\n';
+		}
+	}
+}
+
+
+void MetricsCommand::Execute(CLI &, CLIContext &ctx, TokenStreamReader &) {
+	stringstream out;
+	server.WriteMetrics(out);
+	string line;
+	while (getline(out, line)) {
+		ctx.Message(line);
+	}
+	ctx.Message("# EOF");
+}
+
+
 void Server::DistributeMessage(uint8_t type, uint32_t ref, const string &msg) {
 	auto pack = Packet::Make<Packet::Message>(serv_pack);
 	pack.WriteType(type);
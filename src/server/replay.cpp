@@ -0,0 +1,154 @@
+#include "Replay.hpp"
+
+#include "../net/Packet.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+
+namespace blank {
+namespace server {
+
+namespace {
+
+const char magic[8] = { 'B', 'L', 'N', 'K', 'R', 'P', 'L', 'Y' };
+constexpr uint32_t byte_order = 0x01020304;
+
+constexpr char packet_tag = 'P';
+constexpr char tick_tag = 'T';
+
+template<class T>
+void Put(ostream &out, T value) {
+	out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template<class T>
+bool Get(istream &in, T &value) {
+	return bool(in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+}
+
+constexpr uint32_t ReplayWriter::version;
+
+ReplayWriter::ReplayWriter(const string &path, const ReplayHeader &header)
+: out(path, ios::binary | ios::trunc) {
+	if (!out) {
+		throw runtime_error("unable to write recording " + path);
+	}
+	out.write(magic, sizeof(magic));
+	Put<uint32_t>(out, byte_order);
+	Put<uint32_t>(out, version);
+	Put<uint64_t>(out, header.seed);
+	Put<uint64_t>(out, header.rng_seed);
+	Put<int32_t>(out, header.spawn.x);
+	Put<int32_t>(out, header.spawn.y);
+	Put<int32_t>(out, header.spawn.z);
+	Put<int32_t>(out, header.interval);
+	Put<uint8_t>(out, header.fresh_world);
+}
+
+void ReplayWriter::Record(const UDPpacket &pack, Uint32 delay) {
+	const uint16_t len = min(size_t(max(pack.len, 0)), sizeof(Packet));
+	out.put(packet_tag);
+	Put<uint32_t>(out, pack.address.host);
+	Put<uint16_t>(out, pack.address.port);
+	Put<uint32_t>(out, delay);
+	Put<uint16_t>(out, len);
+	out.write(reinterpret_cast<const char *>(pack.data), len);
+}
+
+void ReplayWriter::EndTick(int dt, int world_dt) {
+	out.put(tick_tag);
+	Put<int32_t>(out, dt);
+	Put<int32_t>(out, world_dt);
+}
+
+
+ReplayReader::ReplayReader(const string &path)
+: in(path, ios::binary)
+, header()
+, data() {
+	if (!in) {
+		throw runtime_error("unable to open recording " + path);
+	}
+	char file_magic[sizeof(magic)];
+	if (!in.read(file_magic, sizeof(file_magic)) || memcmp(file_magic, magic, sizeof(magic)) != 0) {
+		throw runtime_error("not a recording: " + path);
+	}
+	uint32_t file_order = 0;
+	uint32_t file_version = 0;
+	if (!Get(in, file_order) || file_order != byte_order) {
+		throw runtime_error("recording has wrong byte order");
+	}
+	if (!Get(in, file_version) || file_version != ReplayWriter::version) {
+		throw runtime_error("recording has wrong version");
+	}
+	int32_t spawn[3];
+	int32_t interval;
+	uint8_t fresh_world;
+	if (
+		!Get(in, header.seed) || !Get(in, header.rng_seed) ||
+		!Get(in, spawn[0]) || !Get(in, spawn[1]) || !Get(in, spawn[2]) ||
+		!Get(in, interval) || !Get(in, fresh_world)
+	) {
+		throw runtime_error("recording truncated");
+	}
+	header.spawn = glm::ivec3(spawn[0], spawn[1], spawn[2]);
+	header.interval = interval;
+	header.fresh_world = fresh_world != 0;
+}
+
+bool ReplayReader::Next(Tick &tick) {
+	tick.packets.clear();
+	tick.delays.clear();
+	data.clear();
+	vector<size_t> offsets;
+	char tag;
+	while (in.get(tag)) {
+		if (tag == tick_tag) {
+			int32_t dt, world_dt;
+			if (!Get(in, dt) || !Get(in, world_dt)) {
+				return false;
+			}
+			tick.dt = dt;
+			tick.world_dt = world_dt;
+			// data is done growing, so pointers into it stay valid now
+			for (size_t i = 0; i < tick.packets.size(); ++i) {
+				tick.packets[i].data = data.data() + offsets[i];
+			}
+			return true;
+		}
+		if (tag != packet_tag) {
+			throw runtime_error("recording corrupted");
+		}
+		UDPpacket pack;
+		uint32_t delay;
+		uint16_t len;
+		pack.channel = -1;
+		if (!Get(in, pack.address.host) || !Get(in, pack.address.port) || !Get(in, delay) || !Get(in, len)) {
+			return false;
+		}
+		if (len > sizeof(Packet)) {
+			throw runtime_error("recording corrupted");
+		}
+		offsets.push_back(data.size());
+		data.resize(data.size() + len);
+		if (len > 0 && !in.read(reinterpret_cast<char *>(&data[offsets.back()]), len)) {
+			return false;
+		}
+		pack.data = nullptr;
+		pack.len = len;
+		pack.maxlen = len;
+		pack.status = len;
+		tick.packets.push_back(pack);
+		tick.delays.push_back(delay);
+	}
+	return false;
+}
+
+}
+}
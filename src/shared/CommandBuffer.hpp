@@ -4,13 +4,23 @@
 #include "CLIContext.hpp"
 #include "../net/tcp.hpp"
 
+#include <chrono>
+#include <deque>
 #include <string>
 
 
 namespace blank {
 
+class CommandService;
+
 /// Turns a tcp stream into commands and writes their
 /// output back to the stream.
+/// Lines between a "batch" and an "end" line are held back
+/// until the end arrives and then run by the service within
+/// its per tick budget. Errors in a batch are prefixed with
+/// the offending line's number, and a summary follows the
+/// batch. Lines arriving while a batch is still pending are
+/// queued behind it, so everything runs in order.
 /// Instances delete themselves when OnRemove(tcp::Socket &)
 /// is called, so make sure it was either allocated with new
 /// and isn't dereferenced after removal or OnRemove is never
@@ -20,7 +30,7 @@ class CommandBuffer
 , public tcp::IOHandler {
 
 public:
-	explicit CommandBuffer(CLI &);
+	CommandBuffer(CommandService &, CLI &);
 	~CommandBuffer() override;
 
 	// CLIContext implementation
@@ -33,12 +43,36 @@ public:
 	void OnRecv(tcp::Socket &) override;
 	void OnRemove(tcp::Socket &) noexcept override;
 
+	/// run queued lines until the deadline, at least one though
+	/// @return true if nothing's left that could run right now
+	bool RunPending(std::chrono::steady_clock::time_point deadline);
+
+private:
+	void Receive(const std::string &line);
+	/// true if the front of the queue can be run
+	bool Runnable() const noexcept;
+
 private:
+	CommandService &service;
 	CLI &cli;
 	std::string write_buffer;
 	std::string read_buffer;
 	std::size_t head;
 
+	std::deque<std::string> pending;
+	/// a batch was started, but its end hasn't been received yet
+	bool collecting;
+	/// number of batches in pending that have been received in full
+	int complete;
+
+	bool in_batch;
+	/// running one of the batch's lines right now
+	bool executing;
+	std::size_t batch_line;
+	std::size_t batch_errors;
+	int batch_ticks;
+	std::chrono::steady_clock::time_point batch_begin;
+
 };
 
 }
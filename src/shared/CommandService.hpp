@@ -3,16 +3,21 @@
 
 #include "../net/tcp.hpp"
 
+#include <chrono>
+#include <set>
+
 
 namespace blank {
 
 class CLI;
+class CommandBuffer;
 
 class CommandService
 : public tcp::IOHandler {
 
 public:
-	CommandService(CLI &, unsigned short port);
+	/// run batches for at most budget milliseconds per call to Handle()
+	CommandService(CLI &, unsigned short port, int budget);
 	~CommandService();
 
 public:
@@ -20,15 +25,27 @@ public:
 	void Wait(int timeout) noexcept;
 	/// true if at least one connected socket can read
 	bool Ready() noexcept;
-	/// handle all inbound traffic
+	/// handle all inbound traffic and continue pending batches
 	void Handle();
 	/// send all outbound traffic
 	void Send();
 
 	void OnRecv(tcp::Socket &) override;
 
+	/// have given buffer's batch run within the budget from now on
+	void Schedule(CommandBuffer &);
+	/// stop running given buffer's batches, e.g. when it goes away
+	void Unschedule(CommandBuffer &) noexcept;
+
+private:
+	void RunBatches();
+
 private:
 	CLI &cli;
+	std::chrono::steady_clock::duration budget;
+	// buffers remove themselves from this when the pool removes them,
+	// so it has to outlive the pool
+	std::set<CommandBuffer *> batches;
 	tcp::Pool pool;
 
 };
@@ -2,13 +2,21 @@
 #include "CLIContext.hpp"
 #include "commands.hpp"
 
+#include "../app/Profiler.hpp"
 #include "../io/TokenStreamReader.hpp"
+#include "../geometry/Location.hpp"
+#include "../world/BlockTypeRegistry.hpp"
+#include "../world/Chunk.hpp"
+#include "../world/ChunkStore.hpp"
 #include "../world/Entity.hpp"
 #include "../world/Player.hpp"
 #include "../world/World.hpp"
+#include "../world/WorldManipulator.hpp"
 
+#include <cstdint>
 #include <iostream>
 #include <sstream>
+#include <vector>
 #include <glm/gtx/io.hpp>
 
 using namespace std;
@@ -21,6 +29,7 @@ CLI::CLI(World &world)
 , commands() {
 	AddCommand("as", new ImpersonateCommand);
 	AddCommand("tp", new TeleportCommand);
+	AddCommand("trace", new TraceCommand);
 }
 
 CLI::~CLI() {
@@ -34,8 +43,7 @@ void CLI::AddCommand(const string &name, Command *cmd) {
 }
 
 void CLI::Execute(CLIContext &ctx, const string &line) {
-	stringstream s(line);
-	TokenStreamReader args(s);
+	TokenStreamReader args(line.data(), line.data() + line.size());
 	if (!args.HasMore()) {
 		// ignore empty command line
 		return;
@@ -82,6 +90,80 @@ std::string CLIContext::Name() const {
 }
 
 
+constexpr int FillCommand::max_volume;
+
+void FillCommand::Execute(CLI &cli, CLIContext &ctx, TokenStreamReader &args) {
+	const glm::ivec3 a(args.GetInt(), args.GetInt(), args.GetInt());
+	const glm::ivec3 b(args.GetInt(), args.GetInt(), args.GetInt());
+	const BlockTypeRegistry &types = cli.GetWorld().BlockTypes();
+	Block block;
+	if (args.Peek().type == Token::NUMBER) {
+		const int id = args.GetInt();
+		if (id < 0 || size_t(id) >= types.size()) {
+			ctx.Error("no block type with id " + to_string(id));
+			return;
+		}
+		block.type = id;
+	} else {
+		block.type = types.Get(args.GetString()).id;
+	}
+
+	const glm::ivec3 extent(glm::abs(b - a) + 1);
+	if (int64_t(extent.x) * extent.y * extent.z > max_volume) {
+		ctx.Error("box too large, at most " + to_string(max_volume) + " blocks per fill");
+		return;
+	}
+	RoughLocation lo(RoughLocation::Fine(glm::min(a, b)));
+	lo.Sanitize();
+	RoughLocation hi(RoughLocation::Fine(glm::max(a, b)));
+	hi.Sanitize();
+
+	ChunkStore &store = cli.GetWorld().Chunks();
+	vector<int> indices;
+	vector<Block> blocks;
+	size_t filled = 0;
+	size_t skipped = 0;
+	ExactLocation::Coarse pos;
+	for (pos.z = lo.chunk.z; pos.z <= hi.chunk.z; ++pos.z) {
+		for (pos.y = lo.chunk.y; pos.y <= hi.chunk.y; ++pos.y) {
+			for (pos.x = lo.chunk.x; pos.x <= hi.chunk.x; ++pos.x) {
+				Chunk *chunk = store.Get(pos);
+				if (!chunk) {
+					++skipped;
+					continue;
+				}
+				// the part of the box inside this chunk
+				RoughLocation::Fine begin(0);
+				RoughLocation::Fine end(Chunk::side - 1);
+				for (int i = 0; i < 3; ++i) {
+					if (pos[i] == lo.chunk[i]) begin[i] = lo.block[i];
+					if (pos[i] == hi.chunk[i]) end[i] = hi.block[i];
+				}
+				indices.clear();
+				RoughLocation::Fine block_pos;
+				for (block_pos.z = begin.z; block_pos.z <= end.z; ++block_pos.z) {
+					for (block_pos.y = begin.y; block_pos.y <= end.y; ++block_pos.y) {
+						for (block_pos.x = begin.x; block_pos.x <= end.x; ++block_pos.x) {
+							indices.push_back(Chunk::ToIndex(block_pos));
+						}
+					}
+				}
+				blocks.assign(indices.size(), block);
+				manip.SetBlocks(*chunk, indices, blocks);
+				filled += indices.size();
+			}
+		}
+	}
+
+	stringstream msg;
+	msg << "filled " << filled << " blocks with " << types.Get(block.type).name;
+	if (skipped > 0) {
+		msg << ", skipped " << skipped << " chunks that aren't loaded";
+	}
+	ctx.Message(msg.str());
+}
+
+
 void ImpersonateCommand::Execute(CLI &cli, CLIContext &ctx, TokenStreamReader &args) {
 	if (!args.HasMore()) {
 		// no argument => reset
@@ -129,4 +211,21 @@ void TeleportCommand::Execute(CLI &, CLIContext &ctx, TokenStreamReader &args) {
 	ctx.Broadcast(msg.str());
 }
 
+
+void TraceCommand::Execute(CLI &, CLIContext &ctx, TokenStreamReader &) {
+	// fixed name, so remote players can't have files written anywhere
+	constexpr const char *path = "blank-trace.json";
+	if (!Profiler::Recording()) {
+		Profiler::Start();
+		ctx.Message("recording trace, run trace again to stop");
+		return;
+	}
+	Profiler::Stop();
+	if (Profiler::Write(path)) {
+		ctx.Message(string("trace written to ") + path);
+	} else {
+		ctx.Error(string("unable to write ") + path);
+	}
+}
+
 }
@@ -6,6 +6,28 @@
 
 namespace blank {
 
+struct WorldManipulator;
+
+/// sets every block in a box spanned by two corners (inclusive) to one
+/// type, chunk by chunk through the manipulator's bulk interface
+/// blocks in chunks that aren't loaded are skipped
+class FillCommand
+: public CLI::Command {
+
+public:
+	/// upper limit on the number of blocks in one fill
+	static constexpr int max_volume = 1 << 18;
+
+public:
+	explicit FillCommand(WorldManipulator &manip) : manip(manip) { }
+
+	void Execute(CLI &, CLIContext &, TokenStreamReader &) override;
+
+private:
+	WorldManipulator &manip;
+
+};
+
 class ImpersonateCommand
 : public CLI::Command {
 
@@ -20,6 +42,14 @@ class TeleportCommand
 
 };
 
+/// starts the profiler, or stops it and writes the trace to a file
+class TraceCommand
+: public CLI::Command {
+
+	void Execute(CLI &, CLIContext &, TokenStreamReader &) override;
+
+};
+
 }
 
 #endif
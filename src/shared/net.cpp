@@ -4,15 +4,19 @@
 #include "CommandBuffer.hpp"
 
 #include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <string>
 
 using namespace std;
 
 
 namespace blank {
 
-CommandService::CommandService(CLI &cli, unsigned short port)
+CommandService::CommandService(CLI &cli, unsigned short port, int budget)
 : cli(cli)
+, budget(chrono::milliseconds(budget))
+, batches()
 , pool() {
 	pool.AddConnection(tcp::Socket(port), this);
 	cout << "listening on TCP port " << port << endl;
@@ -33,6 +37,7 @@ bool CommandService::Ready() noexcept {
 
 void CommandService::Handle() {
 	pool.Receive();
+	RunBatches();
 }
 
 void CommandService::Send() {
@@ -41,16 +46,49 @@ void CommandService::Send() {
 
 void CommandService::OnRecv(tcp::Socket &serv) {
 	for (tcp::Socket client = serv.Accept(); client; client = serv.Accept()) {
-		pool.AddConnection(move(client), new CommandBuffer(cli));
+		pool.AddConnection(move(client), new CommandBuffer(*this, cli));
 	}
 }
 
+void CommandService::Schedule(CommandBuffer &buf) {
+	batches.insert(&buf);
+}
 
-CommandBuffer::CommandBuffer(CLI &cli)
-: cli(cli)
+void CommandService::Unschedule(CommandBuffer &buf) noexcept {
+	batches.erase(&buf);
+}
+
+void CommandService::RunBatches() {
+	if (batches.empty()) {
+		return;
+	}
+	const chrono::steady_clock::time_point deadline = chrono::steady_clock::now() + budget;
+	for (auto i = batches.begin(); i != batches.end();) {
+		// each gets to run at least one line, so none starves
+		if ((*i)->RunPending(deadline)) {
+			i = batches.erase(i);
+		} else {
+			++i;
+		}
+	}
+}
+
+
+CommandBuffer::CommandBuffer(CommandService &service, CLI &cli)
+: service(service)
+, cli(cli)
 , write_buffer()
 , read_buffer(1440, '\0')
-, head(0) {
+, head(0)
+, pending()
+, collecting(false)
+, complete(0)
+, in_batch(false)
+, executing(false)
+, batch_line(0)
+, batch_errors(0)
+, batch_ticks(0)
+, batch_begin() {
 
 }
 
@@ -62,6 +100,12 @@ CommandBuffer::~CommandBuffer() {
 void CommandBuffer::Error(const string &msg) {
 	// TODO: prefix each line in message/error/broadcast
 	write_buffer += " ! ";
+	if (executing) {
+		++batch_errors;
+		write_buffer += "line ";
+		write_buffer += to_string(batch_line);
+		write_buffer += ": ";
+	}
 	write_buffer += msg;
 	write_buffer += '\n';
 }
@@ -102,7 +146,7 @@ void CommandBuffer::OnRecv(tcp::Socket &sock) {
 		i = find(handled, end, '\n')
 	) {
 		string line(handled, i);
-		cli.Execute(*this, line);
+		Receive(line);
 		handled = ++i;
 	}
 	if (handled == end) {
@@ -116,7 +160,73 @@ void CommandBuffer::OnRecv(tcp::Socket &sock) {
 }
 
 void CommandBuffer::OnRemove(tcp::Socket &) noexcept {
+	service.Unschedule(*this);
 	delete this;
 }
 
+void CommandBuffer::Receive(const string &line) {
+	if (line == "batch") {
+		if (collecting) {
+			Error("batch already open, end it first");
+			return;
+		}
+		collecting = true;
+		pending.push_back(line);
+	} else if (collecting) {
+		pending.push_back(line);
+		if (line == "end") {
+			collecting = false;
+			++complete;
+			service.Schedule(*this);
+		}
+	} else if (!pending.empty()) {
+		// wait for the batch in front
+		pending.push_back(line);
+	} else {
+		cli.Execute(*this, line);
+	}
+}
+
+bool CommandBuffer::Runnable() const noexcept {
+	// a batch may only start once it's been received in full
+	return !pending.empty() && (complete > 0 || pending.front() != "batch");
+}
+
+bool CommandBuffer::RunPending(chrono::steady_clock::time_point deadline) {
+	if (in_batch) {
+		++batch_ticks;
+	}
+	do {
+		if (!Runnable()) {
+			return true;
+		}
+		string line(move(pending.front()));
+		pending.pop_front();
+		if (line == "batch") {
+			in_batch = true;
+			batch_line = 0;
+			batch_errors = 0;
+			batch_ticks = 1;
+			batch_begin = chrono::steady_clock::now();
+		} else if (in_batch && line == "end") {
+			in_batch = false;
+			--complete;
+			const auto elapsed = chrono::duration_cast<chrono::milliseconds>(
+				chrono::steady_clock::now() - batch_begin);
+			Message("batch done: " + to_string(batch_line) + " lines, "
+				+ to_string(batch_errors) + " errors, "
+				+ to_string(elapsed.count()) + "ms in "
+				+ to_string(batch_ticks) + " ticks");
+		} else {
+			if (in_batch) {
+				++batch_line;
+			}
+			executing = in_batch;
+			cli.Execute(*this, line);
+			executing = false;
+		}
+	} while (chrono::steady_clock::now() < deadline);
+	return !Runnable();
+}
+
 }
@@ -78,6 +78,7 @@ MasterState::MasterState(
 	generator.LoadTypes(res.block_types);
 	chunk_renderer.LoadTextures(env.loader, res.tex_index);
 	chunk_renderer.FogDensity(wc.fog_density);
+	chunk_renderer.UseLightVolume(config.video.light_volume);
 	if (save.Exists(player)) {
 		save.Read(player);
 	} else {
@@ -187,7 +188,7 @@ void MasterState::Render(Viewport &viewport) {
 	viewport.WorldPosition(player.GetEntity().ViewTransform(player.GetEntity().ChunkCoords()));
 	if (config.video.world) {
 		chunk_renderer.Render(viewport);
-		world.Render(viewport);
+		world.Render(viewport, config.video.lod);
 		if (config.video.debug) {
 			world.RenderDebug(viewport);
 		}
@@ -3,7 +3,6 @@
 
 #include "../graphics/align.hpp"
 #include "../graphics/glm.hpp"
-#include "../graphics/Texture.hpp"
 #include "../graphics/SpriteMesh.hpp"
 
 #include <string>
@@ -38,8 +37,12 @@ private:
 	void Update();
 
 private:
-	Texture tex;
+	const Font *font;
+	std::string text;
+	// glyph quads, referencing the font's atlas
 	SpriteMesh sprite;
+	// atlas generation the quads were made for
+	unsigned int generation;
 	glm::vec2 size;
 	Gravity pivot;
 	bool dirty;
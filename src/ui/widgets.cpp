@@ -119,8 +119,10 @@ void Progress::Render(Viewport &viewport) noexcept {
 
 
 Text::Text() noexcept
-: tex()
+: font(nullptr)
+, text()
 , sprite()
+, generation(0)
 , size(0.0f)
 , pivot(Gravity::NORTH_WEST)
 , dirty(false) {
@@ -137,10 +139,11 @@ FixedText::FixedText() noexcept
 
 }
 
-void Text::Set(const Font &font, const char *text) {
-	font.Render(text, tex);
-	size = font.TextSize(text);
-	dirty = true;
+void Text::Set(const Font &f, const char *t) {
+	font = &f;
+	text = t;
+	// size is needed right away
+	Update();
 }
 
 namespace {
@@ -150,7 +153,8 @@ SpriteMesh::Buffer sprite_buf;
 }
 
 void Text::Update() {
-	sprite_buf.LoadRect(size.x, size.y, align(pivot, size));
+	sprite_buf.Clear();
+	size = font->Layout(text.c_str(), sprite_buf, pivot, generation);
 	sprite.Update(sprite_buf);
 	dirty = false;
 }
@@ -165,11 +169,14 @@ void FixedText::Render(Viewport &viewport) noexcept {
 }
 
 void Text::Render(Viewport &viewport) noexcept {
-	if (dirty) {
+	if (!font) {
+		return;
+	}
+	if (dirty || generation != font->AtlasGeneration()) {
 		Update();
 	}
 	BlendedSprite &prog = viewport.SpriteProgram();
-	prog.SetTexture(tex);
+	prog.SetTexture(font->Atlas());
 	sprite.Draw();
 }
 
@@ -342,7 +349,7 @@ void TextInput::Render(Viewport &viewport) {
 		} else if (AtEnd()) {
 			offset = -align(text.Pivot(), text.Size(), glm::vec2(-text.Size().x, 0.0f));
 		} else {
-			offset = -align(text.Pivot(), text.Size(), glm::vec2(-font.TextSize(input.substr(0, cursor).c_str()).x, 0.0f));
+			offset = -align(text.Pivot(), text.Size(), glm::vec2(-font.LayoutWidth(input.substr(0, cursor).c_str()), 0.0f));
 		}
 		viewport.MoveCursor(glm::vec3(offset, -1.0f));
 		PlainColor &prog = viewport.HUDColorProgram();
@@ -7,6 +7,7 @@
 #include "../geometry/primitive.hpp"
 #include "../graphics/glm.hpp"
 
+#include <cstdint>
 #include <set>
 #include <vector>
 #include <glm/gtx/transform.hpp>
@@ -123,6 +124,15 @@ public:
 	// check which faces of a block at given index are obstructed (and therefore invisible)
 	Block::FaceSet Obstructed(const RoughLocation::Fine &) const noexcept;
 
+	/// check if one can look into this chunk through face a and out of
+	/// face b, as of the last call to UpdateConnectivity()
+	bool FacesConnected(Block::Face a, Block::Face b) const noexcept {
+		return (connectivity >> (a * Block::FACE_COUNT + b)) & 1;
+	}
+	/// flood fill through blocks that are not fully opaque to find out
+	/// which faces connect, called when the mesh is rebuilt
+	void UpdateConnectivity() noexcept;
+
 	void SetBlock(int index, const Block &) noexcept;
 	void SetBlock(const ExactLocation::Fine &pos, const Block &block) noexcept { SetBlock(ToIndex(pos), block); }
 	void SetBlock(const RoughLocation::Fine &pos, const Block &block) noexcept { SetBlock(ToIndex(pos), block); }
@@ -143,6 +153,8 @@ public:
 	int GetLight(const RoughLocation::Fine &pos) const noexcept { return GetLight(ToIndex(pos)); }
 
 	float GetVertexLight(const RoughLocation::Fine &, const BlockMesh::Position &, const EntityMesh::Normal &) const noexcept;
+	/// light levels of all blocks, indexed like blocks
+	const unsigned char *LightData() const noexcept { return light; }
 
 	/// get gravity for one unit mass at given point
 	glm::vec3 GravityAt(const ExactLocation &) const noexcept;
@@ -201,14 +213,21 @@ public:
 	void UnRef() noexcept { --ref_count; }
 	bool Referenced() const noexcept { return ref_count > 0; }
 
-	void Invalidate() noexcept { dirty_mesh = dirty_save = true; }
-	void InvalidateMesh() noexcept { dirty_mesh = true; }
+	// a stale mesh implies stale light, but light may change on its own
+	void Invalidate() noexcept { dirty_mesh = dirty_light = dirty_save = true; }
+	void InvalidateMesh() noexcept { dirty_mesh = dirty_light = true; }
 	void ClearMesh() noexcept { dirty_mesh = false; }
+	void ClearLight() noexcept { dirty_light = false; }
 	void ClearSave() noexcept { dirty_save = false; }
 	bool ShouldUpdateMesh() const noexcept { return dirty_mesh; }
+	bool ShouldUpdateLight() const noexcept { return dirty_light; }
 	bool ShouldUpdateSave() const noexcept { return dirty_save; }
 
-	void Update(BlockMesh &) noexcept;
+	/// fill given buffer with this chunk's blocks and clear the mesh
+	/// flag, as well as the light flag if vertex_light is set
+	/// with vertex_light unset, the mesh's light attribute is left at
+	/// zero and light is expected to come from a volume texture instead
+	void BuildMesh(BlockMesh::Buffer &, bool vertex_light = true) noexcept;
 
 private:
 	const BlockTypeRegistry *types;
@@ -220,10 +239,13 @@ private:
 	unsigned char light[size];
 	bool generated;
 	bool lighted;
+	// bit a * FACE_COUNT + b is set if faces a and b are connected
+	std::uint64_t connectivity;
 
 	ExactLocation::Coarse position;
 	int ref_count;
 	bool dirty_mesh;
+	bool dirty_light;
 	bool dirty_save;
 
 };
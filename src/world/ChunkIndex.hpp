@@ -46,6 +46,12 @@ public:
 	}
 
 	int Extent() const noexcept { return extent; }
+	int SideLength() const noexcept { return side_length; }
+	/// position of slot i in the index' storage, which wraps around
+	/// on each axis as the base moves
+	ExactLocation::Coarse SlotCoords(int i) const noexcept {
+		return ExactLocation::Coarse(i % side_length, (i / side_length) % side_length, i / (side_length * side_length));
+	}
 
 	// raw iteration access, may contain nullptrs
 	std::vector<Chunk *>::const_iterator begin() const noexcept { return chunks.begin(); }
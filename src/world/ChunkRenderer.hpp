@@ -5,7 +5,12 @@
 #include "Chunk.hpp"
 #include "../graphics/ArrayTexture.hpp"
 #include "../graphics/BlockMesh.hpp"
+#include "../graphics/BlockMeshArena.hpp"
+#include "../graphics/VolumeTexture.hpp"
+#include "../graphics/glm.hpp"
 
+#include <chrono>
+#include <cstddef>
 #include <vector>
 
 
@@ -14,17 +19,40 @@ namespace blank {
 class AssetLoader;
 class BlockMesh;
 class ChunkIndex;
+struct Frustum;
 class ResourceIndex;
 class Viewport;
 
 class ChunkRenderer {
 
+public:
+	/// accumulated since the last ResetStats()
+	struct Stats {
+		using Duration = std::chrono::steady_clock::duration;
+		/// frustum and occlusion culling
+		Duration cull = Duration::zero();
+		/// building mesh buffers from chunk data
+		Duration mesh = Duration::zero();
+		/// sending meshes and light to the GPU
+		Duration upload = Duration::zero();
+		/// queueing and submitting draw calls
+		Duration draw = Duration::zero();
+		std::size_t meshes = 0;
+		std::size_t draw_calls = 0;
+		std::size_t uploaded_bytes = 0;
+	};
+
 public:
 	explicit ChunkRenderer(ChunkIndex &);
 	~ChunkRenderer();
 
 	void LoadTextures(const AssetLoader &, const ResourceIndex &);
 	void FogDensity(float d) noexcept { fog_density = d; }
+	/// sample block light from a 3D texture instead of baking it into
+	/// the meshes, so light changes don't need a remesh
+	/// falls back to per vertex light if the texture would be too big
+	void UseLightVolume(bool);
+	bool UsesLightVolume() const noexcept { return use_light_volume; }
 
 	int MissingChunks() const noexcept;
 
@@ -32,14 +60,67 @@ public:
 
 	void Render(Viewport &);
 
+	const Stats &GetStats() const noexcept { return stats; }
+	void ResetStats() noexcept { stats = Stats(); }
+
+private:
+	/// collect index slots of chunks that intersect the frustum in visible
+	void Cull(const Frustum &);
+	/// narrow visible down to chunks that can be seen from the camera
+	/// through connected chunk faces
+	void Occlude(const glm::vec3 &camera);
+
+	/// true if chunk's mesh has to be built again
+	bool MeshOutdated(const Chunk &) const noexcept;
+	/// rebuild the mesh in given slot
+	void Remesh(int);
+	/// copy the light of chunks that changed or moved into the volume
+	void UpdateLightVolume();
+
 private:
 	ChunkIndex &index;
+	// must outlive the models
+	BlockMeshArena arena;
 	std::vector<BlockMesh> models;
+	BlockMesh::Buffer mesh_buf;
+
+	std::vector<int> visible;
+	// chunks whose group straddles the frustum, to be tested in batch
+	std::vector<float> candidate_x;
+	std::vector<float> candidate_y;
+	std::vector<float> candidate_z;
+	std::vector<int> candidate_index;
+	std::vector<std::size_t> candidate_visible;
+
+	// per index slot flags for the occlusion search
+	enum {
+		IN_FRUSTUM = 1,
+		REACHED = 2,
+	};
+	std::vector<unsigned char> marks;
+	struct Step {
+		int slot;
+		ExactLocation::Coarse pos;
+		// face through which the chunk was entered, FACE_COUNT for the start
+		Block::Face entry;
+		// directions taken so far, the search never turns back
+		Block::FaceSet travelled;
+	};
+	std::vector<Step> steps;
 
 	ArrayTexture block_tex;
 
+	bool use_light_volume;
+	// light levels of the whole index, with each slot's chunk at its
+	// SlotCoords, so it wraps around just like the index does
+	VolumeTexture light_volume;
+	// chunk whose light was last copied into each slot's part
+	std::vector<const Chunk *> light_slots;
+
 	float fog_density;
 
+	Stats stats;
+
 };
 
 }
@@ -35,6 +35,10 @@ public:
 	std::list<Chunk>::iterator end() noexcept { return loaded.end(); }
 
 	std::size_t NumLoaded() const noexcept { return loaded.size(); }
+	/// number of chunk objects kept around for reuse
+	std::size_t NumFree() const noexcept { return free.size(); }
+	/// number of loaded chunks with changes that aren't saved yet
+	std::size_t NumUnsaved() const noexcept;
 
 	/// returns true if one of the indices is incomplete
 	bool HasMissing() const noexcept;
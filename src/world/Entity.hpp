@@ -16,7 +16,7 @@
 
 namespace blank {
 
-class DirectionalLighting;
+class EntityBatch;
 class EntityController;
 class Shape;
 class World;
@@ -124,9 +124,26 @@ public:
 
 	void Update(World &, float dt);
 
-	void Render(const glm::mat4 &M, DirectionalLighting &prog) noexcept {
-		if (model) model.Render(M, prog);
+	/// queue the model's parts, leaving out those smaller than min_radius
+	void Render(const glm::mat4 &M, EntityBatch &batch, float min_radius = 0.0f) {
+		if (model) model.Render(M, batch, min_radius);
 	}
+	/// queue the model as a single mesh in its initial pose
+	void RenderMerged(const glm::mat4 &M, EntityBatch &batch) {
+		if (model) model.RenderMerged(M, batch);
+	}
+
+	/// light as last sampled by the world's renderer, only valid as long
+	/// as the entity stays in the block it was sampled in
+	struct LightSample {
+		glm::ivec3 chunk = glm::ivec3(0);
+		glm::ivec3 block = glm::ivec3(0);
+		glm::vec3 direction = glm::vec3(0.0f);
+		glm::vec3 color = glm::vec3(0.0f);
+		glm::vec3 ambient = glm::vec3(0.0f);
+		bool valid = false;
+	};
+	LightSample &CachedLight() noexcept { return light; }
 
 private:
 	void UpdatePhysics(World &, float dt);
@@ -177,6 +194,8 @@ private:
 
 	int ref_count;
 
+	LightSample light;
+
 	bool world_collision;
 	bool dead;
 
@@ -5,6 +5,7 @@
 #include "Entity.hpp"
 #include "Generator.hpp"
 #include "Player.hpp"
+#include "../graphics/EntityBatch.hpp"
 #include "../graphics/glm.hpp"
 #include "../rand/GaloisLFSR.hpp"
 
@@ -117,20 +118,27 @@ public:
 	/// get force due to gravity at given location
 	glm::vec3 GravityAt(const ExactLocation &) const noexcept;
 
-	void Render(Viewport &);
+	/// with lod set, entities are culled by fog distance, simplified
+	/// with distance, and lit by a sample cached per block
+	void Render(Viewport &, bool lod);
 	void RenderDebug(Viewport &);
+	/// batch used by the last Render(), for its counters
+	const EntityBatch &EntityDraws() const noexcept { return entity_batch; }
 
 private:
 	using EntityHandle = std::list<Entity>::iterator;
 	EntityHandle RemoveEntity(EntityHandle &);
 
 	/// calculate light direction and intensity at entity's location
-	void GetLight(
+	/// @return false if the entity's chunk is missing and a fallback was used
+	bool GetLight(
 		const Entity &entity,
 		glm::vec3 &direction,
 		glm::vec3 &color,
 		glm::vec3 &ambient
 	);
+	/// light at entity's location, sampled again only if it changed blocks
+	const Entity::LightSample &CachedLight(Entity &);
 
 private:
 	Config config;
@@ -147,6 +155,8 @@ private:
 	glm::vec3 light_direction;
 	float fog_density;
 
+	EntityBatch entity_batch;
+
 };
 
 }
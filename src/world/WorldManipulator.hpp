@@ -1,6 +1,8 @@
 #ifndef BLANK_WORLD_WORLDMANIPULATOR_HPP_
 #define BLANK_WORLD_WORLDMANIPULATOR_HPP_
 
+#include <vector>
+
 
 namespace blank {
 
@@ -11,6 +13,11 @@ struct WorldManipulator {
 
 	virtual void SetBlock(Chunk &, int, const Block &) = 0;
 
+	/// set blocks[i] at indices[i] for all i, both must be the same size
+	/// the default just calls SetBlock for each, implementations can
+	/// override this to batch whatever they do in reaction to a change
+	virtual void SetBlocks(Chunk &, const std::vector<int> &indices, const std::vector<Block> &blocks);
+
 };
 
 }
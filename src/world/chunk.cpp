@@ -8,6 +8,7 @@
 #include "Generator.hpp"
 #include "WorldCollision.hpp"
 #include "../app/Assets.hpp"
+#include "../app/Profiler.hpp"
 #include "../geometry/distance.hpp"
 #include "../graphics/BlockLighting.hpp"
 #include "../graphics/BlockMesh.hpp"
@@ -28,6 +29,12 @@ namespace blank {
 constexpr int Chunk::side;
 constexpr int Chunk::size;
 
+namespace {
+
+constexpr std::uint64_t all_connected = (std::uint64_t(1) << (Block::FACE_COUNT * Block::FACE_COUNT)) - 1;
+
+}
+
 
 Chunk::Chunk(const BlockTypeRegistry &types) noexcept
 : types(&types)
@@ -36,9 +43,11 @@ Chunk::Chunk(const BlockTypeRegistry &types) noexcept
 , light{0}
 , generated(false)
 , lighted(false)
+, connectivity(all_connected)
 , position(0, 0, 0)
 , ref_count(0)
 , dirty_mesh(false)
+, dirty_light(false)
 , dirty_save(false) {
 
 }
@@ -48,9 +57,11 @@ Chunk::Chunk(Chunk &&other) noexcept
 , gravity(std::move(other.gravity))
 , generated(other.generated)
 , lighted(other.lighted)
+, connectivity(other.connectivity)
 , position(other.position)
 , ref_count(other.ref_count)
 , dirty_mesh(other.dirty_mesh)
+, dirty_light(other.dirty_light)
 , dirty_save(other.dirty_save) {
 	std::copy(other.neighbor, other.neighbor + sizeof(neighbor), neighbor);
 	std::copy(other.blocks, other.blocks + sizeof(blocks), blocks);
@@ -66,9 +77,11 @@ Chunk &Chunk::operator =(Chunk &&other) noexcept {
 	std::copy(other.light, other.light + sizeof(light), light);
 	generated = other.generated;
 	lighted = other.lighted;
+	connectivity = other.connectivity;
 	position = other.position;
 	std::swap(ref_count, other.ref_count);
 	dirty_mesh = other.dirty_save;
+	dirty_light = other.dirty_light;
 	dirty_save = other.dirty_save;
 	return *this;
 }
@@ -271,7 +284,7 @@ void Chunk::Unlink() noexcept {
 void Chunk::SetLight(int index, int level) noexcept {
 	if (light[index] != level) {
 		light[index] = level;
-		Invalidate();
+		dirty_light = dirty_save = true;
 	}
 }
 
@@ -542,13 +555,9 @@ bool Chunk::Intersection(
 }
 
 
-namespace {
-
-BlockMesh::Buffer buf;
-
-}
+void Chunk::BuildMesh(BlockMesh::Buffer &buf, bool vertex_light) noexcept {
+	UpdateConnectivity();
 
-void Chunk::Update(BlockMesh &model) noexcept {
 	int vtx_count = 0, idx_count = 0;
 	for (const auto &block : blocks) {
 		const BlockType &type = Type(block);
@@ -575,20 +584,27 @@ void Chunk::Update(BlockMesh &model) noexcept {
 					size_t vtx_begin = vtx_counter;
 					vtx_counter += type.shape->VertexCount();
 
-					for (size_t vtx = vtx_begin; vtx < vtx_counter; ++vtx) {
-						buf.lights.emplace_back(GetVertexLight(
-							pos,
-							buf.vertices[vtx],
-							type.shape->VertexNormal(vtx - vtx_begin, BlockAt(idx).Transform())
-						));
+					if (vertex_light) {
+						for (size_t vtx = vtx_begin; vtx < vtx_counter; ++vtx) {
+							buf.lights.emplace_back(GetVertexLight(
+								pos,
+								buf.vertices[vtx],
+								type.shape->VertexNormal(vtx - vtx_begin, BlockAt(idx).Transform())
+							));
+						}
 					}
 				}
 			}
 		}
 	}
 
-	model.Update(buf);
+	if (!vertex_light) {
+		buf.lights.resize(buf.vertices.size(), 0.0f);
+	}
 	ClearMesh();
+	if (vertex_light) {
+		ClearLight();
+	}
 }
 
 Block::FaceSet Chunk::Obstructed(const RoughLocation::Fine &pos) const noexcept {
@@ -605,6 +621,64 @@ Block::FaceSet Chunk::Obstructed(const RoughLocation::Fine &pos) const noexcept
 	return result;
 }
 
+void Chunk::UpdateConnectivity() noexcept {
+	// a block only hides what's behind it if it fills all of its faces
+	// open also doubles as the "not yet visited" flag of the flood fill
+	bool open[size];
+	bool any_closed = false;
+	for (int i = 0; i < size; ++i) {
+		const BlockType &type = Type(i);
+		bool closed = type.visible;
+		for (int f = 0; closed && f < Block::FACE_COUNT; ++f) {
+			closed = type.FaceFilled(blocks[i], Block::Face(f));
+		}
+		open[i] = !closed;
+		any_closed = any_closed || closed;
+	}
+	if (!any_closed) {
+		connectivity = all_connected;
+		return;
+	}
+
+	connectivity = 0;
+	int queue[size];
+	for (int start = 0; start < size; ++start) {
+		if (!open[start] || !IsBorder(start)) {
+			continue;
+		}
+		// collect the faces touched by this cavity
+		Block::FaceSet faces;
+		int head = 0, tail = 0;
+		queue[tail++] = start;
+		open[start] = false;
+		while (head < tail) {
+			const RoughLocation::Fine pos(ToPos(queue[head++]));
+			for (int f = 0; f < Block::FACE_COUNT; ++f) {
+				const RoughLocation::Fine next(pos + Block::FaceNormal(Block::Face(f)));
+				if (!InBounds(next)) {
+					faces.Set(Block::Face(f));
+					continue;
+				}
+				const int next_idx = ToIndex(next);
+				if (open[next_idx]) {
+					open[next_idx] = false;
+					queue[tail++] = next_idx;
+				}
+			}
+		}
+		for (int a = 0; a < Block::FACE_COUNT; ++a) {
+			if (!faces.IsSet(Block::Face(a))) {
+				continue;
+			}
+			for (int b = 0; b < Block::FACE_COUNT; ++b) {
+				if (faces.IsSet(Block::Face(b))) {
+					connectivity |= std::uint64_t(1) << (a * Block::FACE_COUNT + b);
+				}
+			}
+		}
+	}
+}
+
 glm::mat4 Chunk::ToTransform(const RoughLocation::Fine &pos, int idx) const noexcept {
 	return glm::translate(ToCoords(pos)) * BlockAt(idx).Transform();
 }
@@ -694,6 +768,7 @@ ChunkLoader::ChunkLoader(
 }
 
 void ChunkLoader::Update(int) {
+	Profiler::Zone zone("ChunkLoader::Update");
 	// check if there's chunks waiting to be loaded
 	// load until one of load or generation limits was hit
 	constexpr int max_load = 10;
@@ -781,10 +856,27 @@ void ChunkLoader::LoadN(std::size_t n) {
 
 ChunkRenderer::ChunkRenderer(ChunkIndex &index)
 : index(index)
-, models(index.TotalChunks())
+, arena()
+, models()
+, mesh_buf()
+, visible()
+, candidate_x()
+, candidate_y()
+, candidate_z()
+, candidate_index()
+, candidate_visible()
+, marks(index.TotalChunks())
+, steps()
 , block_tex()
-, fog_density(0.0f) {
-
+, use_light_volume(false)
+, light_volume()
+, light_slots()
+, fog_density(0.0f)
+, stats() {
+	models.reserve(index.TotalChunks());
+	for (int i = 0; i < index.TotalChunks(); ++i) {
+		models.emplace_back(arena);
+	}
 }
 
 ChunkRenderer::~ChunkRenderer() {
@@ -802,39 +894,259 @@ void ChunkRenderer::LoadTextures(const AssetLoader &loader, const ResourceIndex
 }
 
 void ChunkRenderer::Update(int dt) {
+	Profiler::Zone zone("ChunkRenderer::Update");
 	for (int i = 0, updates = 0; updates < dt && i < index.TotalChunks(); ++i) {
 		if (!index[i]) continue;
 		if (!index[i]->Lighted() && index.HasAllSurrounding(index[i]->Position())) {
 			index[i]->ScanLights();
 		}
-		if (index[i]->ShouldUpdateMesh()) {
-			index[i]->Update(models[i]);
+		if (MeshOutdated(*index[i])) {
+			Remesh(i);
 			++updates;
 		}
 	}
 }
 
+namespace {
+
+// for slots without a chunk
+const unsigned char no_light[Chunk::size] = { 0 };
+
+}
+
+void ChunkRenderer::UseLightVolume(bool enable) {
+	if (enable) {
+		GLint max_size = 0;
+		glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &max_size);
+		const int size = index.SideLength() * Chunk::side;
+		if (size > max_size) {
+			enable = false;
+		} else if (light_volume.Width() == 0) {
+			light_volume.Bind();
+			light_volume.Reserve(size, size, size);
+			light_volume.FilterLinear();
+			light_volume.WrapRepeat();
+			// start out dark, so slots without a chunk are defined
+			for (int i = 0; i < index.TotalChunks(); ++i) {
+				const glm::ivec3 pos(index.SlotCoords(i) * Chunk::side);
+				light_volume.Data(pos.x, pos.y, pos.z, Chunk::side, Chunk::side, Chunk::side, no_light);
+			}
+			light_slots.assign(index.TotalChunks(), nullptr);
+		}
+	}
+	if (enable == use_light_volume) {
+		return;
+	}
+	use_light_volume = enable;
+	// meshes built for the other mode are no good
+	for (Chunk *chunk : index) {
+		if (chunk) {
+			chunk->InvalidateMesh();
+		}
+	}
+}
+
+bool ChunkRenderer::MeshOutdated(const Chunk &chunk) const noexcept {
+	return chunk.ShouldUpdateMesh() || (!use_light_volume && chunk.ShouldUpdateLight());
+}
+
+void ChunkRenderer::UpdateLightVolume() {
+	const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	light_volume.Bind();
+	for (int i = 0; i < index.TotalChunks(); ++i) {
+		Chunk *chunk = index[i];
+		if (chunk == light_slots[i] && (!chunk || !chunk->ShouldUpdateLight())) {
+			continue;
+		}
+		const glm::ivec3 pos(index.SlotCoords(i) * Chunk::side);
+		light_volume.Data(
+			pos.x, pos.y, pos.z,
+			Chunk::side, Chunk::side, Chunk::side,
+			chunk ? chunk->LightData() : no_light
+		);
+		if (chunk) {
+			chunk->ClearLight();
+		}
+		light_slots[i] = chunk;
+		stats.uploaded_bytes += Chunk::size;
+	}
+	stats.upload += std::chrono::steady_clock::now() - begin;
+}
+
 void ChunkRenderer::Render(Viewport &viewport) {
+	Profiler::Zone zone("ChunkRenderer::Render");
 	BlockLighting &chunk_prog = viewport.ChunkProgram();
+	if (use_light_volume) {
+		// binds to the active unit, so do this before setting block_tex
+		UpdateLightVolume();
+	}
 	chunk_prog.SetTexture(block_tex);
 	chunk_prog.SetFogDensity(fog_density);
+	if (use_light_volume) {
+		const glm::vec3 origin(index.SlotCoords(index.IndexOf(index.Base())) * Chunk::side);
+		chunk_prog.SetLightVolume(light_volume, origin);
+	} else {
+		chunk_prog.DisableLightVolume();
+	}
 
-	Frustum frustum(glm::transpose(chunk_prog.GetVP()));
-	AABB box;
+	const std::chrono::steady_clock::time_point cull_begin = std::chrono::steady_clock::now();
+	Cull(Frustum(glm::transpose(chunk_prog.GetVP())));
+	Occlude(viewport.CameraPosition());
+	stats.cull += std::chrono::steady_clock::now() - cull_begin;
 
-	for (int i = 0; i < index.TotalChunks(); ++i) {
-		if (!index[i]) continue;
-		box.min = (index[i]->Position() - index.Base()) * ExactLocation::Extent();
-		box.max = box.min + ExactLocation::FExtent();
+	for (int i : visible) {
+		if (MeshOutdated(*index[i])) {
+			Remesh(i);
+		}
+	}
+
+	const std::chrono::steady_clock::time_point draw_begin = std::chrono::steady_clock::now();
+	const std::size_t uploaded = arena.UploadedBytes();
+	// chunk offsets go in as a vertex attribute, so the model
+	// transform is the same for all of them
+	chunk_prog.SetM(glm::mat4(1.0f));
+	arena.Bind();
+	for (int i : visible) {
+		if (!models[i].Empty()) {
+			models[i].Queue(index[i]->ToSceneCoords(index.Base(), ExactLocation::Fine(0.0f)));
+		}
+	}
+	arena.DrawQueued();
+	stats.draw_calls += arena.DrawCalls();
+	stats.uploaded_bytes += arena.UploadedBytes() - uploaded;
+	stats.draw += std::chrono::steady_clock::now() - draw_begin;
+}
+
+void ChunkRenderer::Remesh(int i) {
+	const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	index[i]->BuildMesh(mesh_buf, !use_light_volume);
+	const std::chrono::steady_clock::time_point built = std::chrono::steady_clock::now();
+	const std::size_t uploaded = arena.UploadedBytes();
+	models[i].Update(mesh_buf);
+	stats.mesh += built - begin;
+	stats.upload += std::chrono::steady_clock::now() - built;
+	stats.uploaded_bytes += arena.UploadedBytes() - uploaded;
+	++stats.meshes;
+}
+
+void ChunkRenderer::Cull(const Frustum &frustum) {
+	visible.clear();
+	candidate_x.clear();
+	candidate_y.clear();
+	candidate_z.clear();
+	candidate_index.clear();
+
+	// groups of 2x2x2 chunks are tested first, those completely inside
+	// or outside the frustum decide for all of their chunks at once
+	const int extent = index.Extent();
+	const ExactLocation::Coarse &base = index.Base();
+	AABB group;
+	ExactLocation::Coarse begin;
+	for (begin.z = -extent; begin.z <= extent; begin.z += 2) {
+		for (begin.y = -extent; begin.y <= extent; begin.y += 2) {
+			for (begin.x = -extent; begin.x <= extent; begin.x += 2) {
+				// the index' side length is odd, so the last group on
+				// each axis is only one chunk thick
+				const ExactLocation::Coarse end(glm::min(begin + 2, ExactLocation::Coarse(extent + 1)));
+				group.min = glm::vec3(begin * ExactLocation::Extent());
+				group.max = glm::vec3(end * ExactLocation::Extent());
+				if (CullTest(group, frustum)) {
+					continue;
+				}
+				const bool contained = ContainTest(group, frustum);
+				ExactLocation::Coarse pos;
+				for (pos.z = begin.z; pos.z < end.z; ++pos.z) {
+					for (pos.y = begin.y; pos.y < end.y; ++pos.y) {
+						for (pos.x = begin.x; pos.x < end.x; ++pos.x) {
+							// empty slots are kept since the occlusion
+							// search has to be able to pass through them
+							const int i = index.IndexOf(base + pos);
+							if (contained) {
+								visible.push_back(i);
+							} else {
+								const glm::vec3 min(pos * ExactLocation::Extent());
+								candidate_x.push_back(min.x);
+								candidate_y.push_back(min.y);
+								candidate_z.push_back(min.z);
+								candidate_index.push_back(i);
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	candidate_visible.resize(candidate_index.size());
+	const std::size_t num_visible = CullBatch(
+		ExactLocation::FExtent(),
+		candidate_x.data(),
+		candidate_y.data(),
+		candidate_z.data(),
+		candidate_index.size(),
+		frustum,
+		candidate_visible.data()
+	);
+	for (std::size_t i = 0; i < num_visible; ++i) {
+		visible.push_back(candidate_index[candidate_visible[i]]);
+	}
+}
+
+void ChunkRenderer::Occlude(const glm::vec3 &camera) {
+	const int extent = index.Extent();
+	const ExactLocation::Coarse &base = index.Base();
+	const ExactLocation::Coarse start(glm::floor(camera / ExactLocation::FExtent()));
+	if (glm::any(glm::greaterThan(glm::abs(start), ExactLocation::Coarse(extent)))) {
+		// camera outside the index, nothing to start the search from
+		visible.erase(
+			std::remove_if(visible.begin(), visible.end(), [this](int i) { return !index[i]; }),
+			visible.end());
+		return;
+	}
 
-		if (!CullTest(box, frustum)) {
-			if (index[i]->ShouldUpdateMesh()) {
-				index[i]->Update(models[i]);
+	std::fill(marks.begin(), marks.end(), 0);
+	for (int i : visible) {
+		marks[i] = IN_FRUSTUM;
+	}
+	visible.clear();
+	steps.clear();
+
+	// breadth first from the camera's chunk, only stepping from one
+	// chunk into the next if the face we came in through connects to
+	// the one we're leaving by
+	const int start_slot = index.IndexOf(base + start);
+	marks[start_slot] |= REACHED;
+	steps.push_back({ start_slot, start, Block::FACE_COUNT, Block::FaceSet() });
+	for (std::size_t head = 0; head < steps.size(); ++head) {
+		// steps may reallocate, so copy
+		const Step step = steps[head];
+		const Chunk *chunk = index[step.slot];
+		if (chunk) {
+			visible.push_back(step.slot);
+		}
+		// missing chunks and those with outdated connectivity can't
+		// be relied on to block anything
+		const bool trust = chunk && step.entry != Block::FACE_COUNT && !chunk->ShouldUpdateMesh();
+		for (int f = 0; f < Block::FACE_COUNT; ++f) {
+			const Block::Face face = Block::Face(f);
+			if (step.travelled.IsSet(Block::Opposite(face))) {
+				continue;
+			}
+			if (trust && !chunk->FacesConnected(step.entry, face)) {
+				continue;
+			}
+			const ExactLocation::Coarse pos(step.pos + Block::FaceNormal(face));
+			if (glm::any(glm::greaterThan(glm::abs(pos), ExactLocation::Coarse(extent)))) {
+				continue;
 			}
-			if (!models[i].Empty()) {
-				chunk_prog.SetM(index[i]->Transform(index.Base()));
-				models[i].Draw();
+			const int slot = index.IndexOf(base + pos);
+			if (marks[slot] != IN_FRUSTUM) {
+				continue;
 			}
+			marks[slot] |= REACHED;
+			Block::FaceSet travelled(step.travelled);
+			travelled.Set(face);
+			steps.push_back({ slot, pos, Block::Opposite(face), travelled });
 		}
 	}
 }
@@ -1148,6 +1460,16 @@ bool ChunkStore::HasMissing() const noexcept {
 	return false;
 }
 
+std::size_t ChunkStore::NumUnsaved() const noexcept {
+	std::size_t unsaved = 0;
+	for (const Chunk &chunk : loaded) {
+		if (chunk.ShouldUpdateSave()) {
+			++unsaved;
+		}
+	}
+	return unsaved;
+}
+
 int ChunkStore::EstimateMissing() const noexcept {
 	int missing = 0;
 	for (const ChunkIndex &index : indices) {
@@ -5,11 +5,14 @@
 #include "EntityState.hpp"
 #include "Player.hpp"
 #include "World.hpp"
+#include "WorldManipulator.hpp"
 
+#include "Chunk.hpp"
 #include "ChunkIndex.hpp"
 #include "EntityCollision.hpp"
 #include "WorldCollision.hpp"
 #include "../app/Assets.hpp"
+#include "../app/Profiler.hpp"
 #include "../geometry/const.hpp"
 #include "../geometry/distance.hpp"
 #include "../geometry/rotation.hpp"
@@ -53,6 +56,7 @@ Entity::Entity() noexcept
 , max_vel(5.0f)
 , max_force(25.0f)
 , ref_count(0)
+, light()
 , world_collision(false)
 , dead(false)
 , owns_controller(false) {
@@ -78,6 +82,7 @@ Entity::Entity(const Entity &other) noexcept
 , max_vel(other.max_vel)
 , max_force(other.max_force)
 , ref_count(0)
+, light()
 , world_collision(other.world_collision)
 , dead(other.dead)
 , owns_controller(false) {
@@ -628,6 +633,13 @@ glm::vec3 Steering::ObstacleAvoidance(const EntityState &) const noexcept {
 }
 
 
+void WorldManipulator::SetBlocks(Chunk &chunk, const std::vector<int> &indices, const std::vector<Block> &blocks) {
+	for (std::size_t i = 0; i < indices.size(); ++i) {
+		SetBlock(chunk, indices[i], blocks[i]);
+	}
+}
+
+
 World::World(const BlockTypeRegistry &types, const Config &config)
 : config(config)
 , block_type(types)
@@ -642,7 +654,8 @@ std::time(nullptr)
 #endif
 )
 , light_direction(config.light_direction)
-, fog_density(config.fog_density) {
+, fog_density(config.fog_density)
+, entity_batch() {
 	for (int i = 0; i < 4; ++i) {
 		rng.Next<int>();
 	}
@@ -939,6 +952,7 @@ bool World::Intersection(
 }
 
 void World::Update(int dt) {
+	Profiler::Zone zone("World::Update");
 	float fdt(dt * 0.001f);
 	for (Entity &entity : entities) {
 		entity.Update(*this, fdt);
@@ -1054,27 +1068,70 @@ World::EntityHandle World::RemoveEntity(EntityHandle &eh) {
 }
 
 
-void World::Render(Viewport &viewport) {
-	DirectionalLighting &entity_prog = viewport.EntityProgram();
+namespace {
+
+/// entities closer to the camera than this are drawn in full detail
+constexpr float lod_near = 16.0f;
+/// entities farther away than this are drawn as a single merged mesh
+constexpr float lod_far = 48.0f;
+/// in between, parts with a radius below distance times this are left out
+constexpr float lod_part_ratio = 0.01f;
+
+}
+
+void World::Render(Viewport &viewport, bool lod) {
+	InstancedLighting &entity_prog = viewport.EntityProgram();
 	entity_prog.SetFogDensity(fog_density);
 
+	// parts are collected and drawn with one call per distinct mesh
 	glm::vec3 light_dir;
 	glm::vec3 light_col;
 	glm::vec3 ambient_col;
+	// fog is practically opaque beyond this
+	const float fog_limit = std::exp(1.0f) / (2.0f * fog_density);
+	const glm::vec3 &camera = viewport.CameraPosition();
 	for (Entity &entity : entities) {
 		glm::mat4 M(entity.Transform(players.front().GetEntity().ChunkCoords()));
-		if (!CullTest(entity.Bounds(), entity_prog.GetVP() * M)) {
+		if (CullTest(entity.Bounds(), entity_prog.GetVP() * M)) {
+			continue;
+		}
+		if (!lod) {
 			GetLight(entity, light_dir, light_col, ambient_col);
-			entity_prog.SetLightDirection(light_dir);
-			entity_prog.SetLightColor(light_col);
-			entity_prog.SetAmbientColor(ambient_col);
-			entity.Render(M, entity_prog);
+			entity_batch.SetLight(light_dir, light_col, ambient_col);
+			entity.Render(M, entity_batch);
+			continue;
+		}
+		const float dist = glm::length(glm::vec3(M[3]) - camera);
+		if (dist - entity.Radius() > fog_limit) {
+			continue;
+		}
+		const Entity::LightSample &light = CachedLight(entity);
+		entity_batch.SetLight(light.direction, light.color, light.ambient);
+		if (dist < lod_near) {
+			entity.Render(M, entity_batch);
+		} else if (dist < lod_far) {
+			entity.Render(M, entity_batch, dist * lod_part_ratio);
+		} else {
+			entity.RenderMerged(M, entity_batch);
 		}
 	}
+	entity_batch.Draw();
+}
+
+const Entity::LightSample &World::CachedLight(Entity &entity) {
+	Entity::LightSample &light = entity.CachedLight();
+	const glm::ivec3 block(RoughLocation::Fine(entity.Position()));
+	if (!light.valid || light.chunk != entity.ChunkCoords() || light.block != block) {
+		light.chunk = entity.ChunkCoords();
+		light.block = block;
+		// the fallback for missing chunks is used, but not kept
+		light.valid = GetLight(entity, light.direction, light.color, light.ambient);
+	}
+	return light;
 }
 
 // this should interpolate based on the fractional part of entity's block position
-void World::GetLight(
+bool World::GetLight(
 	const Entity &e,
 	glm::vec3 &dir,
 	glm::vec3 &col,
@@ -1086,7 +1143,8 @@ void World::GetLight(
 		// some arbitrary direction
 		dir = glm::vec3(1.0f, 2.0f, 3.0f);
 		col = glm::vec3(0.025f); // ~0.8^15
-		return;
+		amb = col;
+		return false;
 	}
 	glm::ivec3 base(center.GetBlockPos());
 	int base_light = center.GetLight();
@@ -1111,6 +1169,7 @@ void World::GetLight(
 	dir = acc;
 	col = glm::vec3(std::pow(0.8f, 15 - max_light));
 	amb = glm::vec3(std::pow(0.8f, 15 - min_light));
+	return true;
 }
 
 namespace {
@@ -0,0 +1,145 @@
+#include "FixedRateTest.hpp"
+
+#include "app/FixedRate.hpp"
+
+#include <cstdint>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(blank::test::FixedRateTest);
+
+using namespace std;
+
+
+namespace blank {
+namespace test {
+
+namespace {
+
+/// one millisecond in the nanoseconds the schedule runs on
+constexpr int64_t MS = 1000000;
+/// arbitrary start of the synthetic clock
+constexpr int64_t START = 1000 * MS;
+
+}
+
+void FixedRateTest::setUp() {
+}
+
+void FixedRateTest::tearDown() {
+}
+
+
+void FixedRateTest::testOnTime() {
+	FixedRate rate(5, 4, START);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad interval",
+		5, rate.Interval()
+	);
+	for (int i = 1; i <= 4; ++i) {
+		// loop body took 3ms of the 5
+		CPPUNIT_ASSERT_EQUAL_MESSAGE(
+			"more than one step for an idle loop",
+			1, rate.Advance(START + (i - 1) * 5 * MS + 3 * MS)
+		);
+	}
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"step exactly on its due time not on time",
+		1, rate.Advance(START + 25 * MS)
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad step count",
+		uint64_t(5), rate.Steps()
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"step on time counted as overrun",
+		uint64_t(0), rate.Overruns()
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"lateness recorded for steps on time",
+		int64_t(0), rate.MaxLateness()
+	);
+}
+
+void FixedRateTest::testCatchUp() {
+	FixedRate rate(10, 3, START);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"first step not on time",
+		1, rate.Advance(START + 10 * MS)
+	);
+	// second step due at 20ms, entered at 35ms, so the one due at
+	// 30ms has to run as well
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad number of catch up steps",
+		2, rate.Advance(START + 35 * MS)
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"late step not counted as overrun",
+		uint64_t(1), rate.Overruns()
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad lateness",
+		15 * MS, rate.MaxLateness()
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"steps dropped although catching up was possible",
+		uint64_t(0), rate.Dropped()
+	);
+	// caught up, so the old schedule holds and the next one's due at 40ms
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"schedule moved by catching up",
+		1, rate.Advance(START + 40 * MS)
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"step on time counted as overrun",
+		uint64_t(1), rate.Overruns()
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad step count",
+		uint64_t(4), rate.Steps()
+	);
+}
+
+void FixedRateTest::testDrop() {
+	FixedRate rate(10, 3, START);
+	rate.Advance(START + 10 * MS);
+	// step due at 20ms entered at 120ms, ten more became due meanwhile
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"catch up not capped at max steps",
+		3, rate.Advance(START + 120 * MS)
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad number of dropped steps",
+		uint64_t(8), rate.Dropped()
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad lateness",
+		100 * MS, rate.MaxLateness()
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad step count",
+		uint64_t(4), rate.Steps()
+	);
+	// schedule restarts from 120ms, so 130ms is on time, but not 131ms
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"schedule not reset after dropping steps",
+		1, rate.Advance(START + 130 * MS)
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"step after reset counted as overrun",
+		uint64_t(1), rate.Overruns()
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"schedule reset to the wrong time",
+		1, rate.Advance(START + 141 * MS)
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"late step after reset not counted as overrun",
+		uint64_t(2), rate.Overruns()
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"smaller lateness replaced the worst",
+		100 * MS, rate.MaxLateness()
+	);
+}
+
+}
+}
@@ -0,0 +1,34 @@
+#ifndef BLANK_TEST_APP_FIXEDRATETEST_H_
+#define BLANK_TEST_APP_FIXEDRATETEST_H_
+
+#include <cppunit/extensions/HelperMacros.h>
+
+
+namespace blank {
+namespace test {
+
+class FixedRateTest
+: public CppUnit::TestFixture {
+
+CPPUNIT_TEST_SUITE(FixedRateTest);
+
+CPPUNIT_TEST(testOnTime);
+CPPUNIT_TEST(testCatchUp);
+CPPUNIT_TEST(testDrop);
+
+CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp();
+	void tearDown();
+
+	void testOnTime();
+	void testCatchUp();
+	void testDrop();
+
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,111 @@
+#include "ProfilerTest.hpp"
+
+#include "app/Profiler.hpp"
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(blank::test::ProfilerTest);
+
+using namespace std;
+
+
+namespace blank {
+namespace test {
+
+void ProfilerTest::setUp() {
+}
+
+void ProfilerTest::tearDown() {
+	Profiler::Stop();
+}
+
+
+void ProfilerTest::testRecording() {
+	{
+		Profiler::Zone zone("before start");
+	}
+	Profiler::Start();
+	CPPUNIT_ASSERT_MESSAGE(
+		"profiler not recording after start",
+		Profiler::Recording()
+	);
+	{
+		Profiler::Zone outer("outer zone");
+		Profiler::Zone inner("inner zone");
+	}
+	Profiler::Stop();
+	CPPUNIT_ASSERT_MESSAGE(
+		"profiler still recording after stop",
+		!Profiler::Recording()
+	);
+	{
+		Profiler::Zone zone("after stop");
+	}
+
+	stringstream out;
+	Profiler::Write(out);
+	const string trace = out.str();
+	CPPUNIT_ASSERT_MESSAGE(
+		"trace is not a trace event object",
+		trace.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[") == 0
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"outer zone missing from trace",
+		trace.find("\"name\":\"outer zone\",\"ph\":\"X\"") != string::npos
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"inner zone missing from trace",
+		trace.find("\"name\":\"inner zone\",\"ph\":\"X\"") != string::npos
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"zone from before start in trace",
+		trace.find("before start") == string::npos
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"zone from after stop in trace",
+		trace.find("after stop") == string::npos
+	);
+	// inner ends first, so it's written first
+	CPPUNIT_ASSERT_MESSAGE(
+		"zones not in order of completion",
+		trace.find("inner zone") < trace.find("outer zone")
+	);
+}
+
+void ProfilerTest::testThreads() {
+	Profiler::Start();
+	{
+		Profiler::Zone zone("main thread");
+	}
+	thread worker([]() {
+		Profiler::Zone zone("worker thread");
+	});
+	worker.join();
+	Profiler::Stop();
+
+	stringstream out;
+	Profiler::Write(out);
+	const string trace = out.str();
+	const string::size_type main_zone = trace.find("main thread");
+	const string::size_type worker_zone = trace.find("worker thread");
+	CPPUNIT_ASSERT_MESSAGE(
+		"main thread's zone missing from trace",
+		main_zone != string::npos
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"worker thread's zone missing from trace",
+		worker_zone != string::npos
+	);
+	const string::size_type main_tid = trace.find("\"tid\":", main_zone);
+	const string::size_type worker_tid = trace.find("\"tid\":", worker_zone);
+	CPPUNIT_ASSERT_MESSAGE(
+		"zones of different threads have the same tid",
+		trace.substr(main_tid, trace.find(',', main_tid) - main_tid)
+			!= trace.substr(worker_tid, trace.find(',', worker_tid) - worker_tid)
+	);
+}
+
+}
+}
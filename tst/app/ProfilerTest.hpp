@@ -0,0 +1,32 @@
+#ifndef BLANK_TEST_APP_PROFILERTEST_H_
+#define BLANK_TEST_APP_PROFILERTEST_H_
+
+#include <cppunit/extensions/HelperMacros.h>
+
+
+namespace blank {
+namespace test {
+
+class ProfilerTest
+: public CppUnit::TestFixture {
+
+CPPUNIT_TEST_SUITE(ProfilerTest);
+
+CPPUNIT_TEST(testRecording);
+CPPUNIT_TEST(testThreads);
+
+CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp();
+	void tearDown();
+
+	void testRecording();
+	void testThreads();
+
+};
+
+}
+}
+
+#endif
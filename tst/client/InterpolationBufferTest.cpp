@@ -0,0 +1,187 @@
+#include "InterpolationBufferTest.hpp"
+
+#include "client/InterpolationBuffer.hpp"
+#include "geometry/const.hpp"
+
+#include <cmath>
+#include <glm/gtx/io.hpp>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(blank::test::InterpolationBufferTest);
+
+using blank::client::InterpolationBuffer;
+
+
+namespace blank {
+namespace test {
+
+void InterpolationBufferTest::setUp() {
+}
+
+void InterpolationBufferTest::tearDown() {
+}
+
+
+void InterpolationBufferTest::testOrdering() {
+	InterpolationBuffer buffer(100);
+	CPPUNIT_ASSERT_MESSAGE(
+		"fresh buffer not empty",
+		buffer.Empty()
+	);
+
+	EntityState state;
+	CPPUNIT_ASSERT_MESSAGE(
+		"first snapshot rejected",
+		buffer.Push(10, 0, state)
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"newer snapshot rejected",
+		buffer.Push(12, 20, state)
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"out of order snapshot accepted",
+		!buffer.Push(11, 30, state)
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"duplicate snapshot accepted",
+		!buffer.Push(12, 30, state)
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"unexpected number of snapshots",
+		std::size_t(2), buffer.Size()
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"old snapshot accepted",
+		!buffer.Push(0, 40, state)
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"stale snapshot after long silence rejected",
+		buffer.Push(1, 2000, state)
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"buffer not reset after long silence",
+		std::size_t(1), buffer.Size()
+	);
+
+	buffer.Clear();
+	CPPUNIT_ASSERT_MESSAGE(
+		"cleared buffer not empty",
+		buffer.Empty()
+	);
+}
+
+void InterpolationBufferTest::testSequenceWrap() {
+	InterpolationBuffer buffer(100);
+	EntityState state;
+	state.velocity = glm::vec3(0.0f);
+
+	state.pos = ExactLocation(glm::ivec3(0), glm::vec3(1.0f, 0.0f, 0.0f));
+	CPPUNIT_ASSERT_MESSAGE(
+		"snapshot before sequence wrap rejected",
+		buffer.Push(65534, 0, state)
+	);
+	state.pos = ExactLocation(glm::ivec3(0), glm::vec3(2.0f, 0.0f, 0.0f));
+	CPPUNIT_ASSERT_MESSAGE(
+		"snapshot at end of sequence rejected",
+		buffer.Push(65535, 20, state)
+	);
+	state.pos = ExactLocation(glm::ivec3(0), glm::vec3(3.0f, 0.0f, 0.0f));
+	CPPUNIT_ASSERT_MESSAGE(
+		"snapshot after sequence wrap rejected",
+		buffer.Push(0, 40, state)
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"unexpected number of snapshots",
+		std::size_t(3), buffer.Size()
+	);
+	AssertEqual(
+		"snapshot after sequence wrap not ordered after end of sequence",
+		glm::vec3(2.5f, 0.0f, 0.0f), buffer.Get(30).pos.Absolute()
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"snapshot from before sequence wrap accepted after it",
+		!buffer.Push(65535, 60, state)
+	);
+}
+
+void InterpolationBufferTest::testInterpolation() {
+	InterpolationBuffer buffer(100);
+	EntityState a;
+	a.pos = ExactLocation(glm::ivec3(0), glm::vec3(14.0f, 0.0f, 0.0f));
+	a.velocity = glm::vec3(0.0f);
+	EntityState b;
+	b.pos = ExactLocation(glm::ivec3(1, 0, 0), glm::vec3(2.0f, 0.0f, 0.0f));
+	b.velocity = glm::vec3(4.0f, 0.0f, 0.0f);
+	buffer.Push(1, 0, a);
+	buffer.Push(2, 100, b);
+
+	EntityState result(buffer.Get(-50));
+	AssertEqual(
+		"sampling before first snapshot should yield first snapshot",
+		glm::vec3(14.0f, 0.0f, 0.0f), result.pos.Absolute()
+	);
+
+	result = buffer.Get(50);
+	AssertEqual(
+		"bad interpolated position",
+		glm::vec3(16.0f, 0.0f, 0.0f), result.pos.Absolute()
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"interpolated position not sanitized",
+		glm::ivec3(1, 0, 0), result.pos.chunk
+	);
+	AssertEqual(
+		"bad interpolated velocity",
+		glm::vec3(2.0f, 0.0f, 0.0f), result.velocity
+	);
+}
+
+void InterpolationBufferTest::testExtrapolation() {
+	InterpolationBuffer buffer(100, 250);
+	EntityState state;
+	state.velocity = glm::vec3(0.0f, 0.0f, 2.0f);
+	buffer.Push(1, 0, state);
+
+	AssertEqual(
+		"bad extrapolated position",
+		glm::vec3(0.0f, 0.0f, 0.2f), buffer.Get(100).pos.Absolute()
+	);
+	AssertEqual(
+		"extrapolation not limited",
+		glm::vec3(0.0f, 0.0f, 0.5f), buffer.Get(1000).pos.Absolute()
+	);
+}
+
+void InterpolationBufferTest::testYawWrap() {
+	EntityState a;
+	a.yaw = PI - 0.1f;
+	EntityState b;
+	b.yaw = -PI + 0.1f;
+	EntityState result(InterpolationBuffer::Interpolate(a, b, 0.5f));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE(
+		"yaw interpolation should take the short way around",
+		PI, std::abs(result.yaw), 0.001f
+	);
+}
+
+
+void InterpolationBufferTest::AssertEqual(
+	const std::string &msg,
+	const glm::vec3 &expected,
+	const glm::vec3 &actual
+) {
+	CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE(
+		msg + " (X component)",
+		expected.x, actual.x, 0.001f
+	);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE(
+		msg + " (Y component)",
+		expected.y, actual.y, 0.001f
+	);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE(
+		msg + " (Z component)",
+		expected.z, actual.z, 0.001f
+	);
+}
+
+}
+}
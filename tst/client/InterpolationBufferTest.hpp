@@ -0,0 +1,47 @@
+#ifndef BLANK_TEST_CLIENT_INTERPOLATIONBUFFERTEST_HPP_
+#define BLANK_TEST_CLIENT_INTERPOLATIONBUFFERTEST_HPP_
+
+#include "graphics/glm.hpp"
+
+#include <string>
+#include <cppunit/extensions/HelperMacros.h>
+
+
+namespace blank {
+namespace test {
+
+class InterpolationBufferTest
+: public CppUnit::TestFixture {
+
+CPPUNIT_TEST_SUITE(InterpolationBufferTest);
+
+CPPUNIT_TEST(testOrdering);
+CPPUNIT_TEST(testSequenceWrap);
+CPPUNIT_TEST(testInterpolation);
+CPPUNIT_TEST(testExtrapolation);
+CPPUNIT_TEST(testYawWrap);
+
+CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp();
+	void tearDown();
+
+	void testOrdering();
+	void testSequenceWrap();
+	void testInterpolation();
+	void testExtrapolation();
+	void testYawWrap();
+
+private:
+	static void AssertEqual(
+		const std::string &msg,
+		const glm::vec3 &expected,
+		const glm::vec3 &actual);
+
+};
+
+}
+}
+
+#endif
@@ -266,5 +266,72 @@ void IntersectionTest::testBoxBoxIntersection() {
 	);
 }
 
+void IntersectionTest::testFrustumCulling() {
+	// 20x20x20 cube around the origin
+	Frustum frustum(glm::transpose(glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, -10.0f, 10.0f)));
+	const glm::vec3 size(2.0f);
+
+	AABB box{ { 0, 0, 0 }, { 2, 2, 2 } };
+	CPPUNIT_ASSERT_MESSAGE(
+		"box inside frustum culled",
+		!CullTest(box, frustum)
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"box inside frustum not contained",
+		ContainTest(box, frustum)
+	);
+	box = AABB{ { 9, 0, 0 }, { 11, 2, 2 } };
+	CPPUNIT_ASSERT_MESSAGE(
+		"box crossing frustum culled",
+		!CullTest(box, frustum)
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"box crossing frustum contained",
+		!ContainTest(box, frustum)
+	);
+	box = AABB{ { 20, 0, 0 }, { 22, 2, 2 } };
+	CPPUNIT_ASSERT_MESSAGE(
+		"box outside frustum not culled",
+		CullTest(box, frustum)
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"box outside frustum contained",
+		!ContainTest(box, frustum)
+	);
+
+	// more than four so both the batched and the remainder path run
+	const float x[] = {   0,   9,  20, -30,  -5, -11, -13 };
+	const float y[] = {   0,   0,   0, -30,  -5,   0,   0 };
+	const float z[] = {   0,   0,   0, -30,   8,   0,   0 };
+	const std::size_t count = sizeof(x) / sizeof(x[0]);
+	std::size_t visible[count];
+	std::size_t num_visible = CullBatch(size, x, y, z, count, frustum, visible);
+
+	std::size_t expected = 0;
+	for (std::size_t i = 0; i < count; ++i) {
+		box = AABB{ { x[i], y[i], z[i] }, { x[i] + size.x, y[i] + size.y, z[i] + size.z } };
+		if (CullTest(box, frustum)) {
+			continue;
+		}
+		CPPUNIT_ASSERT_MESSAGE(
+			"batch culled more boxes than single test",
+			expected < num_visible
+		);
+		CPPUNIT_ASSERT_EQUAL_MESSAGE(
+			"batch and single test disagree",
+			i, visible[expected]
+		);
+		++expected;
+	}
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"batch culled fewer boxes than single test",
+		expected, num_visible
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"unexpected number of visible boxes",
+		std::size_t(4), num_visible
+	);
+}
+
 }
 }
@@ -15,6 +15,7 @@ CPPUNIT_TEST_SUITE(IntersectionTest);
 CPPUNIT_TEST(testSimpleRayBoxIntersection);
 CPPUNIT_TEST(testRayBoxIntersection);
 CPPUNIT_TEST(testBoxBoxIntersection);
+CPPUNIT_TEST(testFrustumCulling);
 
 CPPUNIT_TEST_SUITE_END();
 
@@ -25,6 +26,7 @@ public:
 	void testSimpleRayBoxIntersection();
 	void testRayBoxIntersection();
 	void testBoxBoxIntersection();
+	void testFrustumCulling();
 
 };
 
@@ -0,0 +1,94 @@
+#include "ArenaAllocatorTest.hpp"
+
+#include "graphics/ArenaAllocator.hpp"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(blank::test::ArenaAllocatorTest);
+
+
+namespace blank {
+namespace test {
+
+void ArenaAllocatorTest::setUp() {
+
+}
+
+void ArenaAllocatorTest::tearDown() {
+
+}
+
+
+void ArenaAllocatorTest::testAllocate() {
+	ArenaAllocator alloc(64);
+
+	ArenaAllocator::Range empty = alloc.Allocate(0);
+	CPPUNIT_ASSERT_MESSAGE(
+		"allocating nothing should yield an empty range",
+		empty.Empty()
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"allocating nothing should not use up space",
+		std::size_t(0), alloc.Top()
+	);
+
+	ArenaAllocator::Range small = alloc.Allocate(10);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"small allocation should be rounded up to minimum size",
+		std::size_t(64), small.size
+	);
+	ArenaAllocator::Range big = alloc.Allocate(65);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"allocation should be rounded up to next power of two class",
+		std::size_t(128), big.size
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"ranges overlap",
+		small.offset + small.size <= big.offset || big.offset + big.size <= small.offset
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"top should be at end of highest range",
+		std::size_t(192), alloc.Top()
+	);
+}
+
+void ArenaAllocatorTest::testReuse() {
+	ArenaAllocator alloc(64);
+
+	ArenaAllocator::Range first = alloc.Allocate(100);
+	ArenaAllocator::Range second = alloc.Allocate(100);
+	const std::size_t offset = first.offset;
+	alloc.Free(first);
+	CPPUNIT_ASSERT_MESSAGE(
+		"freed range should be cleared",
+		first.Empty()
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"freed range should be idle",
+		std::size_t(128), alloc.Idle()
+	);
+
+	ArenaAllocator::Range other_class = alloc.Allocate(10);
+	CPPUNIT_ASSERT_MESSAGE(
+		"range should not be reused for a different size class",
+		other_class.offset != offset
+	);
+
+	ArenaAllocator::Range reused = alloc.Allocate(120);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"freed range should be reused for the same size class",
+		offset, reused.offset
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"reuse should not grow the arena",
+		std::size_t(320), alloc.Top()
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"nothing should be idle after reuse",
+		std::size_t(0), alloc.Idle()
+	);
+	alloc.Free(second);
+	alloc.Free(reused);
+	alloc.Free(other_class);
+}
+
+}
+}
@@ -0,0 +1,31 @@
+#ifndef BLANK_TEST_GRAPHICS_ARENAALLOCATORTEST_HPP_
+#define BLANK_TEST_GRAPHICS_ARENAALLOCATORTEST_HPP_
+
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace blank {
+namespace test {
+
+class ArenaAllocatorTest
+: public CppUnit::TestFixture {
+
+CPPUNIT_TEST_SUITE(ArenaAllocatorTest);
+
+CPPUNIT_TEST(testAllocate);
+CPPUNIT_TEST(testReuse);
+
+CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp();
+	void tearDown();
+
+	void testAllocate();
+	void testReuse();
+
+};
+
+}
+}
+
+#endif
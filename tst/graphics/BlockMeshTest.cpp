@@ -0,0 +1,89 @@
+#include "BlockMeshTest.hpp"
+
+#include "graphics/BlockMesh.hpp"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(blank::test::BlockMeshTest);
+
+
+namespace blank {
+namespace test {
+
+void BlockMeshTest::setUp() {
+
+}
+
+void BlockMeshTest::tearDown() {
+
+}
+
+
+void BlockMeshTest::testPack() {
+	const BlockMesh::Vertex vtx = BlockMesh::Pack(
+		BlockMesh::Position(0.0f, 0.5f, 16.0f),
+		BlockMesh::TexCoord(0.25f, 1.0f, 3.0f),
+		BlockMesh::ColorMod(0, 255, 255),
+		BlockMesh::ColorMod(255, 128, 0),
+		15.0f
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad packed position x",
+		(unsigned short)(8 * 2048), vtx.position.x
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad packed position y",
+		(unsigned short)(8.5 * 2048), vtx.position.y
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad packed position z",
+		(unsigned short)(24 * 2048), vtx.position.z
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad packed tex coord u",
+		(unsigned short)(1024), vtx.tex_coord.x
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad packed tex coord v",
+		(unsigned short)(4096), vtx.tex_coord.y
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"texture layer should be packed as is",
+		(unsigned short)(3), vtx.tex_coord.z
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad packed light",
+		(unsigned char)(240), vtx.light
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"rgb mod should be packed as is",
+		(unsigned char)(128), vtx.rgb_mod.y
+	);
+}
+
+void BlockMeshTest::testClamp() {
+	const BlockMesh::Vertex vtx = BlockMesh::Pack(
+		BlockMesh::Position(-100.0f, 100.0f, -8.0f),
+		BlockMesh::TexCoord(0.0f),
+		BlockMesh::ColorMod(0, 255, 255),
+		BlockMesh::ColorMod(255, 255, 255),
+		100.0f
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"position below range should be clamped",
+		(unsigned short)(0), vtx.position.x
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"position above range should be clamped",
+		(unsigned short)(65535), vtx.position.y
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"lower end of range should be packed as zero",
+		(unsigned short)(0), vtx.position.z
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"light above range should be clamped",
+		(unsigned char)(255), vtx.light
+	);
+}
+
+}
+}
@@ -0,0 +1,31 @@
+#ifndef BLANK_TEST_GRAPHICS_BLOCKMESHTEST_HPP_
+#define BLANK_TEST_GRAPHICS_BLOCKMESHTEST_HPP_
+
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace blank {
+namespace test {
+
+class BlockMeshTest
+: public CppUnit::TestFixture {
+
+CPPUNIT_TEST_SUITE(BlockMeshTest);
+
+CPPUNIT_TEST(testPack);
+CPPUNIT_TEST(testClamp);
+
+CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp();
+	void tearDown();
+
+	void testPack();
+	void testClamp();
+
+};
+
+}
+}
+
+#endif
@@ -31,5 +31,23 @@ void ServerTest::testStartup() {
 	// setUp and testDown do all the tests
 }
 
+void ServerTest::testMetrics() {
+	instance->SendCommand("metrics");
+	instance->WaitCommandMessage("# TYPE blank_tick_seconds histogram");
+	instance->WaitCommandMessage("blank_clients 0");
+	instance->WaitCommandMessage("# EOF");
+}
+
+void ServerTest::testBatch() {
+	instance->SendCommand("batch");
+	instance->SendCommand("fill 0 0 0 1 1 1 air");
+	instance->SendCommand("nope");
+	instance->SendCommand("fill 0 0 0 1000 1000 1000 air");
+	instance->SendCommand("end");
+	instance->WaitCommandMessage("filled 8 blocks with air");
+	instance->WaitCommandError("line 2: nope: command not found");
+	instance->WaitCommandError("line 3: box too large, at most 262144 blocks per fill");
+}
+
 }
 }
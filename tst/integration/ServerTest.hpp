@@ -16,6 +16,8 @@ class ServerTest
 CPPUNIT_TEST_SUITE(ServerTest);
 
 CPPUNIT_TEST(testStartup);
+CPPUNIT_TEST(testMetrics);
+CPPUNIT_TEST(testBatch);
 
 CPPUNIT_TEST_SUITE_END();
 
@@ -24,6 +26,8 @@ public:
 	void tearDown();
 
 	void testStartup();
+	void testMetrics();
+	void testBatch();
 
 private:
 	std::unique_ptr<TestInstance> instance;
@@ -246,6 +246,13 @@ void TestInstance::AssertExitStatus(int expected) {
 }
 
 
+void TestInstance::SendCommand(const string &line) {
+	const string data(line + '\n');
+	for (size_t sent = 0; sent < data.size();) {
+		sent += conn.Send(data.data() + sent, data.size() - sent);
+	}
+}
+
 void TestInstance::WaitCommandMessage(const string &line) {
 	WaitCommandLine(" > " + line);
 }
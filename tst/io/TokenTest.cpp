@@ -173,6 +173,79 @@ void TokenTest::testTokenizerBrokenComment() {
 	}
 }
 
+void TokenTest::testTokenizerCompiled() {
+	stringstream source;
+	source << "foo = { 1, \"two\" }; // comment\n/* another */ bar:-3.5;";
+	stringstream compiled;
+	Tokenizer::Compile(source, compiled);
+	const string data(compiled.str());
+	Tokenizer in(data.data(), data.size());
+
+	AssertHasMore(in);
+	AssertToken(Token::IDENTIFIER, "foo", in.Next());
+	AssertHasMore(in);
+	AssertToken(Token::EQUALS, in.Next());
+	AssertHasMore(in);
+	AssertToken(Token::ANGLE_BRACKET_OPEN, in.Next());
+	AssertHasMore(in);
+	AssertToken(Token::NUMBER, "1", in.Next());
+	AssertHasMore(in);
+	AssertToken(Token::COMMA, in.Next());
+	AssertHasMore(in);
+	AssertToken(Token::STRING, "two", in.Next());
+	AssertHasMore(in);
+	AssertToken(Token::ANGLE_BRACKET_CLOSE, in.Next());
+	AssertHasMore(in);
+	AssertToken(Token::SEMICOLON, in.Next());
+	AssertHasMore(in);
+	AssertToken(Token::IDENTIFIER, "bar", in.Next());
+	AssertHasMore(in);
+	AssertToken(Token::COLON, in.Next());
+	AssertHasMore(in);
+	AssertToken(Token::NUMBER, "-3.5", in.Next());
+	AssertHasMore(in);
+	AssertToken(Token::SEMICOLON, in.Next());
+	CPPUNIT_ASSERT_MESSAGE("expected end of compiled tokens", !in.HasMore());
+	CPPUNIT_ASSERT_THROW_MESSAGE(
+		"extracting token after end of compiled tokens",
+		in.Next(), std::runtime_error);
+
+	Tokenizer truncated(data.data(), data.size() - 1);
+	for (int i = 0; i < 11; ++i) {
+		truncated.Next();
+	}
+	CPPUNIT_ASSERT_THROW_MESSAGE(
+		"truncated compiled tokens should throw",
+		truncated.Next(), std::runtime_error);
+}
+
+void TokenTest::testTokenizerText() {
+	const string text(
+		"[{0},<.5>+3=/**\n * test\n */ (-1.5); foo_bar.baz:"
+		"\"hello\\r\\n\\t\\\"world\\\"\" ] // this line\n#that line\n  "
+	);
+	stringstream stream(text);
+	Tokenizer expected(stream);
+	Tokenizer in(text.data(), text.data() + text.size());
+
+	while (expected.HasMore()) {
+		AssertHasMore(in);
+		const Token &token = expected.Next();
+		AssertToken(token.type, token.value, in.Next());
+	}
+	CPPUNIT_ASSERT_MESSAGE("expected end of text", !in.HasMore());
+	CPPUNIT_ASSERT_THROW_MESSAGE(
+		"extracting token after end of text",
+		in.Next(), std::runtime_error);
+
+	const string broken("/* just one more thing…*");
+	Tokenizer broken_in(broken.data(), broken.data() + broken.size());
+	AssertHasMore(broken_in);
+	CPPUNIT_ASSERT_THROW_MESSAGE(
+		"half-closed comment should throw",
+		broken_in.Next(), std::runtime_error);
+}
+
 
 namespace {
 
@@ -21,6 +21,8 @@ CPPUNIT_TEST(testTypeIO);
 CPPUNIT_TEST(testTokenIO);
 CPPUNIT_TEST(testTokenizer);
 CPPUNIT_TEST(testTokenizerBrokenComment);
+CPPUNIT_TEST(testTokenizerCompiled);
+CPPUNIT_TEST(testTokenizerText);
 CPPUNIT_TEST(testReader);
 CPPUNIT_TEST(testReaderEmpty);
 CPPUNIT_TEST(testReaderMalformed);
@@ -35,6 +37,8 @@ public:
 	void testTokenIO();
 	void testTokenizer();
 	void testTokenizerBrokenComment();
+	void testTokenizerCompiled();
+	void testTokenizerText();
 
 	void testReader();
 	void testReaderEmpty();
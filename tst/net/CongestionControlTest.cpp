@@ -0,0 +1,118 @@
+#include "CongestionControlTest.hpp"
+
+#include "net/CongestionControl.hpp"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(blank::test::CongestionControlTest);
+
+
+namespace blank {
+namespace test {
+
+void CongestionControlTest::setUp() {
+	udp_pack.channel = -1;
+	udp_pack.data = data;
+	udp_pack.len = sizeof(data);
+	udp_pack.maxlen = sizeof(data);
+}
+
+void CongestionControlTest::tearDown() {
+}
+
+
+void CongestionControlTest::testBudget() {
+	CongestionControl cc;
+	CPPUNIT_ASSERT_MESSAGE(
+		"fresh connection has no budget for updates",
+		cc.Budget(CongestionControl::UPDATE) > 0
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"bulk traffic not ranked below updates",
+		cc.Budget(CongestionControl::BULK) < cc.Budget(CongestionControl::UPDATE)
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"urgent traffic not ranked above updates",
+		cc.Budget(CongestionControl::URGENT) > cc.Budget(CongestionControl::UPDATE)
+	);
+
+	while (cc.Budget(CongestionControl::UPDATE) > 0) {
+		cc.PacketOut(udp_pack);
+	}
+	CPPUNIT_ASSERT_MESSAGE(
+		"bulk traffic has budget left after updates are exhausted",
+		cc.Budget(CongestionControl::BULK) <= 0
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"urgent traffic has no budget left after updates are exhausted",
+		cc.Budget(CongestionControl::URGENT) > 0
+	);
+
+	cc.Refill(1000);
+	CPPUNIT_ASSERT_MESSAGE(
+		"refill did not restore budget",
+		cc.Budget(CongestionControl::UPDATE) > 0
+	);
+	cc.Refill(100000);
+	CPPUNIT_ASSERT_MESSAGE(
+		"budget keeps accumulating on an idle connection",
+		cc.Budget(CongestionControl::UPDATE) < cc.SendRate()
+	);
+}
+
+void CongestionControlTest::testIncrease() {
+	CongestionControl cc;
+	Uint32 now = SDL_GetTicks();
+	float rate = cc.SendRate();
+
+	// use up one second worth of sending at current rate
+	for (float sent = 0.0f; sent < rate; sent += udp_pack.len) {
+		cc.PacketOut(udp_pack);
+	}
+	cc.PacketReceived(1, now + 1000);
+	CPPUNIT_ASSERT_MESSAGE(
+		"rate did not increase on a busy connection",
+		cc.SendRate() > rate
+	);
+
+	rate = cc.SendRate();
+	cc.PacketReceived(3, now + 2000);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"rate increased on an idle connection",
+		rate, cc.SendRate()
+	);
+}
+
+void CongestionControlTest::testDecrease() {
+	CongestionControl cc;
+	Uint32 now = SDL_GetTicks();
+	float rate = cc.SendRate();
+
+	cc.PacketLost(1, now + 1000);
+	CPPUNIT_ASSERT_MESSAGE(
+		"rate did not decrease on packet loss",
+		cc.SendRate() < rate
+	);
+
+	rate = cc.SendRate();
+	cc.PacketLost(3, now + 1001);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"rate decreased twice within one round trip",
+		rate, cc.SendRate()
+	);
+
+	for (int i = 0; i < 100; ++i) {
+		cc.PacketLost(5 + 2 * i, now + 2000 + 1000 * i);
+	}
+	CPPUNIT_ASSERT_MESSAGE(
+		"rate dropped to zero",
+		cc.SendRate() > 0.0f
+	);
+	rate = cc.SendRate();
+	cc.PacketLost(333, now + 200000);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"rate has no lower bound",
+		rate, cc.SendRate()
+	);
+}
+
+}
+}
@@ -0,0 +1,39 @@
+#ifndef BLANK_TEST_NET_CONGESTIONCONTROLTEST_HPP_
+#define BLANK_TEST_NET_CONGESTIONCONTROLTEST_HPP_
+
+#include <SDL_net.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+
+namespace blank {
+namespace test {
+
+class CongestionControlTest
+: public CppUnit::TestFixture {
+
+CPPUNIT_TEST_SUITE(CongestionControlTest);
+
+CPPUNIT_TEST(testBudget);
+CPPUNIT_TEST(testIncrease);
+CPPUNIT_TEST(testDecrease);
+
+CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp();
+	void tearDown();
+
+	void testBudget();
+	void testIncrease();
+	void testDecrease();
+
+private:
+	Uint8 data[512];
+	UDPpacket udp_pack;
+
+};
+
+}
+}
+
+#endif
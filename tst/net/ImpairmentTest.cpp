@@ -0,0 +1,450 @@
+#include "ImpairmentTest.hpp"
+
+#include "net/DelayLine.hpp"
+#include "net/udp.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(blank::test::ImpairmentTest);
+
+using blank::udp::DelayLine;
+using blank::udp::Impairment;
+
+
+namespace blank {
+namespace test {
+
+namespace {
+
+constexpr std::size_t PACKET_SIZE = 256;
+constexpr std::uint64_t SEED = 0x0123456789ABCDEF;
+/// fake clock's value when the first packet goes in
+constexpr Uint32 START = 1000;
+
+struct Delivery {
+	std::uint32_t index;
+	/// time the packet was pushed
+	Uint32 sent;
+	/// time the packet came out
+	Uint32 received;
+};
+
+/// push count packets into a delay line, one per millisecond of a
+/// fake clock, and pop everything that comes out until it's empty
+std::vector<Delivery> Run(const Impairment &imp, std::uint32_t count, std::uint64_t seed = SEED) {
+	DelayLine line(imp, PACKET_SIZE, seed);
+	std::vector<Uint8> buf(PACKET_SIZE, 0);
+	UDPpacket pack;
+	pack.channel = -1;
+	pack.data = buf.data();
+	pack.len = sizeof(std::uint32_t);
+	pack.maxlen = PACKET_SIZE;
+	pack.status = 0;
+	pack.address.host = 0x0100007F;
+	pack.address.port = 0x3A30;
+
+	std::vector<Delivery> result;
+	for (Uint32 now = START; now < START + count || line.NextDue(now) >= 0; ++now) {
+		if (now < START + count) {
+			const std::uint32_t index = now - START;
+			std::memcpy(buf.data(), &index, sizeof(index));
+			line.Push(pack, now);
+		}
+		for (const UDPpacket *out = line.Pop(now); out; out = line.Pop(now)) {
+			CPPUNIT_ASSERT_EQUAL_MESSAGE(
+				"packet length changed on the way",
+				int(sizeof(std::uint32_t)), out->len
+			);
+			CPPUNIT_ASSERT_MESSAGE(
+				"packet address changed on the way",
+				out->address.host == pack.address.host && out->address.port == pack.address.port
+			);
+			Delivery d;
+			std::memcpy(&d.index, out->data, sizeof(d.index));
+			d.sent = START + d.index;
+			d.received = now;
+			result.push_back(d);
+		}
+	}
+	return result;
+}
+
+/// number of deliveries that arrived after a packet sent later than them
+std::size_t CountLate(const std::vector<Delivery> &deliveries) {
+	std::size_t late = 0;
+	std::uint32_t newest = 0;
+	for (const Delivery &d : deliveries) {
+		if (d.index < newest) {
+			++late;
+		}
+		newest = std::max(newest, d.index);
+	}
+	return late;
+}
+
+}
+
+void ImpairmentTest::setUp() {
+}
+
+void ImpairmentTest::tearDown() {
+}
+
+
+void ImpairmentTest::testNone() {
+	CPPUNIT_ASSERT_MESSAGE(
+		"default impairment enabled",
+		!Impairment().Enabled()
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"empty spec enabled impairment",
+		!Impairment::Parse("").Enabled()
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"none profile enabled impairment",
+		!Impairment::Parse("none").Enabled()
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"none after a profile didn't reset it",
+		!Impairment::Parse("awful,none").Enabled()
+	);
+}
+
+void ImpairmentTest::testProfile() {
+	Impairment imp = Impairment::Parse("mobile");
+	CPPUNIT_ASSERT_MESSAGE(
+		"mobile profile not enabled",
+		imp.Enabled()
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"mobile profile without loss",
+		imp.loss > 0.0f
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"mobile profile without latency",
+		imp.latency > 0
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"mobile profile without bandwidth cap",
+		imp.bandwidth > 0
+	);
+}
+
+void ImpairmentTest::testOverride() {
+	Impairment imp = Impairment::Parse("loss=5,duplicate=1,reorder=2.5,latency=40,jitter=10,bandwidth=8192");
+	CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE(
+		"bad loss",
+		0.05f, imp.loss, 0.0001f
+	);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE(
+		"bad duplicate",
+		0.01f, imp.duplicate, 0.0001f
+	);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE(
+		"bad reorder",
+		0.025f, imp.reorder, 0.0001f
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad latency",
+		40, imp.latency
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad jitter",
+		10, imp.jitter
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad bandwidth",
+		8192, imp.bandwidth
+	);
+
+	imp = Impairment::Parse("awful,loss=0,bandwidth=0");
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"loss not overridden",
+		0.0f, imp.loss
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bandwidth not overridden",
+		0, imp.bandwidth
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"override cleared rest of profile",
+		imp.latency > 0
+	);
+}
+
+void ImpairmentTest::testErrors() {
+	CPPUNIT_ASSERT_THROW_MESSAGE(
+		"unknown profile accepted",
+		Impairment::Parse("carrier-pigeon"),
+		std::runtime_error
+	);
+	CPPUNIT_ASSERT_THROW_MESSAGE(
+		"unknown key accepted",
+		Impairment::Parse("latency=10,smoke=1"),
+		std::runtime_error
+	);
+	CPPUNIT_ASSERT_THROW_MESSAGE(
+		"non-numeric value accepted",
+		Impairment::Parse("latency=soon"),
+		std::runtime_error
+	);
+	CPPUNIT_ASSERT_THROW_MESSAGE(
+		"loss over 100% accepted",
+		Impairment::Parse("loss=150"),
+		std::runtime_error
+	);
+	CPPUNIT_ASSERT_THROW_MESSAGE(
+		"negative latency accepted",
+		Impairment::Parse("latency=-5"),
+		std::runtime_error
+	);
+}
+
+void ImpairmentTest::testPassThrough() {
+	std::vector<Delivery> out(Run(Impairment(), 100));
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"unimpaired line lost or duplicated packets",
+		std::size_t(100), out.size()
+	);
+	for (std::size_t i = 0; i < out.size(); ++i) {
+		CPPUNIT_ASSERT_EQUAL_MESSAGE(
+			"unimpaired line reordered packets",
+			std::uint32_t(i), out[i].index
+		);
+		CPPUNIT_ASSERT_EQUAL_MESSAGE(
+			"unimpaired line delayed a packet",
+			out[i].sent, out[i].received
+		);
+	}
+}
+
+void ImpairmentTest::testLatency() {
+	Impairment imp;
+	imp.latency = 50;
+
+	DelayLine line(imp, PACKET_SIZE, SEED);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"empty line has something due",
+		-1, line.NextDue(START)
+	);
+	Uint8 data[4] = { 1, 2, 3, 4 };
+	UDPpacket pack;
+	pack.channel = -1;
+	pack.data = data;
+	pack.len = sizeof(data);
+	pack.maxlen = sizeof(data);
+	pack.status = 0;
+	pack.address.host = 0;
+	pack.address.port = 0;
+	line.Push(pack, START);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad time until packet is due",
+		50, line.NextDue(START)
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad time until packet is due",
+		1, line.NextDue(START + 49)
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"packet released before latency passed",
+		!line.Pop(START + 49)
+	);
+	const UDPpacket *out = line.Pop(START + 50);
+	CPPUNIT_ASSERT_MESSAGE(
+		"packet not released after latency passed",
+		out
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"packet contents changed on the way",
+		out->len == 4 && std::memcmp(out->data, data, 4) == 0
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"packet released twice",
+		!line.Pop(START + 50)
+	);
+
+	for (const Delivery &d : Run(imp, 100)) {
+		CPPUNIT_ASSERT_EQUAL_MESSAGE(
+			"packet not released exactly after latency",
+			d.sent + 50, d.received
+		);
+	}
+}
+
+void ImpairmentTest::testJitter() {
+	Impairment imp;
+	imp.latency = 20;
+	imp.jitter = 10;
+	std::vector<Delivery> out(Run(imp, 1000));
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"jitter lost or duplicated packets",
+		std::size_t(1000), out.size()
+	);
+	Uint32 min_delay = 1000;
+	Uint32 max_delay = 0;
+	for (std::size_t i = 0; i < out.size(); ++i) {
+		CPPUNIT_ASSERT_EQUAL_MESSAGE(
+			"jitter reordered packets",
+			std::uint32_t(i), out[i].index
+		);
+		const Uint32 delay = out[i].received - out[i].sent;
+		CPPUNIT_ASSERT_MESSAGE(
+			"packet released before latency passed",
+			delay >= 20
+		);
+		CPPUNIT_ASSERT_MESSAGE(
+			"packet held back longer than latency plus jitter",
+			delay <= 30
+		);
+		min_delay = std::min(min_delay, delay);
+		max_delay = std::max(max_delay, delay);
+	}
+	CPPUNIT_ASSERT_MESSAGE(
+		"jitter didn't vary the delay",
+		min_delay < max_delay
+	);
+}
+
+void ImpairmentTest::testLoss() {
+	Impairment imp;
+	imp.loss = 0.1f;
+	std::vector<Delivery> out(Run(imp, 10000));
+	CPPUNIT_ASSERT_MESSAGE(
+		"loss far off from 10%",
+		out.size() >= 8800 && out.size() <= 9200
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"loss reordered packets",
+		std::size_t(0), CountLate(out)
+	);
+	for (std::size_t i = 1; i < out.size(); ++i) {
+		CPPUNIT_ASSERT_MESSAGE(
+			"loss duplicated packets",
+			out[i - 1].index != out[i].index
+		);
+	}
+}
+
+void ImpairmentTest::testDuplicate() {
+	Impairment imp;
+	imp.duplicate = 0.05f;
+	std::vector<Delivery> out(Run(imp, 10000));
+	CPPUNIT_ASSERT_MESSAGE(
+		"duplicates far off from 5%",
+		out.size() >= 10400 && out.size() <= 10600
+	);
+	std::vector<int> seen(10000, 0);
+	for (const Delivery &d : out) {
+		++seen[d.index];
+	}
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"duplicate lost packets",
+		std::ptrdiff_t(0), std::count(seen.begin(), seen.end(), 0)
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"packet delivered more than twice",
+		std::ptrdiff_t(0), std::count_if(seen.begin(), seen.end(), [](int n) { return n > 2; })
+	);
+}
+
+void ImpairmentTest::testReorder() {
+	Impairment imp;
+	imp.reorder = 0.05f;
+	imp.latency = 10;
+	std::vector<Delivery> out(Run(imp, 10000));
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"reorder lost or duplicated packets",
+		std::size_t(10000), out.size()
+	);
+	const std::size_t late = CountLate(out);
+	CPPUNIT_ASSERT_MESSAGE(
+		"reordered packets far off from 5%",
+		late >= 400 && late <= 600
+	);
+	for (const Delivery &d : out) {
+		const Uint32 delay = d.received - d.sent;
+		CPPUNIT_ASSERT_MESSAGE(
+			"packet released before latency passed",
+			delay >= 10
+		);
+		CPPUNIT_ASSERT_MESSAGE(
+			"reordered packet held back too long",
+			delay <= 40
+		);
+	}
+}
+
+void ImpairmentTest::testBandwidth() {
+	Impairment imp;
+	imp.bandwidth = 1000;
+	DelayLine line(imp, PACKET_SIZE, SEED);
+	std::vector<Uint8> data(100, 0);
+	UDPpacket pack;
+	pack.channel = -1;
+	pack.data = data.data();
+	pack.len = data.size();
+	pack.maxlen = data.size();
+	pack.status = 0;
+	pack.address.host = 0;
+	pack.address.port = 0;
+	// 100 bytes at 1000 bytes/s take 100ms each, the line takes up to
+	// half a second worth of backlog and drops the rest
+	for (int i = 0; i < 10; ++i) {
+		line.Push(pack, START);
+	}
+	std::vector<Uint32> received;
+	for (Uint32 now = START; line.NextDue(now) >= 0; ++now) {
+		while (line.Pop(now)) {
+			received.push_back(now);
+		}
+	}
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad number of packets passing the backlog limit",
+		std::size_t(6), received.size()
+	);
+	for (std::size_t i = 0; i < received.size(); ++i) {
+		CPPUNIT_ASSERT_EQUAL_MESSAGE(
+			"packet not released after its transmission time",
+			START + Uint32(i + 1) * 100, received[i]
+		);
+	}
+
+	// after the link drained, packets go through at the capped rate again
+	line.Push(pack, START + 1000);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"drained link still delaying",
+		100, line.NextDue(START + 1000)
+	);
+}
+
+void ImpairmentTest::testSeed() {
+	Impairment imp = Impairment::Parse("awful,bandwidth=0");
+	std::vector<Delivery> a(Run(imp, 1000, 1));
+	std::vector<Delivery> b(Run(imp, 1000, 1));
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"same seed gave different number of packets",
+		a.size(), b.size()
+	);
+	for (std::size_t i = 0; i < a.size(); ++i) {
+		CPPUNIT_ASSERT_MESSAGE(
+			"same seed gave different deliveries",
+			a[i].index == b[i].index && a[i].received == b[i].received
+		);
+	}
+	std::vector<Delivery> c(Run(imp, 1000, 2));
+	bool differs = a.size() != c.size();
+	for (std::size_t i = 0; !differs && i < a.size(); ++i) {
+		differs = a[i].index != c[i].index || a[i].received != c[i].received;
+	}
+	CPPUNIT_ASSERT_MESSAGE(
+		"different seeds gave identical deliveries",
+		differs
+	);
+}
+
+}
+}
@@ -0,0 +1,53 @@
+#ifndef BLANK_TEST_NET_IMPAIRMENTTEST_HPP_
+#define BLANK_TEST_NET_IMPAIRMENTTEST_HPP_
+
+#include <cppunit/extensions/HelperMacros.h>
+
+
+namespace blank {
+namespace test {
+
+class ImpairmentTest
+: public CppUnit::TestFixture {
+
+CPPUNIT_TEST_SUITE(ImpairmentTest);
+
+CPPUNIT_TEST(testNone);
+CPPUNIT_TEST(testProfile);
+CPPUNIT_TEST(testOverride);
+CPPUNIT_TEST(testErrors);
+CPPUNIT_TEST(testPassThrough);
+CPPUNIT_TEST(testLatency);
+CPPUNIT_TEST(testJitter);
+CPPUNIT_TEST(testLoss);
+CPPUNIT_TEST(testDuplicate);
+CPPUNIT_TEST(testReorder);
+CPPUNIT_TEST(testBandwidth);
+CPPUNIT_TEST(testSeed);
+
+CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp();
+	void tearDown();
+
+	void testNone();
+	void testProfile();
+	void testOverride();
+	void testErrors();
+
+	void testPassThrough();
+	void testLatency();
+	void testJitter();
+	void testLoss();
+	void testDuplicate();
+	void testReorder();
+	void testBandwidth();
+	void testSeed();
+
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,188 @@
+#include "ReplayTest.hpp"
+
+#include "server/Replay.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <SDL_net.h>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(blank::test::ReplayTest);
+
+using namespace std;
+
+
+namespace blank {
+namespace test {
+
+using server::ReplayHeader;
+using server::ReplayReader;
+using server::ReplayWriter;
+
+namespace {
+
+UDPpacket MakePacket(Uint8 *data, int len, Uint32 host, Uint16 port) {
+	UDPpacket pack;
+	pack.channel = -1;
+	pack.data = data;
+	pack.len = len;
+	pack.maxlen = len;
+	pack.status = len;
+	pack.address.host = host;
+	pack.address.port = port;
+	return pack;
+}
+
+}
+
+void ReplayTest::setUp() {
+	test_dir.reset(new TempDir());
+}
+
+void ReplayTest::tearDown() {
+	test_dir.reset();
+}
+
+
+void ReplayTest::testRoundTrip() {
+	const string path = test_dir->Path() + "/round-trip.rec";
+	ReplayHeader header;
+	header.seed = 0x0123456789ABCDEF;
+	header.rng_seed = 42;
+	header.spawn = glm::ivec3(1, -2, 3);
+	header.interval = 20;
+	header.fresh_world = false;
+
+	Uint8 first[] = { 1, 2, 3, 4, 5 };
+	Uint8 second[] = { 6, 7, 8 };
+	{
+		ReplayWriter writer(path, header);
+		writer.Record(MakePacket(first, sizeof(first), 0x0100007F, 1234), 0);
+		writer.Record(MakePacket(second, sizeof(second), 0x0200007F, 4321), 7);
+		writer.EndTick(17, 20);
+		writer.EndTick(3, 0);
+	}
+
+	ReplayReader reader(path);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad seed in recording header",
+		header.seed, reader.Header().seed);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad random seed in recording header",
+		header.rng_seed, reader.Header().rng_seed);
+	CPPUNIT_ASSERT_MESSAGE(
+		"bad spawn in recording header",
+		header.spawn == reader.Header().spawn);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad interval in recording header",
+		header.interval, reader.Header().interval);
+	CPPUNIT_ASSERT_MESSAGE(
+		"bad fresh world flag in recording header",
+		!reader.Header().fresh_world);
+
+	ReplayReader::Tick tick;
+	CPPUNIT_ASSERT_MESSAGE(
+		"first tick missing from recording",
+		reader.Next(tick));
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad dt of first tick",
+		17, tick.dt);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad world dt of first tick",
+		20, tick.world_dt);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad number of packets in first tick",
+		size_t(2), tick.packets.size());
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad length of first packet",
+		int(sizeof(first)), tick.packets[0].len);
+	CPPUNIT_ASSERT_MESSAGE(
+		"bad data in first packet",
+		memcmp(first, tick.packets[0].data, sizeof(first)) == 0);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad host of first packet",
+		Uint32(0x0100007F), tick.packets[0].address.host);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad port of first packet",
+		Uint16(1234), tick.packets[0].address.port);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad length of second packet",
+		int(sizeof(second)), tick.packets[1].len);
+	CPPUNIT_ASSERT_MESSAGE(
+		"bad data in second packet",
+		memcmp(second, tick.packets[1].data, sizeof(second)) == 0);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad port of second packet",
+		Uint16(4321), tick.packets[1].address.port);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad number of packet delays in first tick",
+		size_t(2), tick.delays.size());
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad delay of first packet",
+		Uint32(0), tick.delays[0]);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad delay of second packet",
+		Uint32(7), tick.delays[1]);
+
+	CPPUNIT_ASSERT_MESSAGE(
+		"second tick missing from recording",
+		reader.Next(tick));
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad dt of second tick",
+		3, tick.dt);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad world dt of second tick",
+		0, tick.world_dt);
+	CPPUNIT_ASSERT_MESSAGE(
+		"second tick should be empty",
+		tick.packets.empty() && tick.delays.empty());
+
+	CPPUNIT_ASSERT_MESSAGE(
+		"recording should end after second tick",
+		!reader.Next(tick));
+}
+
+void ReplayTest::testTruncated() {
+	const string path = test_dir->Path() + "/truncated.rec";
+	Uint8 data[] = { 1, 2, 3, 4, 5 };
+	{
+		ReplayWriter writer(path, ReplayHeader());
+		writer.Record(MakePacket(data, sizeof(data), 0x0100007F, 1234), 1);
+		writer.EndTick(16, 16);
+		// as if the server died halfway through the next tick
+		writer.Record(MakePacket(data, sizeof(data), 0x0100007F, 1234), 1);
+	}
+
+	ReplayReader reader(path);
+	ReplayReader::Tick tick;
+	CPPUNIT_ASSERT_MESSAGE(
+		"complete tick missing from truncated recording",
+		reader.Next(tick));
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"bad number of packets in complete tick",
+		size_t(1), tick.packets.size());
+	CPPUNIT_ASSERT_MESSAGE(
+		"incomplete tick should not be replayed",
+		!reader.Next(tick));
+}
+
+void ReplayTest::testNotARecording() {
+	const string path = test_dir->Path() + "/not-a-recording";
+	{
+		ofstream out(path);
+		out << "definitely not a recording" << endl;
+	}
+	CPPUNIT_ASSERT_THROW_MESSAGE(
+		"reading something else as a recording should throw",
+		ReplayReader reader(path),
+		runtime_error);
+	CPPUNIT_ASSERT_THROW_MESSAGE(
+		"reading a missing recording should throw",
+		ReplayReader reader(test_dir->Path() + "/missing.rec"),
+		runtime_error);
+}
+
+}
+}
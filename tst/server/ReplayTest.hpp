@@ -0,0 +1,40 @@
+#ifndef BLANK_TEST_SERVER_REPLAYTEST_HPP_
+#define BLANK_TEST_SERVER_REPLAYTEST_HPP_
+
+#include "io/filesystem.hpp"
+
+#include <memory>
+#include <cppunit/extensions/HelperMacros.h>
+
+
+namespace blank {
+namespace test {
+
+class ReplayTest
+: public CppUnit::TestFixture {
+
+CPPUNIT_TEST_SUITE(ReplayTest);
+
+CPPUNIT_TEST(testRoundTrip);
+CPPUNIT_TEST(testTruncated);
+CPPUNIT_TEST(testNotARecording);
+
+CPPUNIT_TEST_SUITE_END();
+
+public:
+	void setUp();
+	void tearDown();
+
+	void testRoundTrip();
+	void testTruncated();
+	void testNotARecording();
+
+private:
+	std::unique_ptr<TempDir> test_dir;
+
+};
+
+}
+}
+
+#endif
@@ -1,9 +1,11 @@
 #include "ChunkTest.hpp"
 
+#include "io/TokenStreamReader.hpp"
 #include "world/BlockType.hpp"
 #include "world/Chunk.hpp"
 
 #include <memory>
+#include <sstream>
 
 CPPUNIT_TEST_SUITE_REGISTRATION(blank::test::ChunkTest);
 
@@ -28,6 +30,17 @@ void ChunkTest::setUp() {
 	source.luminosity = 5;
 	source.block_light = true;
 	types.Add(std::move(source));
+
+	std::stringstream ss;
+	ss << "{ fill = [ true, true, true, true, true, true ]; }";
+	TokenStreamReader in(ss);
+	cube.Read(in);
+
+	BlockType wall;
+	wall.name = "wall";
+	wall.visible = true;
+	wall.shape = &cube;
+	types.Add(std::move(wall));
 }
 
 void ChunkTest::tearDown() {
@@ -378,6 +391,25 @@ void ChunkTest::testLight() {
 			0, chunk->GetLight(index)
 		);
 	}
+	CPPUNIT_ASSERT_MESSAGE(
+		"changing light did not flag chunk's light for update",
+		chunk->ShouldUpdateLight()
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"changing light flagged chunk's mesh for update",
+		!chunk->ShouldUpdateMesh()
+	);
+	CPPUNIT_ASSERT_EQUAL_MESSAGE(
+		"light data does not match light level",
+		15, int(chunk->LightData()[0])
+	);
+
+	chunk->ClearLight();
+	chunk->InvalidateMesh();
+	CPPUNIT_ASSERT_MESSAGE(
+		"invalidating mesh did not flag light for update",
+		chunk->ShouldUpdateLight()
+	);
 }
 
 void ChunkTest::testLightPropagation() {
@@ -522,5 +554,54 @@ void ChunkTest::testLightPropagation() {
 	);
 }
 
+void ChunkTest::testConnectivity() {
+	unique_ptr<Chunk> chunk(new Chunk(types));
+	chunk->UpdateConnectivity();
+	for (int a = 0; a < Block::FACE_COUNT; ++a) {
+		for (int b = 0; b < Block::FACE_COUNT; ++b) {
+			CPPUNIT_ASSERT_MESSAGE(
+				"empty chunk should have all faces connected",
+				chunk->FacesConnected(Block::Face(a), Block::Face(b))
+			);
+		}
+	}
+
+	// 3 is opaque, wall off the chunk at x = 7
+	for (int z = 0; z < Chunk::side; ++z) {
+		for (int y = 0; y < Chunk::side; ++y) {
+			chunk->SetBlock(RoughLocation::Fine(7, y, z), Block(3));
+		}
+	}
+	chunk->UpdateConnectivity();
+	CPPUNIT_ASSERT_MESSAGE(
+		"wall should separate left and right face",
+		!chunk->FacesConnected(Block::FACE_LEFT, Block::FACE_RIGHT)
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"wall should separate right and left face",
+		!chunk->FacesConnected(Block::FACE_RIGHT, Block::FACE_LEFT)
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"top and bottom should be connected alongside the wall",
+		chunk->FacesConnected(Block::FACE_UP, Block::FACE_DOWN)
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"left face should connect to top",
+		chunk->FacesConnected(Block::FACE_LEFT, Block::FACE_UP)
+	);
+	CPPUNIT_ASSERT_MESSAGE(
+		"right face should connect to front",
+		chunk->FacesConnected(Block::FACE_RIGHT, Block::FACE_FRONT)
+	);
+
+	// punch a hole in it
+	chunk->SetBlock(RoughLocation::Fine(7, 7, 7), Block(0));
+	chunk->UpdateConnectivity();
+	CPPUNIT_ASSERT_MESSAGE(
+		"hole in wall should connect left and right face",
+		chunk->FacesConnected(Block::FACE_LEFT, Block::FACE_RIGHT)
+	);
+}
+
 }
 }
@@ -1,6 +1,7 @@
 #ifndef BLANK_TEST_WORLD_CHUNKTEST_H_
 #define BLANK_TEST_WORLD_CHUNKTEST_H_
 
+#include "model/Shape.hpp"
 #include "world/BlockTypeRegistry.hpp"
 
 #include <cppunit/extensions/HelperMacros.h>
@@ -22,6 +23,8 @@ CPPUNIT_TEST(testBlock);
 CPPUNIT_TEST(testLight);
 CPPUNIT_TEST(testLightPropagation);
 
+CPPUNIT_TEST(testConnectivity);
+
 CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -36,7 +39,10 @@ public:
 	void testLight();
 	void testLightPropagation();
 
+	void testConnectivity();
+
 private:
+	Shape cube;
 	BlockTypeRegistry types;
 
 };